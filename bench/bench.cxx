@@ -0,0 +1,284 @@
+/** @file bench.cxx
+    @brief Headless benchmarks of the main stages of plotter
+
+    bench datadir [baseline] [--save file]
+
+    Runs on the files made by generate, prints the throughput of each
+    benchmark and its ratio to the baseline (if given). With --save the
+    results are written in the baseline format.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <map>
+#include <vector>
+
+#include <TROOT.h>
+#include <TSystem.h>
+#include <TStyle.h>
+#include <TH1.h>
+#include <TTree.h>
+#include <TCanvas.h>
+#include <TRandom3.h>
+
+#include "catalog.h"
+#include "filepool.h"
+#include "treeloop.h"
+#include "ratio.h"
+#include "export.h"
+#include "workers.h"
+#include "common.h"
+
+struct Result {
+  TString name;
+  Double_t value;
+  TString unit;
+};
+
+static std::vector<Result> results;
+
+class Stopwatch {
+ public:
+  Stopwatch() : m_start(std::chrono::steady_clock::now()) {}
+  Double_t Seconds() {
+    return std::chrono::duration<Double_t>(std::chrono::steady_clock::now() - m_start).count();
+  }
+ private:
+  std::chrono::steady_clock::time_point m_start;
+};
+
+void add_result(TString name, Double_t count, Double_t seconds, TString unit)
+{
+  Result r;
+  r.name = name;
+  r.value = (seconds > 0) ? count/seconds : 0;
+  r.unit = unit;
+  results.push_back(r);
+  msg(Form("%-14s %12.4g %-10s (%.3g s)", name.Data(), r.value, unit.Data(), seconds));
+}
+
+/** Scan of all the directories, objects and branches of a file */
+void bench_scan(TString name, TString filename)
+{
+  FilePool::Instance()->CloseAll();
+
+  Catalog catalog(0, filename);
+  Stopwatch sw;
+  catalog.Scan();
+  add_result(name, catalog.GetN(), sw.Seconds(), "items/s");
+}
+
+/** Lookup of random paths, as done when a plot is restored */
+void bench_lookup(TString filename)
+{
+  Catalog catalog(0, filename);
+  std::vector<Item*> items = catalog.GetPlotableItems();
+  if(items.empty()) return;
+
+  std::vector<TString> paths;
+  for(unsigned int k=0; k<items.size(); k++) paths.push_back(items[k]->GetFullPath());
+
+  const unsigned int n = 1000000;
+  TRandom3 rng(4);
+  unsigned int found = 0;
+
+  Stopwatch sw;
+  for(unsigned int k=0; k<n; k++){
+    if(catalog.FindPath(paths[rng.Integer(paths.size())])) found++;
+  }
+  add_result("item_lookup", found, sw.Seconds(), "lookups/s");
+}
+
+/** Several draws of one tree filled in a single loop */
+void bench_fill(TString name, TString filename, TString treename, std::vector<TString> exprs, TString cut)
+{
+  TTree *tree = FilePool::Instance()->GetTree(filename, treename);
+  if(!tree) {
+    error("Cannot read tree " << treename << " from " << filename);
+    return;
+  }
+
+  TreeLoop loop(tree);
+  std::vector<TH1*> hists;
+  for(unsigned int k=0; k<exprs.size(); k++){
+    TH1 *h = loop.Add(exprs[k], (k%2) ? cut : TString(""), "100,-5,5");
+    if(h) hists.push_back(h);
+  }
+
+  Stopwatch sw;
+  Long64_t entries = loop.Run();
+  add_result(name, entries, sw.Seconds(), "entries/s");
+
+  for(unsigned int k=0; k<hists.size(); k++) delete hists[k];
+}
+
+/** Ratios of many histograms to a reference */
+void bench_ratio()
+{
+  const unsigned int n_hists = 100, n_bins = 1000, n_rep = 100;
+
+  TRandom3 rng(5);
+  TH1D ref("bench_ref", "", n_bins, 0, 1);
+  ref.SetDirectory(0);
+  std::vector<TH1*> hists;
+  for(unsigned int h=0; h<n_hists; h++){
+    TH1D *hist = new TH1D(Form("bench_h%u", h), "", n_bins, 0, 1);
+    hist->SetDirectory(0);
+    hists.push_back(hist);
+  }
+  for(unsigned int b=1; b<=n_bins; b++){
+    ref.SetBinContent(b, rng.Poisson(1000));
+    ref.SetBinError(b, std::sqrt(ref.GetBinContent(b)));
+    for(unsigned int h=0; h<n_hists; h++){
+      hists[h]->SetBinContent(b, rng.Poisson(1000));
+      hists[h]->SetBinError(b, std::sqrt(hists[h]->GetBinContent(b)));
+    }
+  }
+
+  Stopwatch sw;
+  for(unsigned int r=0; r<n_rep; r++){
+    std::vector<TH1*> ratios = compute_ratios(&ref, hists, (r%2) ? kDifference : kRatio);
+    for(unsigned int k=0; k<ratios.size(); k++) delete ratios[k];
+  }
+  add_result("ratio", (Double_t)n_hists*n_bins*n_rep, sw.Seconds(), "bins/s");
+
+  for(unsigned int h=0; h<n_hists; h++) delete hists[h];
+}
+
+/** Parallel export of canvases to png and a multi-page pdf */
+void bench_export(TString filename)
+{
+  Catalog catalog(0, filename);
+  std::vector<Item*> items = catalog.GetPlotableItems();
+
+  const unsigned int n = std::min<size_t>(48, items.size());
+  std::vector<TCanvas*> canvases;
+  std::vector<TObject*> objs;
+  for(unsigned int k=0; k<n; k++){
+    TCanvas *c = new TCanvas(Form("bench_c%u", k), "", 800, 600);
+    TObject *obj = catalog.GetObject(items[k]);
+    if(obj) obj->Draw();
+    canvases.push_back(c);
+    objs.push_back(obj);
+  }
+
+  TString dir = Form("%s/plotter_bench_%i", gSystem->TempDirectory(), gSystem->GetPid());
+
+  Exporter exporter(dir, "bench");
+  exporter.SetFormats("png,pdf");
+  for(unsigned int k=0; k<n; k++) exporter.Add(canvases[k], canvases[k]->GetName());
+
+  Stopwatch sw;
+  int failed = exporter.Export();
+  add_result("export", n, sw.Seconds(), "canvases/s");
+
+  if(failed) {
+    error(failed << " export workers failed");
+  }
+
+  gSystem->Exec(Form("rm -rf %s", dir.Data()));
+  for(unsigned int k=0; k<n; k++){
+    delete canvases[k];
+    delete objs[k];
+  }
+}
+
+/** Lines "name value unit" */
+std::map<TString, Double_t> read_baseline(TString filename)
+{
+  std::map<TString, Double_t> baseline;
+
+  std::ifstream in(filename.Data());
+  std::string line;
+  while(std::getline(in, line)){
+    if(line.empty() || line[0] == '#') continue;
+    std::istringstream ss(line);
+    std::string name;
+    Double_t value;
+    if(ss >> name >> value) baseline[name.c_str()] = value;
+  }
+  return baseline;
+}
+
+void write_results(TString filename)
+{
+  std::ofstream out(filename.Data());
+  out << "# plotter benchmark baseline (" << gSystem->HostName() << ", "
+      << number_of_cores() << " cores)" << std::endl;
+  for(unsigned int k=0; k<results.size(); k++)
+    out << results[k].name << " " << results[k].value << " " << results[k].unit << std::endl;
+  msg("Results saved in " << filename);
+}
+
+/** Compare with the baseline, higher is better */
+void compare(TString filename)
+{
+  std::map<TString, Double_t> baseline = read_baseline(filename);
+  if(baseline.empty()) {
+    msg("No baseline in " << filename << " (make bench-baseline to store one)");
+    return;
+  }
+
+  std::cout << std::endl << Form("%-14s %12s %12s %8s", "benchmark", "result", "baseline", "ratio") << std::endl;
+  for(unsigned int k=0; k<results.size(); k++){
+    std::map<TString, Double_t>::iterator it = baseline.find(results[k].name);
+    if(it == baseline.end() || it->second <= 0) {
+      std::cout << Form("%-14s %12.4g %12s %8s", results[k].name.Data(), results[k].value, "-", "-") << std::endl;
+      continue;
+    }
+    Double_t ratio = results[k].value/it->second;
+    std::cout << Form("%-14s %12.4g %12.4g %7.2fx%s", results[k].name.Data(), results[k].value,
+                      it->second, ratio, (ratio < 0.9) ? "  slower" : "") << std::endl;
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  TString dir, baseline, save;
+  for(int i=1; i<argc; i++){
+    TString arg = argv[i];
+    if(arg == "--save" && i+1 < argc) save = argv[++i];
+    else if(dir.IsNull()) dir = arg;
+    else baseline = arg;
+  }
+
+  if(dir.IsNull()) {
+    std::cout << "usage: bench datadir [baseline] [--save file]" << std::endl;
+    return 1;
+  }
+
+  gROOT->SetBatch(kTRUE);
+  gStyle->SetOptStat(0);
+
+  TString deep = dir + "/deep.root";
+  TString wide = dir + "/wide.root";
+  TString lng  = dir + "/long.root";
+
+  bench_scan("scan_deep", deep);
+  bench_scan("scan_wide", wide);
+  bench_lookup(deep);
+
+  std::vector<TString> long_exprs;
+  long_exprs.push_back("x");
+  long_exprs.push_back("x");
+  long_exprs.push_back("y*10-5");
+  long_exprs.push_back("log(w)");
+  bench_fill("fill_long", lng, "long", long_exprs, "w>0.5");
+
+  std::vector<TString> wide_exprs;
+  for(int b=0; b<2000; b+=20) wide_exprs.push_back(Form("b%04i", b));
+  bench_fill("fill_wide", wide, "wide", wide_exprs, "b0000>0");
+
+  bench_ratio();
+  bench_export(deep);
+
+  FilePool::Instance()->CloseAll();
+
+  if(!save.IsNull()) write_results(save);
+  else if(!baseline.IsNull()) compare(baseline);
+
+  return 0;
+}
@@ -0,0 +1,142 @@
+/** @file generate.cxx
+    @brief Synthetic datasets for the benchmarks
+
+    generate outdir [scale]
+
+    Always the same files for the same scale (fixed seeds):
+    - deep.root: 10x10x10 directories with 100 histograms each (100k)
+    - wide.root: tree "wide" with 2000 float branches, 10k entries
+    - long.root: tree "long" with 3 float branches, 100M entries
+    The number of histograms and entries is multiplied by scale.
+*/
+
+#include <cmath>
+#include <cstdlib>
+
+#include <TROOT.h>
+#include <TSystem.h>
+#include <TFile.h>
+#include <TDirectory.h>
+#include <TH1.h>
+#include <TTree.h>
+#include <TRandom3.h>
+
+#include "common.h"
+
+static Long64_t scaled(Long64_t n, Double_t scale)
+{
+  Long64_t s = (Long64_t)std::floor(n*scale + 0.5);
+  return (s > 0) ? s : 1;
+}
+
+void generate_deep(TString filename, Double_t scale)
+{
+  const int fanout = 10;
+  const Long64_t n_hists = scaled(100, scale);
+
+  TRandom3 rng(1);
+  TFile file(filename, "recreate");
+
+  for(int i=0; i<fanout; i++){
+    TDirectory *d1 = file.mkdir(Form("d%i", i));
+    for(int j=0; j<fanout; j++){
+      TDirectory *d2 = d1->mkdir(Form("d%i", j));
+      for(int k=0; k<fanout; k++){
+        TDirectory *d3 = d2->mkdir(Form("d%i", k));
+        for(Long64_t h=0; h<n_hists; h++){
+          // a gaussian peak with poisson fluctuations
+          TH1F hist(Form("h%03lld", h), "", 100, -5, 5);
+          hist.SetDirectory(0);
+          Double_t mean = rng.Uniform(-1, 1);
+          Double_t entries = 0;
+          for(int b=1; b<=100; b++){
+            Double_t x = hist.GetBinCenter(b) - mean;
+            Double_t n = rng.Poisson(100*std::exp(-0.5*x*x));
+            hist.SetBinContent(b, n);
+            entries += n;
+          }
+          hist.SetEntries(entries);
+          d3->WriteTObject(&hist);
+        }
+      }
+    }
+    msg("deep: " << (i+1)*fanout*fanout*n_hists << " histograms");
+  }
+
+  file.Close();
+}
+
+void generate_wide(TString filename, Double_t scale)
+{
+  const int n_branches = 2000;
+  const Long64_t n_entries = scaled(10000, scale);
+
+  TRandom3 rng(2);
+  TFile file(filename, "recreate");
+  TTree *tree = new TTree("wide", "wide");
+
+  Float_t *values = new Float_t[n_branches];
+  for(int b=0; b<n_branches; b++)
+    tree->Branch(Form("b%04i", b), &values[b], Form("b%04i/F", b));
+
+  for(Long64_t e=0; e<n_entries; e++){
+    for(int b=0; b<n_branches; b++) values[b] = rng.Gaus(b%10, 1);
+    tree->Fill();
+  }
+  msg("wide: " << n_entries << " entries");
+
+  tree->Write();
+  file.Close();
+  delete [] values;
+}
+
+void generate_long(TString filename, Double_t scale)
+{
+  const Long64_t n_entries = scaled(100000000, scale);
+
+  TRandom3 rng(3);
+  TFile file(filename, "recreate");
+  TTree *tree = new TTree("long", "long");
+
+  Float_t x, y, w;
+  tree->Branch("x", &x, "x/F");
+  tree->Branch("y", &y, "y/F");
+  tree->Branch("w", &w, "w/F");
+
+  for(Long64_t e=0; e<n_entries; e++){
+    x = rng.Gaus(0, 1);
+    y = rng.Uniform(0, 1);
+    w = rng.Exp(1);
+    tree->Fill();
+    if((e+1)%10000000 == 0) msg("long: " << e+1 << " entries");
+  }
+  msg("long: " << n_entries << " entries");
+
+  tree->Write();
+  file.Close();
+}
+
+int main(int argc, char *argv[])
+{
+  if(argc < 2) {
+    std::cout << "usage: generate outdir [scale]" << std::endl;
+    return 1;
+  }
+
+  TString dir = argv[1];
+  Double_t scale = (argc > 2) ? atof(argv[2]) : 1.;
+  if(scale <= 0) {
+    error("Invalid scale " << argv[2]);
+    return 1;
+  }
+
+  gROOT->SetBatch(kTRUE);
+  gSystem->mkdir(dir, kTRUE);
+
+  msg("Generating benchmark data in " << dir << " (scale " << scale << ")");
+  generate_deep(dir + "/deep.root", scale);
+  generate_wide(dir + "/wide.root", scale);
+  generate_long(dir + "/long.root", scale);
+
+  return 0;
+}
@@ -2,3 +2,16 @@
 #pragma link C++ class FileBox+;
 #pragma link C++ class Plotter;
 #pragma link C++ class Plotter+;
+#pragma link C++ class LodGraph+;
+#pragma link C++ class LodHist2D+;
+#pragma link C++ class LodHist3D+;
+#pragma link C++ class SliceView;
+#pragma link C++ class SliceView+;
+#pragma link C++ class DiffView;
+#pragma link C++ class DiffView+;
+#pragma link C++ class PageView;
+#pragma link C++ class PageView+;
+#pragma link C++ class StatsView;
+#pragma link C++ class StatsView+;
+#pragma link C++ class BranchView;
+#pragma link C++ class BranchView+;
@@ -0,0 +1,134 @@
+/** @file band.cxx
+    @brief Percentile bands of many histograms
+
+    The contents of all the histograms are gathered in one table with a
+    row for each bin, and each row is reduced in one pass: min/max with
+    a plain loop and the percentiles with successive partial selections
+    (nth_element) of a copy of the row, each one only over the values
+    left above the previous percentile.
+*/
+
+#include <cmath>
+#include <algorithm>
+
+#include <TArrayD.h>
+
+#include "common.h"
+#include "ratio.h"
+#include "band.h"
+
+static const Double_t percentiles[5] = { 0.025, 0.16, 0.5, 0.84, 0.975 };
+
+// histograms out of the 2.5-97.5% band in more than this fraction of bins
+static const Double_t outlier_fraction = 0.2;
+
+static TGraphAsymmErrors* create_band(TH1 *h, TString name)
+{
+  TGraphAsymmErrors *band = new TGraphAsymmErrors(h->GetNbinsX());
+  band->SetName(name);
+  band->SetTitle(Form("%s;%s;%s", h->GetTitle(), h->GetXaxis()->GetTitle(), h->GetYaxis()->GetTitle()));
+  return band;
+}
+
+PercentileBands compute_bands(std::vector<TH1*> hists, unsigned int max_outliers)
+{
+  PercentileBands bands;
+
+  std::vector<TH1*> valid;
+  std::vector<unsigned int> index;
+  for(unsigned int k=0; k<hists.size(); k++){
+    if(!hists[k]) continue;
+    if(!valid.empty() && hists[k]->GetNbinsX() != valid[0]->GetNbinsX()) {
+      error("Cannot add " << hists[k]->GetName() << " to the bands: different number of bins");
+      continue;
+    }
+    valid.push_back(hists[k]);
+    index.push_back(k);
+  }
+  if(valid.empty()) return bands;
+
+  const unsigned int n = valid.size();
+  const Int_t n_bins = valid[0]->GetNbinsX();
+
+  // one row of n values for each bin
+  std::vector<Double_t> table(n_bins*n);
+  for(unsigned int k=0; k<n; k++){
+    // profiles keep sums in their array: read their means
+    TArrayD *array = is_profile(valid[k]) ? 0 : dynamic_cast<TArrayD*>(valid[k]);
+    for(Int_t b=0; b<n_bins; b++){
+      table[b*n + k] = array ? array->GetArray()[b+1] : valid[k]->GetBinContent(b+1);
+    }
+  }
+
+  TH1 *ref = valid[0];
+  bands.outer = create_band(ref, Form("%s_band_minmax", ref->GetName()));
+  bands.wide  = create_band(ref, Form("%s_band_95", ref->GetName()));
+  bands.inner = create_band(ref, Form("%s_band_68", ref->GetName()));
+
+  std::vector<Int_t> ranks(5);
+  for(unsigned int p=0; p<5; p++) ranks[p] = Int_t(std::floor(percentiles[p]*(n-1) + 0.5));
+
+  std::vector<Double_t> row(n), median(n_bins);
+  std::vector<unsigned int> outside(n, 0);
+  Int_t used_bins = 0;
+
+  TAxis *axis = ref->GetXaxis();
+
+  for(Int_t b=0; b<n_bins; b++){
+    const Double_t *values = &table[b*n];
+
+    Double_t min = values[0], max = values[0];
+    for(unsigned int k=1; k<n; k++){
+      min = std::min(min, values[k]);
+      max = std::max(max, values[k]);
+    }
+
+    std::copy(values, values+n, row.begin());
+    Double_t q[5];
+    Int_t begin = 0;
+    for(unsigned int p=0; p<5; p++){
+      std::nth_element(row.begin()+begin, row.begin()+ranks[p], row.end());
+      q[p] = row[ranks[p]];
+      begin = ranks[p];
+    }
+
+    Double_t x = axis->GetBinCenter(b+1);
+    Double_t ex = 0.5*axis->GetBinWidth(b+1);
+
+    bands.outer->SetPoint(b, x, q[2]);
+    bands.outer->SetPointError(b, ex, ex, q[2]-min, max-q[2]);
+    bands.wide->SetPoint(b, x, q[2]);
+    bands.wide->SetPointError(b, ex, ex, q[2]-q[0], q[4]-q[2]);
+    bands.inner->SetPoint(b, x, q[2]);
+    bands.inner->SetPointError(b, ex, ex, q[2]-q[1], q[3]-q[2]);
+
+    median[b] = q[2];
+
+    if(max > min) {
+      used_bins++;
+      for(unsigned int k=0; k<n; k++){
+        outside[k] += (values[k] < q[0] || values[k] > q[4]);
+      }
+    }
+  }
+
+  TString name = Form("%s_median", ref->GetName());
+  if(axis->GetXbins()->GetSize() > 0)
+    bands.median = new TH1D(name, ref->GetTitle(), n_bins, axis->GetXbins()->GetArray());
+  else
+    bands.median = new TH1D(name, ref->GetTitle(), n_bins, axis->GetXmin(), axis->GetXmax());
+  bands.median->SetDirectory(0);
+  for(Int_t b=0; b<n_bins; b++) bands.median->SetBinContent(b+1, median[b]);
+
+  // the histograms most often out of the band
+  std::vector<std::pair<unsigned int, unsigned int> > counts;
+  for(unsigned int k=0; k<n; k++){
+    if(outside[k] > outlier_fraction*used_bins) counts.push_back(std::make_pair(outside[k], k));
+  }
+  std::sort(counts.rbegin(), counts.rend());
+  for(unsigned int k=0; k<counts.size() && k<max_outliers; k++){
+    bands.outliers.push_back(index[counts[k].second]);
+  }
+
+  return bands;
+}
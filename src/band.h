@@ -0,0 +1,29 @@
+/** @file band.h
+    @brief Percentile bands of many histograms
+*/
+
+#ifndef BAND_H
+#define BAND_H
+
+#include <vector>
+
+#include <TROOT.h>
+#include <TH1.h>
+#include <TGraphAsymmErrors.h>
+
+/** Per bin envelopes of a set of histograms: min/max, 2.5-97.5% and
+    16-84% bands (as graphs to be drawn filled), the median, and the
+    histograms that are out of the 2.5-97.5% band most often */
+struct PercentileBands {
+  TGraphAsymmErrors *outer;  // min-max
+  TGraphAsymmErrors *wide;   // 2.5-97.5%
+  TGraphAsymmErrors *inner;  // 16-84%
+  TH1D *median;
+  std::vector<unsigned int> outliers; // indices in the input histograms
+
+  PercentileBands() : outer(0), wide(0), inner(0), median(0) { }
+};
+
+PercentileBands compute_bands(std::vector<TH1*> hists, unsigned int max_outliers=5);
+
+#endif
@@ -0,0 +1,471 @@
+/** @file batch.cxx
+    @brief Batch class implementation
+*/
+
+#include <algorithm>
+#include <map>
+#include <set>
+
+#include <TSystem.h>
+#include <TObjArray.h>
+#include <TObjString.h>
+#include <TH1.h>
+#include <TGraph.h>
+
+#include "common.h"
+#include "catalog.h"
+#include "filepool.h"
+#include "obj.h"
+#include "plot.h"
+#include "plotspec.h"
+#include "treeloop.h"
+#include "workers.h"
+#include "objcache.h"
+#include "resultcache.h"
+#include "batch.h"
+
+#include "config.h"
+
+// plots whose histograms/graphs are loaded at once by a worker
+static const unsigned int max_loaded_plots = 100;
+
+static bool by_key(const std::pair<TString, PlotSpec*> &a, const std::pair<TString, PlotSpec*> &b)
+{
+  return a.first < b.first;
+}
+
+static bool by_size(const std::pair<unsigned int, unsigned int> &a, const std::pair<unsigned int, unsigned int> &b)
+{
+  return a.first > b.first;
+}
+
+static unsigned int find_root(std::vector<unsigned int> &parent, unsigned int i)
+{
+  while(parent[i] != i) {
+    parent[i] = parent[parent[i]];
+    i = parent[i];
+  }
+  return i;
+}
+
+Batch::Batch() :
+  m_output_dir("."),
+  m_jobs(number_of_cores()),
+  m_cache(0),
+  include_ratio(false),
+  do_logy(false)
+{
+  m_formats.push_back("png");
+}
+
+Batch::~Batch()
+{
+  for(unsigned int i=0; i<m_specs.size(); i++) delete m_specs[i];
+}
+
+/** One plot for each histogram/graph of the first file, with the same
+    object from all the files */
+void Batch::AddComparison(std::vector<TString> files)
+{
+  if(files.empty()) return;
+
+  std::vector<Catalog*> catalogs;
+  for(unsigned int i=0; i<files.size(); i++){
+    catalogs.push_back(new Catalog(i, files[i]));
+  }
+
+  std::vector<Item*> items = catalogs[0]->GetPlotableItems();
+  for(unsigned int k=0; k<items.size(); k++){
+    TString path = items[k]->GetFullPath();
+
+    PlotSpec *spec = new PlotSpec(path);
+    for(unsigned int i=0; i<catalogs.size(); i++){
+      if(!catalogs[i]->FindPath(path)) continue;
+      SpecItem *item = new SpecItem();
+      item->file = files[i];
+      item->path = path;
+      item->colour = -1;
+      item->fill = false;
+      item->obj = 0;
+      spec->items.push_back(item);
+    }
+    m_specs.push_back(spec);
+  }
+
+  for(unsigned int i=0; i<catalogs.size(); i++) delete catalogs[i];
+}
+
+/** Add the plots of a specification file */
+bool Batch::AddSpecs(TString filename)
+{
+  std::vector<PlotSpec*> specs = read_plot_specs(filename);
+  m_specs.insert(m_specs.end(), specs.begin(), specs.end());
+  return !specs.empty();
+}
+
+/** Add plot specifications (owned by the batch) */
+void Batch::AddSpecs(std::vector<PlotSpec*> specs)
+{
+  m_specs.insert(m_specs.end(), specs.begin(), specs.end());
+}
+
+/** Comma separated list of formats: png,pdf,svg,eps,... */
+void Batch::SetFormats(TString formats)
+{
+  m_formats.clear();
+
+  TObjArray *tokens = formats.Tokenize(",");
+  for(Int_t k=0; k<tokens->GetEntriesFast(); k++){
+    TString format = ((TObjString*)tokens->At(k))->GetString();
+    format.ToLower();
+    if(!format.IsNull()) m_formats.push_back(format);
+  }
+  delete tokens;
+}
+
+/** Make all the plots. Returns 0 if every plot was made */
+int Batch::Run()
+{
+  if(m_specs.empty()) {
+    error("There is nothing to plot");
+    return 1;
+  }
+
+  for(unsigned int k=0; k<m_specs.size(); k++){
+    if(include_ratio) m_specs[k]->ratio = true;
+    if(do_logy) m_specs[k]->logy = true;
+  }
+
+  SortByFiles();
+  MakeGroups();
+
+  // the cache must be filled in this process
+  if(m_cache) {
+    Load(m_specs, true);
+    Load(m_specs, false);
+  }
+
+  gSystem->mkdir(m_output_dir, kTRUE);
+
+  unsigned int n_workers = std::min(m_jobs, (unsigned int)m_groups.size());
+  AssignGroups(n_workers);
+
+  msg("Plotting " << m_specs.size() << " plots in " << m_groups.size() << " groups with " << n_workers << " workers");
+
+  // workers can't share the open files (with the cache they don't read
+  // them, and the files are kept open for the next run)
+  if(n_workers > 1 && !m_cache) FilePool::Instance()->CloseAll();
+
+  int failed = fork_workers(n_workers, RunWorker, this);
+  if(failed) {
+    error("Some plots could not be made (" << failed << " of " << n_workers << " workers failed)");
+    return 1;
+  }
+
+  msg("Plots saved in " << m_output_dir);
+  return 0;
+}
+
+/** Plots reading the same files next to each other, so the groups
+    of plots without tree draws open as few files as possible */
+void Batch::SortByFiles()
+{
+  std::vector<std::pair<TString, PlotSpec*> > keyed;
+  for(unsigned int i=0; i<m_specs.size(); i++){
+    std::set<TString> files;
+    for(unsigned int k=0; k<m_specs[i]->items.size(); k++)
+      files.insert(m_specs[i]->items[k]->file + ":" + m_specs[i]->items[k]->tree);
+
+    TString key = "";
+    for(std::set<TString>::iterator it = files.begin(); it != files.end(); ++it) key += *it + "|";
+    keyed.push_back(std::make_pair(key, m_specs[i]));
+  }
+
+  std::stable_sort(keyed.begin(), keyed.end(), by_key);
+
+  for(unsigned int i=0; i<keyed.size(); i++) m_specs[i] = keyed[i].second;
+}
+
+/** Group the plots: the plots drawing from the same file and tree
+    (directly or through other plots) are in the same group, so the tree
+    is looped only once. The plots without tree draws are grouped by
+    files, max_loaded_plots at a time */
+void Batch::MakeGroups()
+{
+  m_groups.clear();
+
+  std::vector<unsigned int> parent(m_specs.size());
+  for(unsigned int i=0; i<m_specs.size(); i++) parent[i] = i;
+
+  std::map<TString, unsigned int> owner;
+  for(unsigned int i=0; i<m_specs.size(); i++){
+    for(unsigned int k=0; k<m_specs[i]->items.size(); k++){
+      SpecItem *item = m_specs[i]->items[k];
+      if(!item->IsTreeDraw()) continue;
+
+      TString key = item->file + ":" + item->tree;
+      if(owner.count(key)) parent[find_root(parent, i)] = find_root(parent, owner[key]);
+      else owner[key] = i;
+    }
+  }
+
+  std::map<unsigned int, unsigned int> tree_group;
+  int plain_group = -1;
+  for(unsigned int i=0; i<m_specs.size(); i++){
+    bool has_tree = false;
+    for(unsigned int k=0; k<m_specs[i]->items.size(); k++){
+      if(m_specs[i]->items[k]->IsTreeDraw()) has_tree = true;
+    }
+
+    if(has_tree) {
+      unsigned int root = find_root(parent, i);
+      if(!tree_group.count(root)) {
+        tree_group[root] = m_groups.size();
+        m_groups.push_back(std::vector<PlotSpec*>());
+      }
+      m_groups[tree_group[root]].push_back(m_specs[i]);
+    }
+    else {
+      if(plain_group < 0 || m_groups[plain_group].size() >= max_loaded_plots) {
+        plain_group = m_groups.size();
+        m_groups.push_back(std::vector<PlotSpec*>());
+      }
+      m_groups[plain_group].push_back(m_specs[i]);
+    }
+  }
+}
+
+/** Whole groups to each worker: the biggest groups first, each one to
+    the worker with fewer plots */
+void Batch::AssignGroups(unsigned int n_workers)
+{
+  std::vector<std::pair<unsigned int, unsigned int> > sizes;
+  for(unsigned int g=0; g<m_groups.size(); g++) sizes.push_back(std::make_pair(m_groups[g].size(), g));
+  std::stable_sort(sizes.begin(), sizes.end(), by_size);
+
+  m_group_worker.assign(m_groups.size(), 0);
+  std::vector<unsigned int> load(n_workers, 0);
+  for(unsigned int k=0; k<sizes.size(); k++){
+    unsigned int worker = std::min_element(load.begin(), load.end()) - load.begin();
+    m_group_worker[sizes[k].second] = worker;
+    load[worker] += sizes[k].first;
+  }
+}
+
+/** Load the tree draws, or the histograms/graphs, of some plots. The
+    items are grouped by file, so each file is opened only once */
+void Batch::Load(const std::vector<PlotSpec*> &specs, bool tree_draws)
+{
+  std::map<TString, std::vector<SpecItem*> > by_file;
+  for(unsigned int i=0; i<specs.size(); i++){
+    for(unsigned int k=0; k<specs[i]->items.size(); k++){
+      SpecItem *item = specs[i]->items[k];
+      if(item->IsTreeDraw() != tree_draws) continue;
+      by_file[item->file].push_back(item);
+    }
+  }
+
+  std::map<TString, std::vector<SpecItem*> >::iterator it;
+  for(it = by_file.begin(); it != by_file.end(); ++it){
+    LoadFile(it->first, it->second);
+  }
+}
+
+static TObject* clone_object(TObject *obj)
+{
+  if(!obj) return 0;
+  TObject *copy = obj->Clone();
+  if(copy->InheritsFrom("TH1")) ((TH1*)copy)->SetDirectory(0);
+  return copy;
+}
+
+/** Load the objects of the items of one file. Objects used by several
+    plots are read once, and all the draws from the same tree are filled
+    in a single loop over the tree */
+void Batch::LoadFile(TString filename, std::vector<SpecItem*> &items)
+{
+  FilePool *pool = FilePool::Instance();
+  ResultCache *results = ResultCache::Instance();
+
+  std::map<TString, SpecItem*> first;
+  std::vector<std::pair<SpecItem*, SpecItem*> > copies;
+  std::map<TString, TTree*> trees;
+  std::map<TString, TreeLoop*> loops;
+  std::vector<std::pair<TString, SpecItem*> > filled;
+  std::vector<std::pair<TString, SpecItem*> > loaded;
+  bool file_open = false;
+  bool cannot_open = false;
+
+  for(unsigned int k=0; k<items.size(); k++){
+    SpecItem *item = items[k];
+
+    TString key = item->IsTreeDraw() ?
+      item->tree + "|" + item->expr + "|" + item->cut + "|" + item->binning : item->path;
+
+    if(first.count(key)) {
+      copies.push_back(std::make_pair(item, first[key]));
+      continue;
+    }
+    first[key] = item;
+
+    if(m_cache) {
+      item->obj = m_cache->Get(filename + "|" + key);
+      if(item->obj) continue;
+      loaded.push_back(std::make_pair(filename + "|" + key, item));
+    }
+
+    // the file is only opened when something is not in the cache
+    if(!file_open) {
+      if(cannot_open || !pool->Get(filename)) {
+        cannot_open = true;
+        continue;
+      }
+      file_open = true;
+    }
+
+    if(item->IsTreeDraw()) {
+      if(!trees.count(item->tree)) {
+        trees[item->tree] = pool->GetTree(filename, item->tree);
+        if(!trees[item->tree]) error("Cannot read tree " << item->tree << " from " << filename);
+      }
+      TTree *tree = trees[item->tree];
+      if(!tree) continue;
+
+      // filled in a previous session
+      TString result_key = results->Key(tree, item->expr, item->cut, item->binning);
+      item->obj = results->Get(result_key);
+      if(item->obj) continue;
+
+      if(!loops.count(item->tree)) loops[item->tree] = new TreeLoop(tree);
+      item->obj = loops[item->tree]->Add(item->expr, item->cut, item->binning);
+      filled.push_back(std::make_pair(result_key, item));
+    }
+    else {
+      TString dir = "";
+      TString name = item->path;
+      Int_t slash = item->path.Last('/');
+      if(slash >= 0) {
+        dir = item->path(0, slash);
+        name = item->path(slash+1, item->path.Length());
+      }
+      item->obj = pool->ReadObject(filename, dir, name);
+      if(!item->obj) error("Cannot read " << item->path << " from " << filename);
+    }
+  }
+
+  std::map<TString, TreeLoop*>::iterator it;
+  for(it = loops.begin(); it != loops.end(); ++it){
+    if(!it->second) continue;
+    msg("Looping over " << filename << ":" << it->first << " for " << it->second->GetN() << " draws");
+    it->second->Run();
+    delete it->second;
+  }
+
+  for(unsigned int k=0; k<filled.size(); k++){
+    results->Put(filled[k].first, (TH1*)filled[k].second->obj);
+  }
+
+  for(unsigned int k=0; k<copies.size(); k++){
+    copies[k].first->obj = clone_object(copies[k].second->obj);
+  }
+
+  if(m_cache) {
+    for(unsigned int k=0; k<loaded.size(); k++) m_cache->Put(loaded[k].first, loaded[k].second->obj);
+  }
+}
+
+/** Each worker makes its groups of plots: all the tree draws of a group
+    are filled first (one loop over each tree), then the histograms/graphs
+    are loaded in chunks, so only a chunk of them is in memory at once.
+    Fails if some plot could not be made */
+bool Batch::RunWorker(unsigned int worker, unsigned int, void *data)
+{
+  Batch *batch = (Batch*)data;
+
+  unsigned int failed = 0;
+  for(unsigned int g=0; g<batch->m_groups.size(); g++){
+    if(batch->m_group_worker[g] != worker) continue;
+    std::vector<PlotSpec*> &group = batch->m_groups[g];
+
+    if(!batch->m_cache) batch->Load(group, true);
+
+    for(unsigned int first=0; first<group.size(); first+=max_loaded_plots){
+      unsigned int last = std::min(first+max_loaded_plots, (unsigned int)group.size());
+      std::vector<PlotSpec*> chunk(group.begin()+first, group.begin()+last);
+
+      if(!batch->m_cache) batch->Load(chunk, false);
+
+      for(unsigned int k=0; k<chunk.size(); k++){
+        if(batch->DrawSpec(chunk[k])) continue;
+        error("Cannot make the plot " << chunk[k]->name << ": none of its objects could be loaded");
+        failed++;
+      }
+    }
+
+    if(!batch->m_cache) FilePool::Instance()->CloseAll();
+  }
+
+  if(failed) {
+    error(failed << " plots failed in worker " << worker);
+  }
+  return failed == 0;
+}
+
+/** Output file name (without extension) for a plot name */
+TString Batch::GetOutputName(TString name)
+{
+  name.ReplaceAll("/", "_");
+  name.ReplaceAll(" ", "_");
+  return m_output_dir + "/" + name;
+}
+
+/** Create and save the plot of a specification. The objects are owned
+    by the plot */
+bool Batch::DrawSpec(PlotSpec *spec)
+{
+  Plot *p = new Plot();
+
+  p->SetLogX(spec->logx);
+  p->SetLogY(spec->logy);
+  p->SetRebin(spec->rebin);
+  p->SetNormalise(spec->normalise);
+  p->SetNormaliseToFirst(spec->normalise_to_first);
+  p->SetShowStats(spec->stats);
+  p->SetDrawOptions(spec->draw_options);
+
+  unsigned int n_objs = 0;
+  for(unsigned int k=0; k<spec->items.size(); k++){
+    SpecItem *item = spec->items[k];
+    if(!item->obj) continue;
+
+    Color_t colour = (item->colour >= 0) ? item->colour : default_colours[n_objs%20];
+
+    if(item->obj->InheritsFrom("TGraph"))
+      p->Add(new Obj((TGraph*)item->obj), colour, item->fill);
+    else
+      p->Add(new Obj((TH1*)item->obj), colour, item->fill);
+
+    item->obj = 0;
+    n_objs++;
+  }
+
+  if(n_objs == 0) {
+    delete p;
+    return false;
+  }
+
+  if(spec->ratio && n_objs > 1) p->SetIncludeRatio(true);
+  else if(spec->diff && n_objs > 1) p->SetIncludeDiff(true);
+  if(spec->efficiency >= 0) p->SetEfficiency(true, (EffInterval)spec->efficiency);
+  if(spec->bands) p->SetBands(true);
+
+  p->Create();
+
+  TString name = GetOutputName(spec->name);
+  for(unsigned int k=0; k<m_formats.size(); k++){
+    p->SaveAs(name + "." + m_formats[k]);
+  }
+
+  delete p;
+  return true;
+}
@@ -0,0 +1,73 @@
+/** @file batch.h
+    @brief Header file for the batch mode
+*/
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <vector>
+
+#include <TROOT.h>
+#include <TString.h>
+
+struct PlotSpec;
+struct SpecItem;
+class ObjectCache;
+
+/** Batch mode: plots without gui.
+
+    The plots are given by plot specifications: read from a file, or
+    built from the input files (for each histogram/graph of the first
+    file, the same object of all the files). The plots drawing from the
+    same file and tree are grouped, and whole groups are given to the
+    worker processes. A worker fills all the tree draws of a group in a
+    single loop over each tree, then reads the histograms/graphs of the
+    group in chunks. The plots are rendered (with the same styling as
+    the gui), saved in the requested formats and freed.
+
+    With an object cache (in the daemon), all the objects are loaded
+    before forking, so the cache keeps them, and the objects and tree
+    draws already loaded by a previous run are taken from it.
+*/
+class Batch {
+
+ public:
+  Batch();
+  ~Batch();
+
+  void AddComparison(std::vector<TString> files);
+  bool AddSpecs(TString filename);
+  void AddSpecs(std::vector<PlotSpec*> specs);
+
+  void SetOutputDir(TString dir) { m_output_dir = dir; }
+  void SetFormats(TString);
+  void SetJobs(unsigned int n) { m_jobs = (n > 0) ? n : 1; }
+  void SetIncludeRatio(bool set) { include_ratio = set; }
+  void SetLogY(bool set) { do_logy = set; }
+  void SetCache(ObjectCache *cache) { m_cache = cache; }
+
+  int Run();
+
+ private:
+  void SortByFiles();
+  void MakeGroups();
+  void AssignGroups(unsigned int n_workers);
+  void Load(const std::vector<PlotSpec*>&, bool tree_draws);
+  void LoadFile(TString, std::vector<SpecItem*>&);
+  static bool RunWorker(unsigned int, unsigned int, void*);
+  bool DrawSpec(PlotSpec*);
+  TString GetOutputName(TString);
+
+  std::vector<PlotSpec*> m_specs;
+  std::vector<std::vector<PlotSpec*> > m_groups; // plots made by the same worker
+  std::vector<unsigned int> m_group_worker;
+  std::vector<TString> m_formats;
+  TString m_output_dir;
+  unsigned int m_jobs;
+  ObjectCache *m_cache; // objects kept between runs (daemon), the files are kept open too
+
+  bool include_ratio;
+  bool do_logy;
+};
+
+#endif
@@ -0,0 +1,131 @@
+/** @file branchview.cxx
+    @brief BranchView class implementation
+*/
+
+#include <algorithm>
+
+#include <TGLayout.h>
+#include <TGButton.h>
+
+#include "item.h"
+#include "catalog.h"
+#include "stats.h"
+#include "branchview.h"
+#include "common.h"
+
+ClassImp(BranchView)
+
+static const char *column_names[kNBranchColumns] = {
+  "Branch", "Entries", "Compressed", "Uncompressed", "Ratio", "Baskets", "Basket size"
+};
+
+/** Most expensive first, except for the names */
+class BranchOrder {
+ public:
+  BranchOrder(Int_t column) : m_column(column) {}
+
+  bool operator()(BranchItem *a, BranchItem *b) const {
+    switch(m_column){
+    case kBranchColName:
+      return a->GetName() < b->GetName();
+    case kBranchColEntries:
+      if(a->GetEntries() != b->GetEntries()) return a->GetEntries() > b->GetEntries();
+      break;
+    case kBranchColTot:
+      if(a->GetTotBytes() != b->GetTotBytes()) return a->GetTotBytes() > b->GetTotBytes();
+      break;
+    case kBranchColRatio:
+      if(a->GetCompression() != b->GetCompression()) return a->GetCompression() > b->GetCompression();
+      break;
+    case kBranchColBaskets:
+      if(a->GetBaskets() != b->GetBaskets()) return a->GetBaskets() > b->GetBaskets();
+      break;
+    case kBranchColBasketSize:
+      if(a->GetBasketSize() != b->GetBasketSize()) return a->GetBasketSize() > b->GetBasketSize();
+      break;
+    }
+    return a->GetZipBytes() > b->GetZipBytes();
+  }
+
+ private:
+  Int_t m_column;
+};
+
+BranchView::BranchView(const TGWindow *p, Catalog *catalog, TString tree) :
+  TGMainFrame(p, 800, 600),
+  m_tree(tree),
+  m_sort(kBranchColZip)
+{
+  SetCleanup(kDeepCleanup);
+
+  for(unsigned int k=0; k<catalog->GetN(); k++){
+    BranchItem *it = dynamic_cast<BranchItem*>(catalog->GetItem(k));
+    if(it && it->GetPath() == tree) m_branches.push_back(it);
+  }
+
+  label_total = new TGLabel(this, "");
+  label_total->SetTextJustify(kTextLeft);
+  AddFrame(label_total, new TGLayoutHints(kLHintsExpandX, 4, 4, 4, 2));
+
+  list_view = new TGListView(this, 800, 560);
+  list_container = new TGLVContainer(list_view, kSunkenFrame, GetWhitePixel());
+  list_view->SetViewMode(kLVDetails);
+  list_view->SetHeaders(kNBranchColumns);
+  for(Int_t k=0; k<kNBranchColumns; k++){
+    list_view->SetHeader(column_names[k], (k == 0) ? kTextLeft : kTextRight, (k == 0) ? kTextLeft : kTextRight, k);
+  }
+
+  // sort by the column of the header clicked
+  TGTextButton **headers = list_view->GetHeaderButtons();
+  for(Int_t k=0; k<kNBranchColumns; k++){
+    headers[k]->Connect("Clicked()", "BranchView", this, Form("SortBy(=%i)", k));
+  }
+
+  AddFrame(list_view, new TGLayoutHints(kLHintsExpandX | kLHintsExpandY, 2, 2, 2, 2));
+
+  SetWindowName(Form("Branches of %s (%s)", tree.Data(), catalog->GetShortName().Data()));
+  MapSubwindows();
+  Resize(GetDefaultSize());
+  MapWindow();
+
+  ShowBranches();
+}
+
+BranchView::~BranchView()
+{
+  Cleanup();
+}
+
+void BranchView::SortBy(Int_t column)
+{
+  m_sort = column;
+  ShowBranches();
+}
+
+void BranchView::ShowBranches()
+{
+  std::sort(m_branches.begin(), m_branches.end(), BranchOrder(m_sort));
+
+  list_container->RemoveAll();
+
+  Long64_t tot = 0, zip = 0;
+  for(unsigned int k=0; k<m_branches.size(); k++){
+    BranchItem *b = m_branches[k];
+    tot += b->GetTotBytes();
+    zip += b->GetZipBytes();
+
+    TGLVEntry *entry = new TGLVEntry(list_container, b->GetName(), "TBranch");
+    entry->SetSubnames(Form("%lld", b->GetEntries()), format_bytes(b->GetZipBytes()),
+                       format_bytes(b->GetTotBytes()), Form("%.2f", b->GetCompression()),
+                       Form("%i", b->GetBaskets()), format_bytes(b->GetBasketSize()));
+    entry->SetBackgroundColor(b->GetHeatColor());
+    list_container->AddItem(entry);
+  }
+
+  label_total->SetText(Form("%u branches: %s on disk, %s uncompressed. Sorted by %s",
+                            (unsigned int)m_branches.size(), format_bytes(zip).Data(),
+                            format_bytes(tot).Data(), column_names[m_sort]));
+
+  list_view->Layout();
+  Layout();
+}
@@ -0,0 +1,61 @@
+/** @file branchview.h
+    @brief Window with the I/O cost of the branches of a tree
+*/
+
+#ifndef BRANCHVIEW_H
+#define BRANCHVIEW_H
+
+#include <vector>
+
+#include <TROOT.h>
+#include <TGFrame.h>
+#include <TGLabel.h>
+#include <TGListView.h>
+
+class Catalog;
+class BranchItem;
+
+enum BranchColumn {
+  kBranchColName,
+  kBranchColEntries,
+  kBranchColZip,
+  kBranchColTot,
+  kBranchColRatio,
+  kBranchColBaskets,
+  kBranchColBasketSize,
+  kNBranchColumns
+};
+
+/** Sizes on disk and in memory, compression and baskets of each branch
+    of a tree, from the metadata read when the file was scanned. The
+    rows are coloured by their size on disk, and clicking on a column
+    header sorts by it (largest first).
+
+    The window is deleted when it's closed.
+*/
+class BranchView : public TGMainFrame {
+
+ public:
+  BranchView(const TGWindow *p, Catalog *catalog, TString tree);
+  virtual ~BranchView();
+
+  virtual void CloseWindow() { DeleteWindow(); }
+
+  // Slots
+  void SortBy(Int_t);
+
+ private:
+  void ShowBranches();
+
+  TString m_tree;
+  std::vector<BranchItem*> m_branches;
+  Int_t m_sort;
+
+  TGListView *list_view;
+  TGLVContainer *list_container;
+  TGLabel *label_total;
+
+  ClassDef(BranchView, 0);
+};
+
+#endif
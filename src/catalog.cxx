@@ -0,0 +1,331 @@
+/** @file catalog.cxx
+    @brief Catalog class implementation
+*/
+
+#include <algorithm>
+
+#include <TClass.h>
+#include <TKey.h>
+#include <TFile.h>
+#include <TRegexp.h>
+#include <TTree.h>
+#include <TBranch.h>
+
+#include "common.h"
+#include "filepool.h"
+#include "catalog.h"
+#include "stats.h"
+#include "daemon.h"
+
+TString Catalog::m_daemon = "";
+
+Catalog::Catalog(Int_t index, TString filename) :
+  m_index(index),
+  m_filename(filename),
+  m_scanned(false)
+{
+  m_root = new ParentItem(m_index, 0, "", "", Dir);
+}
+
+Catalog::~Catalog()
+{
+  FilePool::Instance()->Close(m_filename);
+  delete m_root;
+}
+
+/** File name without directory and extension */
+TString Catalog::GetShortName()
+{
+  TString name = m_filename;
+  name.ReplaceAll(".root","");
+  while(name.Contains("/")){
+    name = name(name.Index("/")+1, name.Length());
+  }
+  return name;
+}
+
+/** Open the file and build the catalog. Only done the first time */
+void Catalog::Scan()
+{
+  if(m_scanned) return;
+  m_scanned = true;
+
+  ScopedTimer timer(kStageScan, m_filename);
+
+  if(!m_daemon.IsNull() && ScanFromDaemon()) return;
+
+  TFile *file = FilePool::Instance()->Get(m_filename);
+  if(file) BrowseDir(file, m_root, "");
+}
+
+/** Tab separated fields, keeping the empty ones */
+static std::vector<TString> split_tabs(TString line)
+{
+  std::vector<TString> fields;
+  Ssiz_t start = 0;
+  while(true){
+    Ssiz_t tab = line.Index("\t", start);
+    if(tab < 0) {
+      fields.push_back(line(start, line.Length()-start));
+      break;
+    }
+    fields.push_back(line(start, tab-start));
+    start = tab+1;
+  }
+  return fields;
+}
+
+/** One line per item, in the order of the entries: type, path, name and
+    title, and the sizes and heat of the branches */
+TString Catalog::GetListing()
+{
+  Scan();
+
+  TString listing = "";
+  for(unsigned int k=0; k<m_items.size(); k++){
+    Item *it = m_items[k];
+    listing += Form("%i\t%s\t%s\t%s", (int)it->GetType(), it->GetPath().Data(),
+                    it->GetName().Data(), it->GetTitle().Data());
+    BranchItem *b = dynamic_cast<BranchItem*>(it);
+    if(b) {
+      listing += Form("\t%lld\t%lld\t%lld\t%i\t%g", b->GetEntries(), b->GetTotBytes(),
+                      b->GetZipBytes(), b->GetBaskets(), b->GetHeat());
+    }
+    listing += "\n";
+  }
+  return listing;
+}
+
+/** Items of the file as scanned by the daemon */
+bool Catalog::ScanFromDaemon()
+{
+  DaemonClient client(m_daemon);
+  TString listing;
+  if(!client.Request("scan\t" + absolute_path(m_filename), listing)) return false;
+
+  if(!LoadListing(listing)) {
+    error("Wrong catalog of " << m_filename << " from the daemon");
+    Clear();
+    return false;
+  }
+  return true;
+}
+
+bool Catalog::LoadListing(TString listing)
+{
+  std::map<TString, ParentItem*> parents;
+  parents[""] = m_root;
+
+  Ssiz_t start = 0;
+  while(start < listing.Length()){
+    Ssiz_t end = listing.Index("\n", start);
+    if(end < 0) end = listing.Length();
+    std::vector<TString> f = split_tabs(listing(start, end-start));
+    start = end+1;
+
+    if(f.size() < 4) return false;
+
+    std::map<TString, ParentItem*>::iterator parent = parents.find(f[1]);
+    if(parent == parents.end()) return false;
+
+    ItemType type = (ItemType)f[0].Atoi();
+    Int_t entry = m_items.size();
+
+    Item *it;
+    if(type == Dir || type == Tree)
+      it = new ParentItem(m_index, entry, f[2], f[3], type);
+    else if(type == Branch) {
+      // all branches are BranchItems, without costs if they are missing
+      bool costs = (f.size() == 9);
+      BranchItem *b = new BranchItem(m_index, entry, f[2], f[3],
+                                     costs ? f[4].Atoll() : 0, costs ? f[5].Atoll() : 0,
+                                     costs ? f[6].Atoll() : 0, costs ? f[7].Atoi() : 0);
+      if(costs) b->SetHeat(f[8].Atof());
+      it = b;
+    }
+    else
+      it = new Item(m_index, entry, f[2], f[3], type);
+
+    it->SetPath(f[1]);
+    parent->second->AddItem(it);
+    m_items.push_back(it);
+
+    if(type == Dir || type == Tree) parents[it->GetFullPath()] = (ParentItem*)it;
+    else if(type != Branch) m_paths[it->GetFullPath()] = it;
+  }
+
+  return true;
+}
+
+/** Remove all the items */
+void Catalog::Clear()
+{
+  delete m_root;
+  m_root = new ParentItem(m_index, 0, "", "", Dir);
+  m_items.clear();
+  m_paths.clear();
+}
+
+/** Items whose name matches pattern (wildcards allowed) */
+std::vector<Item*> Catalog::Find(TString pattern)
+{
+  Scan();
+
+  std::vector<Item*> found;
+  TRegexp re(pattern, kTRUE);
+  for(unsigned int k=0; k<m_items.size(); k++){
+    if(!m_items[k]->IsPlotable()) continue;
+    if(m_items[k]->GetName().Index(re) >= 0) found.push_back(m_items[k]);
+  }
+  return found;
+}
+
+/** Item of the object (not branch) with the given full path */
+Item* Catalog::FindPath(TString path)
+{
+  Scan();
+
+  std::map<TString, Item*>::iterator it = m_paths.find(path);
+  if(it == m_paths.end()) return 0;
+  return it->second;
+}
+
+/** All the histograms and graphs of the file (branches are not included) */
+std::vector<Item*> Catalog::GetPlotableItems()
+{
+  Scan();
+
+  std::vector<Item*> items;
+  for(unsigned int k=0; k<m_items.size(); k++){
+    if(m_items[k]->IsPlotable() && !m_items[k]->IsBranch()) items.push_back(m_items[k]);
+  }
+  return items;
+}
+
+/** Read the object of the item. The caller owns it */
+TObject* Catalog::GetObject(Item *it)
+{
+  return FilePool::Instance()->ReadObject(m_filename, it->GetPath(), it->GetName());
+}
+
+/** Uncompressed size of the object of an item, from its key (the object
+    is not read) */
+Long64_t Catalog::GetObjectSize(Item *it)
+{
+  TFile *file = FilePool::Instance()->Get(m_filename);
+  if(!file) return 0;
+
+  TDirectory *dir = it->GetPath().IsNull() ? file : file->GetDirectory(it->GetPath());
+  TKey *key = dir ? dir->GetKey(it->GetName()) : 0;
+  return key ? key->GetObjlen() : 0;
+}
+
+/** Tree of a branch item. Only valid until another file is requested */
+TTree* Catalog::GetTree(Item *it)
+{
+  return FilePool::Instance()->GetTree(m_filename, it->GetPath());
+}
+
+/** Add the items in dir to pt. Only the key class is used to know the
+    type of each object, so the objects are not read (except trees) */
+void Catalog::BrowseDir(TDirectory *dir, ParentItem* pt, TString path)
+{
+  TIter next(dir->GetListOfKeys());
+  TKey *key;
+  TString name, title;
+
+  while ((key=(TKey*)next())) {
+
+    // only the last cycle
+    if(dir->GetKey(key->GetName()) != key) continue;
+
+    TClass *cl = TClass::GetClass(key->GetClassName());
+    if(!cl) continue;
+
+    name = key->GetName();
+    title = key->GetTitle();
+
+    if(name.IsNull()) name = title;
+
+    Int_t entry = m_items.size();
+
+    if(cl->InheritsFrom("TTree")){
+      ParentItem *it = new ParentItem(m_index, entry, name, title, Tree);
+      it->SetPath(path);
+      pt->AddItem(it);
+      m_items.push_back(it);
+      TTree *tree = (TTree*)key->ReadObj();
+      if(tree) BrowseTree(tree, it, it->GetFullPath());
+    }
+    else if(cl->InheritsFrom("TDirectory")){
+      ParentItem *it = new ParentItem(m_index, entry, name, title, Dir);
+      it->SetPath(path);
+      pt->AddItem(it);
+      m_items.push_back(it);
+      TDirectory *subdir = dir->GetDirectory(key->GetName());
+      if(subdir) BrowseDir(subdir, it, it->GetFullPath());
+    }
+    else if(cl->InheritsFrom("TH1")) {
+      Item *it;
+      if(cl->InheritsFrom("TH3"))
+        it = new Item(m_index, entry, name, title, Hist3D);
+      else if(cl->InheritsFrom("TH2"))
+        it = new Item(m_index, entry, name, title, Hist2D);
+      else
+        it = new Item(m_index, entry, name, title, Hist1D);
+      it->SetPath(path);
+      pt->AddItem(it);
+      m_items.push_back(it);
+      m_paths[it->GetFullPath()] = it;
+    }
+    else if (cl->InheritsFrom("TGraph")) {
+      Item *it = new Item(m_index, entry, name, title, Graph);
+      it->SetPath(path);
+      pt->AddItem(it);
+      m_items.push_back(it);
+      m_paths[it->GetFullPath()] = it;
+    }
+
+  }
+
+}
+
+/** Baskets written by the branch and all its sub-branches */
+static Int_t count_baskets(TBranch *branch)
+{
+  Int_t n = branch->GetWriteBasket();
+  TObjArray *l = branch->GetListOfBranches();
+  for(Int_t k=0; k<l->GetEntriesFast(); k++){
+    TBranch *sub = (TBranch*)l->At(k);
+    if(sub) n += count_baskets(sub);
+  }
+  return n;
+}
+
+/** Add the branches of the tree to pt. Branch items keep the tree path,
+    and their sizes (including the sub-branches) from the tree metadata */
+void Catalog::BrowseTree(TTree *tree, ParentItem *pt, TString path)
+{
+  std::vector<BranchItem*> branches;
+  Long64_t max_zip = 0;
+
+  TObjArray *l = tree->GetListOfBranches();
+  int nbranches = l->GetEntriesFast();
+  for(Int_t k=0; k<nbranches; k++){
+    TBranch *branch = (TBranch*)l->At(k);
+    if(!branch) continue;
+    BranchItem *it = new BranchItem(m_index, m_items.size(), branch->GetName(), branch->GetTitle(),
+                                    branch->GetEntries(), branch->GetTotBytes("*"),
+                                    branch->GetZipBytes("*"), count_baskets(branch));
+    it->SetPath(path);
+    pt->AddItem(it);
+    m_items.push_back(it);
+    branches.push_back(it);
+    max_zip = std::max(max_zip, it->GetZipBytes());
+  }
+
+  if(max_zip > 0) {
+    for(unsigned int k=0; k<branches.size(); k++)
+      branches[k]->SetHeat((Double_t)branches[k]->GetZipBytes()/max_zip);
+  }
+}
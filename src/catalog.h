@@ -0,0 +1,71 @@
+/** @file catalog.h
+    @brief Header file for the catalog of items of a file
+*/
+
+#ifndef CATALOG_H
+#define CATALOG_H
+
+#include <vector>
+#include <map>
+
+#include <TROOT.h>
+#include <TString.h>
+#include <TDirectory.h>
+#include <TTree.h>
+
+#include "item.h"
+
+/** Catalog of the plotable items of a file.
+
+    The file is only opened and scanned the first time the catalog is
+    needed (when its box is shown or when it is searched). The catalog
+    stays in memory afterwards, while the file itself is handled by the
+    file pool. If a daemon is running, the catalog is taken from it
+    instead of scanning the file.
+*/
+class Catalog {
+
+ public:
+  Catalog(Int_t index, TString filename);
+  ~Catalog();
+
+  void Scan();
+  bool IsScanned() { return m_scanned; }
+
+  Int_t GetIndex() { return m_index; }
+  TString GetFileName() { return m_filename; }
+  TString GetShortName();
+  ParentItem* GetRoot() { Scan(); return m_root; }
+  unsigned int GetN() { Scan(); return m_items.size(); }
+  Item* GetItem(int entry) { Scan(); return m_items[entry]; }
+  std::vector<Item*> Find(TString pattern);
+  Item* FindPath(TString path);
+  std::vector<Item*> GetPlotableItems();
+
+  TObject* GetObject(Item*);
+  Long64_t GetObjectSize(Item*);
+  TTree* GetTree(Item*);
+
+  TString GetListing();
+
+  static void SetDaemon(TString socket) { m_daemon = socket; }
+
+ private:
+  void BrowseDir(TDirectory*, ParentItem*, TString);
+  void BrowseTree(TTree*, ParentItem*, TString);
+  bool ScanFromDaemon();
+  bool LoadListing(TString listing);
+  void Clear();
+
+  static TString m_daemon; // socket of the daemon, if any
+
+  Int_t m_index;
+  TString m_filename;
+  bool m_scanned;
+
+  ParentItem *m_root;
+  std::vector<Item*> m_items; // all the items, indexed by entry
+  std::map<TString, Item*> m_paths; // objects (not branches) by full path
+};
+
+#endif
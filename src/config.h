@@ -1,7 +1,7 @@
 /** @file config.h */
 
 // colours
-Color_t default_colours[] = {
+const Color_t default_colours[] = {
   kBlack,
   kRed,
   kBlue,
@@ -24,12 +24,15 @@ Color_t default_colours[] = {
   kMagenta-9
 };
 
+// file boxes shown in each page
+const unsigned int files_per_page = 15;
+
 // markers
-short maker_style = 20;
-float marker_size = 1.0;
+const short maker_style = 20;
+const float marker_size = 1.0;
 
 // lines
-short line_width = 2;
+const short line_width = 2;
 
 // style
 /* TStyle *style = new TStyle(); */
@@ -0,0 +1,319 @@
+/** @file daemon.cxx
+    @brief Daemon and DaemonClient implementation
+*/
+
+#include <unistd.h>
+#include <cstdlib>
+#include <vector>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+
+#include <TSystem.h>
+#include <TSocket.h>
+#include <TServerSocket.h>
+#include <TMessage.h>
+#include <TObjArray.h>
+#include <TObjString.h>
+
+#include "catalog.h"
+#include "filepool.h"
+#include "plotspec.h"
+#include "batch.h"
+#include "stats.h"
+#include "memory.h"
+#include "daemon.h"
+#include "common.h"
+
+// a client that sends nothing for this long is dropped
+static const int client_timeout = 10;
+
+/** PLOTTER_SOCKET, or a socket in the runtime directory of the user
+    (private), or else in a private directory of the temp directory */
+TString default_socket_path()
+{
+  if(gSystem->Getenv("PLOTTER_SOCKET")) return gSystem->Getenv("PLOTTER_SOCKET");
+  if(gSystem->Getenv("XDG_RUNTIME_DIR")) return TString(gSystem->Getenv("XDG_RUNTIME_DIR")) + "/plotter.sock";
+  return private_temp_dir() + "/plotter.sock";
+}
+
+TString private_temp_dir()
+{
+  return Form("%s/plotter-%i", gSystem->TempDirectory(), (int)getuid());
+}
+
+/** Create the directory with mode 0700 if needed, and check that it's a
+    directory (not a link) of the user that no one else can use */
+static bool make_private_dir(TString dir)
+{
+  struct stat st;
+  if(lstat(dir, &st) != 0 && mkdir(dir, 0700) != 0) {
+    error("Cannot create " << dir);
+    return false;
+  }
+  if(lstat(dir, &st) != 0 || !S_ISDIR(st.st_mode) || st.st_uid != getuid() || (st.st_mode & 077)) {
+    error(dir << " is not a private directory of this user");
+    return false;
+  }
+  return true;
+}
+
+/** The socket is owned by the user and no one else can use it */
+static bool is_private_socket(TString path)
+{
+  struct stat st;
+  if(lstat(path, &st) != 0) return false;
+  if(!S_ISSOCK(st.st_mode) || st.st_uid != getuid() || (st.st_mode & 077)) {
+    error("Ignoring " << path << ": not a socket of this user with mode 0600");
+    return false;
+  }
+  return true;
+}
+
+/** The daemon doesn't share the working directory of its clients */
+TString absolute_path(TString path)
+{
+  if(path.IsNull() || gSystem->IsAbsoluteFileName(path)) return path;
+  return TString(gSystem->WorkingDirectory()) + "/" + path;
+}
+
+static std::vector<TString> split_fields(TString line)
+{
+  std::vector<TString> fields;
+  TObjArray *tokens = line.Tokenize("\t");
+  for(Int_t k=0; k<tokens->GetEntriesFast(); k++)
+    fields.push_back(((TObjString*)tokens->At(k))->GetString());
+  delete tokens;
+  return fields;
+}
+
+static bool send_string(TSocket *sock, TString s)
+{
+  TMessage mess(kMESS_ANY);
+  mess.WriteTString(s);
+  return sock->Send(mess) > 0;
+}
+
+static bool recv_string(TSocket *sock, TString &s)
+{
+  TMessage *mess = 0;
+  if(sock->Recv(mess) <= 0 || !mess) return false;
+  mess->ReadTString(s);
+  delete mess;
+  return true;
+}
+
+Daemon::Daemon(TString socket) :
+  m_socket(socket),
+  m_running(false),
+  m_requests(0)
+{
+}
+
+Daemon::~Daemon()
+{
+  std::map<TString, Catalog*>::iterator it;
+  for(it = m_catalogs.begin(); it != m_catalogs.end(); ++it) delete it->second;
+}
+
+/** Serve requests until a stop request. Returns 0 if it could listen */
+int Daemon::Run()
+{
+  if(m_socket.BeginsWith(private_temp_dir() + "/") && !make_private_dir(private_temp_dir())) return 1;
+
+  // the socket of a daemon that was killed is still there
+  struct stat st;
+  if(lstat(m_socket, &st) == 0) {
+    if(!is_private_socket(m_socket)) return 1;
+    if(DaemonClient(m_socket).IsRunning()) {
+      error("A daemon is already listening on " << m_socket);
+      return 1;
+    }
+    gSystem->Unlink(m_socket);
+  }
+
+  // only the user can connect
+  mode_t mask = umask(077);
+  TServerSocket server(m_socket);
+  umask(mask);
+  if(!server.IsValid()) {
+    error("Cannot listen on " << m_socket);
+    return 1;
+  }
+  chmod(m_socket, 0600);
+
+  msg("Listening on " << m_socket);
+
+  m_running = true;
+  while(m_running){
+    TSocket *sock = server.Accept();
+    if(!sock || sock == (TSocket*)-1) continue;
+
+    struct timeval timeout = { client_timeout, 0 };
+    setsockopt(sock->GetDescriptor(), SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(sock->GetDescriptor(), SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    Serve(sock);
+    sock->Close();
+    delete sock;
+  }
+
+  server.Close();
+  gSystem->Unlink(m_socket);
+  msg("Daemon stopped after " << m_requests << " requests");
+
+  return 0;
+}
+
+void Daemon::Serve(TSocket *sock)
+{
+  TString request;
+  if(!recv_string(sock, request)) return;
+
+  m_requests++;
+  send_string(sock, Handle(request));
+}
+
+TString Daemon::Handle(TString request)
+{
+  std::vector<TString> fields = split_fields(request);
+  if(fields.empty()) return "error empty request\n";
+
+  TString cmd = fields[0];
+
+  if(cmd == "scan" && fields.size() == 2) {
+    CheckFile(fields[1]);
+    if(!FilePool::Instance()->Get(fields[1])) return "error cannot open " + fields[1] + "\n";
+    return "ok\n" + GetCatalog(fields[1])->GetListing();
+  }
+  else if(cmd == "plot" && fields.size() == 6) {
+    return Plot(fields[1], fields[2], fields[3], fields[4], atoi(fields[5]));
+  }
+  else if(cmd == "stats") {
+    return "ok\n" + GetStats();
+  }
+  else if(cmd == "stop") {
+    m_running = false;
+    return "ok\n";
+  }
+
+  return "error unknown request: " + cmd + "\n";
+}
+
+/** The catalogs are scanned once and kept */
+Catalog* Daemon::GetCatalog(TString filename)
+{
+  std::map<TString, Catalog*>::iterator it = m_catalogs.find(filename);
+  if(it != m_catalogs.end()) return it->second;
+
+  Catalog *catalog = new Catalog(m_catalogs.size(), filename);
+  m_catalogs[filename] = catalog;
+  return catalog;
+}
+
+/** Forget what is kept of a file (catalog, open file, cached objects)
+    if it has changed since it was last used */
+void Daemon::CheckFile(TString filename)
+{
+  FileStamp stamp = { 0, 0, 0 };
+  Long_t flags;
+  gSystem->GetPathInfo(filename, &stamp.id, &stamp.size, &flags, &stamp.modtime);
+
+  std::map<TString, FileStamp>::iterator it = m_stamps.find(filename);
+  if(it != m_stamps.end() && (it->second.id != stamp.id || it->second.size != stamp.size ||
+                              it->second.modtime != stamp.modtime)) {
+    msg(filename << " has changed, reading it again");
+
+    std::map<TString, Catalog*>::iterator catalog = m_catalogs.find(filename);
+    if(catalog != m_catalogs.end()) {
+      delete catalog->second;
+      m_catalogs.erase(catalog);
+    }
+    FilePool::Instance()->Close(filename);
+    m_cache.RemovePrefix(filename + "|");
+  }
+
+  m_stamps[filename] = stamp;
+}
+
+/** Plots of a spec file, with the files relative to the directory of
+    the client. The objects already loaded are taken from the cache
+    (unless their file has changed) */
+TString Daemon::Plot(TString cwd, TString specs_file, TString output_dir, TString formats, unsigned int jobs)
+{
+  std::vector<PlotSpec*> specs = read_plot_specs(specs_file);
+  if(specs.empty()) return "error no plots in " + specs_file + "\n";
+
+  for(unsigned int i=0; i<specs.size(); i++){
+    for(unsigned int k=0; k<specs[i]->items.size(); k++){
+      TString &file = specs[i]->items[k]->file;
+      if(!gSystem->IsAbsoluteFileName(file)) file = cwd + "/" + file;
+      CheckFile(file);
+    }
+  }
+
+  Long64_t hits = m_cache.GetHits();
+
+  Batch batch;
+  batch.SetCache(&m_cache);
+  batch.AddSpecs(specs);
+  batch.SetOutputDir(output_dir);
+  batch.SetFormats(formats);
+  batch.SetJobs(jobs);
+
+  if(batch.Run() != 0) return "error some plots failed\n";
+
+  return Form("ok\n%u plots saved in %s (%lld objects from the cache)\n",
+              (unsigned int)specs.size(), output_dir.Data(), m_cache.GetHits() - hits);
+}
+
+TString Daemon::GetStats()
+{
+  TString s = Form("%lld requests, %u catalogs, %u files open, %u cached objects (%lld hits, %lld misses)\n",
+                   m_requests, (unsigned int)m_catalogs.size(), FilePool::Instance()->GetNOpen(),
+                   m_cache.GetN(), m_cache.GetHits(), m_cache.GetMisses());
+  s += MemoryAccountant::Instance()->GetSummary() + "\n";
+  s += Stats::Instance()->GetReport();
+  return s;
+}
+
+DaemonClient::DaemonClient(TString socket) :
+  m_socket(socket)
+{
+}
+
+bool DaemonClient::IsRunning()
+{
+  if(gSystem->AccessPathName(m_socket) || !is_private_socket(m_socket)) return false;
+
+  TSocket sock(m_socket);
+  bool valid = sock.IsValid();
+  sock.Close();
+  return valid;
+}
+
+/** Send a request and wait for the reply (without its status line).
+    Returns false if the daemon cannot be reached or the request failed */
+bool DaemonClient::Request(TString request, TString &reply)
+{
+  reply = "";
+  if(gSystem->AccessPathName(m_socket) || !is_private_socket(m_socket)) return false;
+
+  TSocket sock(m_socket);
+  if(!sock.IsValid()) return false;
+
+  TString answer;
+  bool sent = send_string(&sock, request) && recv_string(&sock, answer);
+  sock.Close();
+  if(!sent) return false;
+
+  Ssiz_t eol = answer.Index("\n");
+  TString status = (eol < 0) ? answer : TString(answer(0, eol));
+  reply = (eol < 0) ? TString("") : TString(answer(eol+1, answer.Length()));
+
+  if(status != "ok") {
+    reply = status;
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,84 @@
+/** @file daemon.h
+    @brief Long-lived plotter process serving requests on a UNIX socket
+*/
+
+#ifndef DAEMON_H
+#define DAEMON_H
+
+#include <map>
+
+#include <TROOT.h>
+#include <TString.h>
+
+#include "objcache.h"
+
+class TSocket;
+class Catalog;
+
+TString default_socket_path();
+TString private_temp_dir();
+TString absolute_path(TString path);
+
+/** Keeps the catalogs of the files scanned, the open files (in the file
+    pool) and the objects and tree draws already loaded, and serves the
+    requests of the clients, one at a time. A request is one line of tab
+    separated fields:
+
+    scan   file                               list of the items of the file
+    plot   cwd  specs  outdir  formats  jobs  make the plots of a spec file
+    stats                                     session stats of the daemon
+    stop                                      stop the daemon
+
+    The reply begins with a line "ok" or "error message".
+
+    What is kept of a file (catalog, open file, cached objects) is
+    dropped when the file changes on disk (inode, size or modification
+    time). The socket is only readable and writable by the user, and a
+    client that sends nothing for 10 s is dropped.
+*/
+class Daemon {
+
+ public:
+  Daemon(TString socket);
+  ~Daemon();
+
+  int Run();
+
+ private:
+  void Serve(TSocket *sock);
+  TString Handle(TString request);
+  TString Plot(TString cwd, TString specs, TString output_dir, TString formats, unsigned int jobs);
+  TString GetStats();
+  Catalog* GetCatalog(TString filename);
+  void CheckFile(TString filename);
+
+  struct FileStamp {
+    Long_t id;
+    Long64_t size;
+    Long_t modtime;
+  };
+
+  TString m_socket;
+  bool m_running;
+  Long64_t m_requests;
+
+  std::map<TString, Catalog*> m_catalogs;
+  std::map<TString, FileStamp> m_stamps; // of the files when they were last used
+  ObjectCache m_cache;
+};
+
+/** Connection to a daemon. Each request uses its own connection, only
+    to a socket of the user with mode 0600 */
+class DaemonClient {
+
+ public:
+  DaemonClient(TString socket);
+
+  bool IsRunning();
+  bool Request(TString request, TString &reply);
+
+ private:
+  TString m_socket;
+};
+
+#endif
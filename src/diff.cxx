@@ -0,0 +1,239 @@
+/** @file diff.cxx
+    @brief Statistical comparison of the histograms of two files
+*/
+
+#include <cmath>
+#include <cerrno>
+#include <algorithm>
+#include <unistd.h>
+
+#include <TSystem.h>
+#include <TDirectory.h>
+#include <TFile.h>
+#include <TMath.h>
+
+#include "item.h"
+#include "catalog.h"
+#include "filepool.h"
+#include "diff.h"
+#include "common.h"
+
+/** -log10 of the smallest p-value (KS, chi2 or maximum pull), the
+    larger the more discrepant */
+Double_t DiffResult::GetScore() const
+{
+  if(status != kDiffOk) return -1;
+  return -std::log10(std::max(std::min(std::min(ks, chi2), pull_p), 1e-300));
+}
+
+DiffResult diff_histograms(TH1 *ref, TH1 *test)
+{
+  DiffResult result;
+
+  if(!ref || !test) {
+    result.status = kDiffMissing;
+    return result;
+  }
+  if(ref->GetDimension() != test->GetDimension() || ref->GetNcells() != test->GetNcells()) {
+    result.status = kDiffBinning;
+    return result;
+  }
+
+  result.status = kDiffOk;
+
+  Double_t sum_ref = ref->GetSumOfWeights();
+  Double_t sum_test = test->GetSumOfWeights();
+
+  // the tests are not defined for empty histograms
+  if(sum_ref == 0 && sum_test == 0) return result;
+  if(sum_ref == 0 || sum_test == 0) {
+    result.ks = 0;
+    result.chi2 = 0;
+  }
+  else {
+    result.ks = ref->KolmogorovTest(test);
+
+    TString opt = (ref->GetSumw2N() > 0) ? "W" : "U";
+    opt += (test->GetSumw2N() > 0) ? "W" : "U";
+    result.chi2 = ref->Chi2Test(test, opt);
+  }
+
+  Int_t n_bins = 0;
+  for(Int_t bin=0; bin<ref->GetNcells(); bin++){
+    if(ref->IsBinUnderflow(bin) || ref->IsBinOverflow(bin)) continue;
+
+    Double_t e_ref = ref->GetBinError(bin);
+    Double_t e_test = test->GetBinError(bin);
+    Double_t e2 = e_ref*e_ref + e_test*e_test;
+    if(e2 <= 0) continue;
+
+    Double_t pull = std::fabs(test->GetBinContent(bin) - ref->GetBinContent(bin))/std::sqrt(e2);
+    result.max_pull = std::max(result.max_pull, pull);
+    n_bins++;
+  }
+
+  // two-sided gaussian p-value of the largest of n_bins pulls (Bonferroni)
+  if(n_bins > 0) result.pull_p = std::min(1., n_bins*TMath::Erfc(result.max_pull/std::sqrt(2.)));
+
+  return result;
+}
+
+static std::vector<Catalog*> two_catalogs(Catalog *ref, Catalog *test)
+{
+  std::vector<Catalog*> catalogs;
+  catalogs.push_back(ref);
+  catalogs.push_back(test);
+  return catalogs;
+}
+
+/** What a worker sends for each pair */
+struct DiffRecord {
+  unsigned int k;
+  DiffResult result;
+};
+
+DiffRunner::DiffRunner(Catalog *ref, Catalog *test) :
+  m_catalogs(two_catalogs(ref, test)),
+  m_matcher(m_catalogs),
+  m_done(0)
+{
+}
+
+DiffRunner::~DiffRunner()
+{
+  Stop();
+}
+
+/** Paths in both files. Returns the number of pairs to compare */
+unsigned int DiffRunner::Join()
+{
+  unsigned int n = m_matcher.Join(2);
+  m_results.assign(n, DiffResult());
+  m_done = 0;
+  return n;
+}
+
+/** Start the workers, that compare all the pairs */
+void DiffRunner::Start(unsigned int jobs)
+{
+  if(m_results.empty()) return;
+
+  unsigned int n_workers = std::max(1u, std::min(jobs, (unsigned int)m_results.size()));
+
+  // workers can't share the open files
+  FilePool::Instance()->CloseAll();
+
+  m_workers = start_pipe_workers(n_workers, RunWorker, this);
+  m_buffers.assign(m_workers.size(), std::string());
+  if(m_workers.empty()) Finish();
+}
+
+/** Take the results sent by the workers so far. Returns the number of
+    new results */
+unsigned int DiffRunner::Poll()
+{
+  unsigned int received = 0;
+
+  for(unsigned int w=0; w<m_workers.size(); w++){
+    bool running = read_pipe_worker(m_workers[w], m_buffers[w]);
+
+    std::string &buffer = m_buffers[w];
+    size_t used = 0;
+    while(buffer.size() - used >= sizeof(DiffRecord)){
+      DiffRecord record;
+      buffer.copy((char*)&record, sizeof(record), used);
+      used += sizeof(record);
+      if(record.k >= m_results.size() || m_results[record.k].status != kDiffPending) continue;
+      m_results[record.k] = record.result;
+      received++;
+    }
+    buffer.erase(0, used);
+
+    if(!running) {
+      m_workers.erase(m_workers.begin()+w);
+      m_buffers.erase(m_buffers.begin()+w);
+      w--;
+    }
+  }
+
+  m_done += received;
+  if(m_workers.empty()) Finish();
+  return received;
+}
+
+/** Kill the workers still running */
+void DiffRunner::Stop()
+{
+  for(unsigned int w=0; w<m_workers.size(); w++) stop_pipe_worker(m_workers[w]);
+  m_workers.clear();
+  m_buffers.clear();
+}
+
+/** Failed workers leave their pairs pending */
+void DiffRunner::Finish()
+{
+  for(unsigned int k=0; k<m_results.size(); k++){
+    if(m_results[k].status != kDiffPending) continue;
+    m_results[k].status = kDiffMissing;
+    m_done++;
+  }
+}
+
+/** Each worker compares the pairs worker, worker+n_workers, ... and
+    writes the results to its pipe. Fails if the parent has gone */
+bool DiffRunner::RunWorker(unsigned int worker, unsigned int n_workers, int fd, void *data)
+{
+  DiffRunner *r = (DiffRunner*)data;
+
+  TDirectory::TContext ctx(gDirectory);
+
+  TFile *files[2];
+  for(unsigned int f=0; f<2; f++){
+    files[f] = TFile::Open(r->m_catalogs[f]->GetFileName());
+    if(files[f] && files[f]->IsZombie()) {
+      delete files[f];
+      files[f] = 0;
+    }
+  }
+
+  bool sent = true;
+  for(unsigned int k=worker; k<r->m_results.size(); k+=n_workers){
+    MatchedPath *match = r->GetMatch(k);
+
+    TObject *objs[2] = { 0, 0 };
+    for(unsigned int j=0; j<match->items.size() && j<2; j++){
+      unsigned int f = match->files[j];
+      if(files[f]) objs[f] = Matcher::ReadItem(files[f], match->items[j]);
+    }
+
+    DiffRecord record;
+    record.k = k;
+    if(!objs[0] || !objs[1]) record.result.status = kDiffMissing;
+    else if(!objs[0]->InheritsFrom("TH1") || !objs[1]->InheritsFrom("TH1")) record.result.status = kDiffNotHist;
+    else record.result = diff_histograms((TH1*)objs[0], (TH1*)objs[1]);
+
+    delete objs[0];
+    delete objs[1];
+
+    const char *p = (const char*)&record;
+    size_t left = sizeof(record);
+    while(left > 0){
+      ssize_t n = write(fd, p, left);
+      if(n < 0 && errno == EINTR) continue;
+      if(n <= 0) break;
+      p += n;
+      left -= n;
+    }
+    if(left > 0) {
+      sent = false; // the parent has gone
+      break;
+    }
+  }
+
+  for(unsigned int f=0; f<2; f++){
+    if(!files[f]) continue;
+    files[f]->Close();
+    delete files[f];
+  }
+  return sent;
+}
@@ -0,0 +1,80 @@
+/** @file diff.h
+    @brief Statistical comparison of the histograms of two files
+*/
+
+#ifndef DIFF_H
+#define DIFF_H
+
+#include <vector>
+#include <string>
+
+#include <TROOT.h>
+#include <TH1.h>
+
+#include "match.h"
+#include "workers.h"
+
+class Catalog;
+
+enum DiffStatus {
+  kDiffPending,
+  kDiffOk,
+  kDiffMissing, // cannot be read from one of the files
+  kDiffBinning, // different binning
+  kDiffNotHist  // graphs are not compared
+};
+
+/** p-values of the KS and chi2 tests and maximum bin pull of a pair of
+    histograms */
+struct DiffResult {
+  Double_t ks;
+  Double_t chi2;
+  Double_t max_pull;
+  Double_t pull_p; // p-value of the maximum pull, for the number of bins compared
+  Int_t status;
+
+  DiffResult() : ks(1), chi2(1), max_pull(0), pull_p(1), status(kDiffPending) {}
+  Double_t GetScore() const;
+};
+
+DiffResult diff_histograms(TH1 *ref, TH1 *test);
+
+/** Compare all the histograms with the same path in two files in the
+    background. The pairs are split between worker processes started
+    once, that read the histograms themselves and send back only the
+    results through pipes. Poll collects the results received so far
+    without blocking, so they can be shown while the rest are computed.
+
+    The catalogs are only used by Join and by the workers.
+*/
+class DiffRunner {
+
+ public:
+  DiffRunner(Catalog *ref, Catalog *test);
+  ~DiffRunner();
+
+  unsigned int Join();
+  void Start(unsigned int jobs);
+  unsigned int Poll();
+  void Stop();
+
+  unsigned int GetN() { return m_results.size(); }
+  unsigned int GetDone() { return m_done; }
+  bool IsDone() { return m_workers.empty(); }
+
+  MatchedPath* GetMatch(unsigned int k) { return m_matcher.GetMatches()[k]; }
+  const DiffResult& GetResult(unsigned int k) { return m_results[k]; }
+
+ private:
+  static bool RunWorker(unsigned int, unsigned int, int, void*);
+  void Finish();
+
+  std::vector<Catalog*> m_catalogs;
+  Matcher m_matcher;
+  std::vector<DiffResult> m_results;
+  unsigned int m_done; // results received
+  std::vector<PipeWorker> m_workers;
+  std::vector<std::string> m_buffers; // data received from each worker, not parsed yet
+};
+
+#endif
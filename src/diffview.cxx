@@ -0,0 +1,190 @@
+/** @file diffview.cxx
+    @brief DiffView class implementation
+*/
+
+#include <algorithm>
+
+#include <TGLayout.h>
+#include <TGButton.h>
+
+#include "catalog.h"
+#include "plotter.h"
+#include "workers.h"
+#include "diff.h"
+#include "diffview.h"
+#include "common.h"
+
+ClassImp(DiffView)
+
+// only the most discrepant are listed
+static const unsigned int max_rows = 500;
+
+static const char *column_names[5] = { "Path", "KS p-value", "Chi2 p-value", "Max pull", "Score" };
+
+/** Order of the results in the list: most discrepant first, pending and
+    failed comparisons at the end */
+class DiffOrder {
+ public:
+  DiffOrder(DiffRunner *runner, Int_t column) : m_runner(runner), m_column(column) {}
+
+  bool operator()(unsigned int i, unsigned int j) const {
+    const DiffResult &a = m_runner->GetResult(i);
+    const DiffResult &b = m_runner->GetResult(j);
+
+    if((a.status == kDiffOk) != (b.status == kDiffOk)) return a.status == kDiffOk;
+
+    switch(m_column){
+    case kDiffColPath:
+      return m_runner->GetMatch(i)->path < m_runner->GetMatch(j)->path;
+    case kDiffColKS:
+      if(a.ks != b.ks) return a.ks < b.ks;
+      break;
+    case kDiffColChi2:
+      if(a.chi2 != b.chi2) return a.chi2 < b.chi2;
+      break;
+    case kDiffColPull:
+      if(a.max_pull != b.max_pull) return a.max_pull > b.max_pull;
+      break;
+    }
+
+    if(a.GetScore() != b.GetScore()) return a.GetScore() > b.GetScore();
+    return a.max_pull > b.max_pull;
+  }
+
+ private:
+  DiffRunner *m_runner;
+  Int_t m_column;
+};
+
+static TString status_text(const DiffResult &result)
+{
+  switch(result.status){
+  case kDiffMissing: return "cannot read";
+  case kDiffBinning: return "different binning";
+  case kDiffNotHist: return "not a histogram";
+  }
+  return "";
+}
+
+DiffView::DiffView(const TGWindow *p, Plotter *plotter, UInt_t ref_file, Catalog *ref,
+                   UInt_t test_file, Catalog *test) :
+  TGMainFrame(p, 800, 600),
+  m_plotter(plotter),
+  m_ref_file(ref_file),
+  m_test_file(test_file),
+  m_runner(new DiffRunner(ref, test)),
+  m_timer(0),
+  m_sort(kDiffColScore)
+{
+  SetCleanup(kDeepCleanup);
+
+  label_status = new TGLabel(this, "Matching...");
+  label_status->SetTextJustify(kTextLeft);
+  AddFrame(label_status, new TGLayoutHints(kLHintsExpandX, 4, 4, 4, 2));
+
+  list_view = new TGListView(this, 800, 560);
+  list_container = new TGLVContainer(list_view, kSunkenFrame, GetWhitePixel());
+  list_view->SetViewMode(kLVDetails);
+  list_view->SetHeaders(5);
+  for(Int_t k=0; k<5; k++){
+    list_view->SetHeader(column_names[k], (k == 0) ? kTextLeft : kTextRight, (k == 0) ? kTextLeft : kTextRight, k);
+  }
+  list_view->Connect("DoubleClicked(TGLVEntry*, Int_t)", "DiffView", this, "OnDoubleClick(TGLVEntry*, Int_t)");
+
+  // sort by the column of the header clicked
+  TGTextButton **headers = list_view->GetHeaderButtons();
+  for(Int_t k=0; k<5; k++){
+    headers[k]->Connect("Clicked()", "DiffView", this, Form("SortBy(=%i)", k));
+  }
+
+  AddFrame(list_view, new TGLayoutHints(kLHintsExpandX | kLHintsExpandY, 2, 2, 2, 2));
+
+  SetWindowName(Form("Diff %s vs %s", test->GetShortName().Data(), ref->GetShortName().Data()));
+  MapSubwindows();
+  Resize(GetDefaultSize());
+  MapWindow();
+
+  m_runner->Join();
+  m_runner->Start(number_of_cores());
+  ShowResults();
+
+  m_timer = new TTimer(100, kFALSE);
+  m_timer->Connect("Timeout()", "DiffView", this, "Poll()");
+  m_timer->Start(100, kFALSE);
+}
+
+DiffView::~DiffView()
+{
+  delete m_timer;
+  delete m_runner;
+  Cleanup();
+}
+
+void DiffView::CloseWindow()
+{
+  m_timer->Stop();
+  m_runner->Stop();
+  DeleteWindow();
+}
+
+/** Take the results of the workers, if any, and update the list */
+void DiffView::Poll()
+{
+  bool done = m_runner->IsDone();
+  if(m_runner->Poll() > 0 || m_runner->IsDone() != done) ShowResults();
+
+  if(m_runner->IsDone()) m_timer->Stop();
+}
+
+void DiffView::SortBy(Int_t column)
+{
+  m_sort = column;
+  ShowResults();
+}
+
+/** List the first max_rows results computed so far in the chosen order */
+void DiffView::ShowResults()
+{
+  unsigned int done = m_runner->GetDone();
+
+  std::vector<unsigned int> order;
+  order.reserve(done);
+  for(unsigned int k=0; k<m_runner->GetN(); k++){
+    if(m_runner->GetResult(k).status != kDiffPending) order.push_back(k);
+  }
+
+  unsigned int n_rows = std::min((unsigned int)order.size(), max_rows);
+  std::partial_sort(order.begin(), order.begin()+n_rows, order.end(), DiffOrder(m_runner, m_sort));
+
+  list_container->RemoveAll();
+
+  for(unsigned int k=0; k<n_rows; k++){
+    const DiffResult &result = m_runner->GetResult(order[k]);
+    MatchedPath *match = m_runner->GetMatch(order[k]);
+
+    TGLVEntry *entry = new TGLVEntry(list_container, match->path, "TH1");
+    if(result.status == kDiffOk) {
+      entry->SetSubnames(Form("%.3g", result.ks), Form("%.3g", result.chi2),
+                         Form("%.2f", result.max_pull), Form("%.1f", result.GetScore()));
+    }
+    else entry->SetSubnames(status_text(result), "", "", "");
+    entry->SetUserData((void*)(ULong_t)order[k]);
+    list_container->AddItem(entry);
+  }
+
+  if(m_runner->IsDone())
+    label_status->SetText(Form("%u histograms compared, sorted by %s", m_runner->GetN(), column_names[m_sort]));
+  else
+    label_status->SetText(Form("%u/%u histograms compared...", done, m_runner->GetN()));
+
+  list_view->Layout();
+  Layout();
+}
+
+void DiffView::OnDoubleClick(TGLVEntry *entry, Int_t)
+{
+  if(!entry) return;
+
+  MatchedPath *match = m_runner->GetMatch((ULong_t)entry->GetUserData());
+  m_plotter->DrawPair(m_ref_file, m_test_file, match->path);
+}
@@ -0,0 +1,68 @@
+/** @file diffview.h
+    @brief Window with the most discrepant histograms of two files
+*/
+
+#ifndef DIFFVIEW_H
+#define DIFFVIEW_H
+
+#include <vector>
+
+#include <TROOT.h>
+#include <TTimer.h>
+#include <TGFrame.h>
+#include <TGLabel.h>
+#include <TGListView.h>
+
+class Catalog;
+class Plotter;
+class DiffRunner;
+
+enum DiffColumn {
+  kDiffColPath,
+  kDiffColKS,
+  kDiffColChi2,
+  kDiffColPull,
+  kDiffColScore
+};
+
+/** Comparison of all the histograms with the same path in a reference
+    and a test file. The tests run in background workers, and a timer
+    collects their results and updates the list with the most
+    discrepant ones. Clicking on a column header sorts by it, and
+    double-clicking on a row draws the pair with the ratio. The files
+    are kept as their positions in the plotter.
+
+    The window is deleted when it's closed.
+*/
+class DiffView : public TGMainFrame {
+
+ public:
+  DiffView(const TGWindow *p, Plotter *plotter, UInt_t ref_file, Catalog *ref,
+           UInt_t test_file, Catalog *test);
+  virtual ~DiffView();
+
+  virtual void CloseWindow();
+
+  // Slots
+  void Poll();
+  void OnDoubleClick(TGLVEntry*, Int_t);
+  void SortBy(Int_t);
+
+ private:
+  void ShowResults();
+
+  Plotter *m_plotter;
+  UInt_t m_ref_file;
+  UInt_t m_test_file;
+  DiffRunner *m_runner;
+  TTimer *m_timer;
+  Int_t m_sort;
+
+  TGListView *list_view;
+  TGLVContainer *list_container;
+  TGLabel *label_status;
+
+  ClassDef(DiffView, 0);
+};
+
+#endif
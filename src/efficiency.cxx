@@ -0,0 +1,185 @@
+/** @file efficiency.cxx
+    @brief Efficiency engine implementation
+*/
+
+#include <cmath>
+#include <algorithm>
+
+#include <Math/QuantFuncMathCore.h>
+
+#include "common.h"
+#include "efficiency.h"
+
+Efficiency::Efficiency(EffInterval interval, Double_t level) :
+  m_interval(interval),
+  m_level(level)
+{
+}
+
+TString Efficiency::GetIntervalName(EffInterval interval)
+{
+  if(interval == kJeffreys) return "Jeffreys";
+  if(interval == kWilson)   return "Wilson";
+  return "Clopper-Pearson";
+}
+
+/** Minimum of a log scale: half the lowest positive point or interval edge */
+void Efficiency::SetLogMinimum(TGraphAsymmErrors *gr)
+{
+  Double_t lowest = 1.;
+  for(Int_t i=0; i<gr->GetN(); i++){
+    Double_t low = gr->GetY()[i] - gr->GetErrorYlow(i);
+    if(low > 0. && low < lowest) lowest = low;
+    if(gr->GetY()[i] > 0. && gr->GetY()[i] < lowest) lowest = gr->GetY()[i];
+  }
+  gr->SetMinimum(0.5*lowest);
+}
+
+bool Efficiency::QuantileKey::operator<(const QuantileKey &o) const
+{
+  if(interval != o.interval) return interval < o.interval;
+  if(level != o.level) return level < o.level;
+  if(k != o.k) return k < o.k;
+  return n < o.n;
+}
+
+EffInterval Efficiency::GetIntervalFromName(TString name)
+{
+  name.ToLower();
+  if(name.BeginsWith("jeffreys")) return kJeffreys;
+  if(name.BeginsWith("wilson"))   return kWilson;
+  return kClopperPearson;
+}
+
+/** Efficiency and interval [low, up] of each element (k pass of n total) */
+void Efficiency::Intervals(const Double_t *k, const Double_t *n, Double_t *eff,
+                           Double_t *low, Double_t *up, unsigned int size)
+{
+  for(unsigned int i=0; i<size; i++){
+    eff[i] = (n[i] > 0.) ? k[i]/n[i] : 0.;
+  }
+
+  if(m_interval == kWilson) WilsonIntervals(k, n, low, up, size);
+  else BetaIntervals(k, n, low, up, size);
+}
+
+/** Wilson score interval: closed formula, no branches */
+void Efficiency::WilsonIntervals(const Double_t *k, const Double_t *n, Double_t *low, Double_t *up, unsigned int size)
+{
+  const Double_t z = ROOT::Math::normal_quantile((1.+m_level)/2., 1.);
+  const Double_t z2 = z*z;
+
+  for(unsigned int i=0; i<size; i++){
+    Double_t nz = n[i] + z2;
+    Double_t p = (n[i] > 0.) ? k[i]/n[i] : 0.;
+    Double_t centre = (k[i] + 0.5*z2) / nz;
+    Double_t half = z / nz * std::sqrt(std::max(n[i]*p*(1.-p), 0.) + 0.25*z2);
+    low[i] = std::max(centre - half, 0.);
+    up[i]  = std::min(centre + half, 1.);
+  }
+}
+
+/** Clopper-Pearson and Jeffreys intervals, from beta quantiles */
+void Efficiency::BetaIntervals(const Double_t *k, const Double_t *n, Double_t *low, Double_t *up, unsigned int size)
+{
+  const Double_t alpha = 1. - m_level;
+
+  for(unsigned int i=0; i<size; i++){
+    QuantileKey key = { m_interval, m_level, k[i], n[i] };
+
+    std::map<QuantileKey, std::pair<Double_t, Double_t> >::iterator it = m_quantiles.find(key);
+    if(it != m_quantiles.end()) {
+      low[i] = it->second.first;
+      up[i]  = it->second.second;
+      continue;
+    }
+
+    Double_t l = 0., u = 1.;
+    if(m_interval == kJeffreys) {
+      if(k[i] > 0.)    l = ROOT::Math::beta_quantile(alpha/2., k[i]+0.5, n[i]-k[i]+0.5);
+      if(k[i] < n[i])  u = ROOT::Math::beta_quantile_c(alpha/2., k[i]+0.5, n[i]-k[i]+0.5);
+    }
+    else {
+      if(k[i] > 0.)    l = ROOT::Math::beta_quantile(alpha/2., k[i], n[i]-k[i]+1.);
+      if(k[i] < n[i])  u = ROOT::Math::beta_quantile_c(alpha/2., k[i]+1., n[i]-k[i]);
+    }
+
+    m_quantiles[key] = std::make_pair(l, u);
+    low[i] = l;
+    up[i] = u;
+  }
+}
+
+TGraphAsymmErrors* Efficiency::Compute(TH1 *num, TH1 *den)
+{
+  std::vector<TH1*> nums(1, num);
+  std::vector<TH1*> dens(1, den);
+  return Compute(nums, dens)[0];
+}
+
+/** Efficiency graph of each pair nums[p]/dens[p] (0 if the pair is not
+    valid). The graphs are owned by the caller */
+std::vector<TGraphAsymmErrors*> Efficiency::Compute(std::vector<TH1*> nums, std::vector<TH1*> dens)
+{
+  std::vector<TGraphAsymmErrors*> graphs(nums.size(), (TGraphAsymmErrors*)0);
+
+  // gather the bins (with entries) of all the pairs
+  std::vector<Double_t> k, n;
+  std::vector<unsigned int> first(nums.size()+1, 0);
+  std::vector<Int_t> bin;
+
+  for(unsigned int p=0; p<nums.size(); p++){
+    first[p] = k.size();
+    TH1 *num = nums[p];
+    TH1 *den = dens[p];
+
+    if(!num || !den) continue;
+    if(num->GetDimension() != 1 || num->GetNbinsX() != den->GetNbinsX()) {
+      error("Cannot compute the efficiency " << num->GetName() << "/" << den->GetName() << ": different binning");
+      continue;
+    }
+
+    for(Int_t b=1; b<=den->GetNbinsX(); b++){
+      Double_t pass = num->GetBinContent(b);
+      Double_t total = den->GetBinContent(b);
+      if(total <= 0.) continue;
+      if(pass > total) {
+        error(num->GetName() << " bin " << b << ": pass > total, skipped");
+        continue;
+      }
+      k.push_back(pass);
+      n.push_back(total);
+      bin.push_back(b);
+    }
+
+    graphs[p] = new TGraphAsymmErrors();
+  }
+  first[nums.size()] = k.size();
+
+  unsigned int size = k.size();
+  std::vector<Double_t> eff(size), low(size), up(size);
+  if(size > 0) Intervals(&k[0], &n[0], &eff[0], &low[0], &up[0], size);
+
+  // fill the graphs
+  for(unsigned int p=0; p<nums.size(); p++){
+    TGraphAsymmErrors *gr = graphs[p];
+    if(!gr) continue;
+
+    TAxis *axis = dens[p]->GetXaxis();
+    Int_t point = 0;
+    for(unsigned int i=first[p]; i<first[p+1]; i++){
+      Double_t x = axis->GetBinCenter(bin[i]);
+      Double_t ex = 0.5*axis->GetBinWidth(bin[i]);
+      gr->SetPoint(point, x, eff[i]);
+      gr->SetPointError(point, ex, ex, eff[i]-low[i], up[i]-eff[i]);
+      point++;
+    }
+
+    gr->SetName(Form("%s_eff", nums[p]->GetName()));
+    gr->SetTitle(Form("%s;%s;Efficiency", nums[p]->GetTitle(), axis->GetTitle()));
+    gr->SetMinimum(0.);
+    gr->SetMaximum(1.05);
+  }
+
+  return graphs;
+}
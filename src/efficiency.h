@@ -0,0 +1,65 @@
+/** @file efficiency.h
+    @brief Header file for the efficiency engine
+*/
+
+#ifndef EFFICIENCY_H
+#define EFFICIENCY_H
+
+#include <vector>
+#include <map>
+
+#include <TROOT.h>
+#include <TString.h>
+#include <TH1.h>
+#include <TGraphAsymmErrors.h>
+
+enum EffInterval {
+  kClopperPearson,
+  kJeffreys,
+  kWilson
+};
+
+/** Efficiencies (pass/total) of many histogram pairs at once.
+
+    The bins of all the pairs are gathered in contiguous arrays and the
+    intervals of all of them are computed in one go: Wilson intervals
+    are closed formulas evaluated in a vectorised loop, and the beta
+    quantiles needed by Clopper-Pearson and Jeffreys intervals are
+    cached by (k, n), since the same counts appear again and again in
+    trigger/selection efficiencies. The cache lives as long as the
+    engine, i.e. one plot or one set of pairs.
+*/
+class Efficiency {
+
+ public:
+  Efficiency(EffInterval interval=kClopperPearson, Double_t level=0.682689);
+
+  void SetInterval(EffInterval interval) { m_interval = interval; }
+  void SetLevel(Double_t level) { m_level = level; }
+
+  TGraphAsymmErrors* Compute(TH1 *num, TH1 *den);
+  std::vector<TGraphAsymmErrors*> Compute(std::vector<TH1*> nums, std::vector<TH1*> dens);
+
+  void Intervals(const Double_t *k, const Double_t *n, Double_t *eff,
+                 Double_t *low, Double_t *up, unsigned int size);
+
+  static TString GetIntervalName(EffInterval);
+  static EffInterval GetIntervalFromName(TString);
+  static void SetLogMinimum(TGraphAsymmErrors *gr);
+
+ private:
+  void BetaIntervals(const Double_t *k, const Double_t *n, Double_t *low, Double_t *up, unsigned int size);
+  void WilsonIntervals(const Double_t *k, const Double_t *n, Double_t *low, Double_t *up, unsigned int size);
+
+  struct QuantileKey {
+    int interval;
+    Double_t level, k, n;
+    bool operator<(const QuantileKey &o) const;
+  };
+
+  EffInterval m_interval;
+  Double_t m_level;
+  std::map<QuantileKey, std::pair<Double_t, Double_t> > m_quantiles; // beta quantiles already computed
+};
+
+#endif
@@ -0,0 +1,401 @@
+/** @file export.cxx
+    @brief Exporter and ExportDialog implementation
+*/
+
+#include <TSystem.h>
+#include <TDirectory.h>
+#include <TObjArray.h>
+#include <TObjString.h>
+#include <TKey.h>
+#include <TGLabel.h>
+#include <TGLayout.h>
+
+#include "common.h"
+#include "export.h"
+#include "filepool.h"
+#include "workers.h"
+#include "stats.h"
+
+// object with the names of the canvases, in order, in the canvases file
+static const char *export_names_key = "plotter_export_names";
+
+const char *Exporter::screen_only = "plotter_screen_only";
+
+/** An object taken out of a pad, with its draw option */
+struct PadObject {
+  TVirtualPad *pad;
+  TObject *obj;
+  TString option;
+};
+
+/** Take the screen only objects out of the pad and its subpads */
+static void remove_screen_only(TVirtualPad *pad, std::vector<PadObject> &removed)
+{
+  TList *primitives = pad->GetListOfPrimitives();
+  std::vector<PadObject> found;
+
+  TIter next(primitives);
+  TObject *obj;
+  while((obj = next())){
+    if(obj->InheritsFrom("TVirtualPad")) remove_screen_only((TVirtualPad*)obj, removed);
+    else if(TString(obj->GetName()) == Exporter::screen_only) {
+      PadObject po = { pad, obj, next.GetOption() };
+      found.push_back(po);
+    }
+  }
+
+  for(unsigned int k=0; k<found.size(); k++) primitives->Remove(found[k].obj);
+  removed.insert(removed.end(), found.begin(), found.end());
+}
+
+ExportInfo::ExportInfo() :
+  dir("."),
+  name("plots"),
+  formats("pdf,png"),
+  dpi(96),
+  jobs(number_of_cores()),
+  accepted(false)
+{
+}
+
+TString Exporter::m_program = "plotter";
+
+Exporter::Exporter(TString dir, TString name) :
+  m_dir(dir),
+  m_name(name),
+  m_file(""),
+  m_formats_list(""),
+  do_pdf(false),
+  do_root(false),
+  m_dpi(96),
+  m_jobs(number_of_cores()),
+  m_input(0)
+{
+}
+
+/** Comma separated list of formats */
+void Exporter::SetFormats(TString formats)
+{
+  m_formats_list = formats;
+  m_formats.clear();
+  do_pdf = false;
+  do_root = false;
+
+  TObjArray *tokens = formats.Tokenize(",");
+  for(Int_t k=0; k<tokens->GetEntriesFast(); k++){
+    TString fmt = ((TObjString*)tokens->At(k))->GetString();
+    fmt.ToLower();
+    if(fmt == "pdf")       do_pdf = true;
+    else if(fmt == "root") do_root = true;
+    else                   m_formats.push_back(fmt);
+  }
+  delete tokens;
+}
+
+void Exporter::Add(TCanvas *c, TString name)
+{
+  m_canvases.push_back(c);
+  m_names.push_back(name);
+}
+
+/** Export all the canvases. Returns the number of failed workers */
+int Exporter::Export()
+{
+  if(m_canvases.empty()) return 0;
+
+  gSystem->mkdir(m_dir, kTRUE);
+
+  // the workers read the canvases from this file
+  if(do_root) m_file = m_dir + "/" + m_name + ".root";
+  else m_file = Form("%s/plotter_export_%i.root", gSystem->TempDirectory(), gSystem->GetPid());
+
+  {
+    TDirectory::TContext ctx(gDirectory);
+    TFile file(m_file, "recreate");
+    TString names = "";
+    for(unsigned int k=0; k<m_canvases.size(); k++){
+      std::vector<PadObject> removed;
+      remove_screen_only(m_canvases[k], removed);
+      m_canvases[k]->Write(m_names[k]);
+      for(unsigned int r=0; r<removed.size(); r++)
+        removed[r].pad->GetListOfPrimitives()->Add(removed[r].obj, removed[r].option);
+      names += m_names[k] + "\n";
+    }
+    // the order of the pages
+    TObjString(names).Write(export_names_key);
+    file.Close();
+  }
+
+  int failed = 0;
+  if(gROOT->IsBatch()) failed = ExportFile(m_file);
+  else failed = RunExportProcess();
+
+  if(!do_root) gSystem->Unlink(m_file);
+
+  if(failed) {
+    error("Export failed");
+  }
+  else {
+    msg("Canvases exported to " << m_dir);
+  }
+
+  return failed;
+}
+
+/** Quoted for the shell */
+static TString quote(TString arg)
+{
+  arg.ReplaceAll("'", "'\\''");
+  return "'" + arg + "'";
+}
+
+/** Run plotter --export-canvases on the canvases file and wait for it */
+int Exporter::RunExportProcess()
+{
+  TString cmd = Form("%s --export-canvases %s --output %s --name %s --formats %s --dpi %i --jobs %u",
+                     quote(m_program).Data(), quote(m_file).Data(), quote(m_dir).Data(), quote(m_name).Data(),
+                     quote(m_formats_list).Data(), m_dpi, m_jobs);
+
+  msg("Exporting " << m_canvases.size() << " canvases in a batch process");
+  return gSystem->Exec(cmd) == 0 ? 0 : 1;
+}
+
+/** Export the canvases of a file (written by Export, or any file of
+    canvases), in batch mode. Returns the number of failed workers */
+int Exporter::ExportFile(TString filename)
+{
+  m_file = filename;
+  m_names.clear();
+
+  TFile *file = TFile::Open(m_file);
+  if(!file || file->IsZombie()) {
+    error("Cannot open " << m_file);
+    delete file;
+    return 1;
+  }
+
+  TObjString *names = 0;
+  file->GetObject(export_names_key, names);
+  if(names) {
+    TObjArray *tokens = names->GetString().Tokenize("\n");
+    for(Int_t k=0; k<tokens->GetEntriesFast(); k++)
+      m_names.push_back(((TObjString*)tokens->At(k))->GetString());
+    delete tokens;
+    delete names;
+  }
+  else {
+    TIter next(file->GetListOfKeys());
+    TKey *key;
+    while((key = (TKey*)next())) {
+      if(TString(key->GetClassName()) == "TCanvas") m_names.push_back(key->GetName());
+    }
+  }
+
+  file->Close();
+  delete file;
+
+  if(m_names.empty()) return 0;
+
+  gSystem->mkdir(m_dir, kTRUE);
+
+  unsigned int n_jobs = (m_formats.empty() ? 0 : m_names.size()) + (do_pdf ? 1 : 0);
+  unsigned int n_workers = std::min((unsigned int)m_jobs, n_jobs);
+  if(n_jobs == 0) return 0;
+
+  msg("Exporting " << m_names.size() << " canvases with " << n_workers << " workers");
+
+  // workers can't share the open files
+  FilePool::Instance()->CloseAll();
+
+  return fork_workers(n_workers, RunWorker, this);
+}
+
+/** Job 0 is the multi-page pdf (if requested), then one job for each
+    canvas. Each worker makes one of every n_workers jobs */
+bool Exporter::RunWorker(unsigned int worker, unsigned int n_workers, void *data)
+{
+  Exporter *e = (Exporter*)data;
+
+  e->m_input = TFile::Open(e->m_file);
+  if(!e->m_input) {
+    error("Cannot open " << e->m_file);
+    return false;
+  }
+
+  unsigned int first = e->do_pdf ? 1 : 0;
+  unsigned int n_jobs = (e->m_formats.empty() ? 0 : e->m_names.size()) + first;
+
+  for(unsigned int job=worker; job<n_jobs; job+=n_workers){
+    if(e->do_pdf && job == 0) e->ExportPDF();
+    else e->ExportCanvas(job-first);
+  }
+
+  e->m_input->Close();
+  delete e->m_input;
+  e->m_input = 0;
+  return true;
+}
+
+/** Copy of canvas k read from the file, drawn off screen (batch mode) */
+TCanvas* Exporter::GetCanvas(unsigned int k)
+{
+  TCanvas *c = 0;
+  m_input->GetObject(m_names[k], c);
+  if(c) c->Draw();
+  return c;
+}
+
+void Exporter::ReleaseCanvas(TCanvas *c)
+{
+  delete c;
+}
+
+/** One file for each format */
+void Exporter::ExportCanvas(unsigned int k)
+{
+  TCanvas *c = GetCanvas(k);
+  if(!c) return;
+
+  ScopedTimer timer(kStageExport);
+
+  TString name = m_dir + "/" + m_names[k];
+
+  for(unsigned int f=0; f<m_formats.size(); f++){
+    if(m_formats[f] == "png" && m_dpi != 96) {
+      UInt_t w = c->GetWw();
+      UInt_t h = c->GetWh();
+      c->SetCanvasSize(UInt_t(w*m_dpi/96.), UInt_t(h*m_dpi/96.));
+      c->Print(name + ".png");
+      c->SetCanvasSize(w, h);
+    }
+    else c->Print(name + "." + m_formats[f]);
+  }
+
+  ReleaseCanvas(c);
+}
+
+/** All the canvases in a multi-page pdf, in one pass */
+void Exporter::ExportPDF()
+{
+  TString name = m_dir + "/" + m_name + ".pdf";
+
+  TCanvas *last = 0;
+  for(unsigned int k=0; k<m_names.size(); k++){
+    TCanvas *c = GetCanvas(k);
+    if(!c) continue;
+
+    if(last) ReleaseCanvas(last);
+    else c->Print(name + "[");
+
+    c->Print(name, "Title:" + m_names[k]);
+    last = c;
+  }
+
+  if(last) {
+    last->Print(name + "]");
+    ReleaseCanvas(last);
+  }
+}
+
+enum ExportDialogId {
+  B_EXPORT_OK,
+  B_EXPORT_CANCEL
+};
+
+/** Modal dialog: returns when it's closed. info->accepted is true if the
+    export button was pressed */
+ExportDialog::ExportDialog(const TGWindow *p, const TGWindow *main, ExportInfo *info) :
+  TGTransientFrame(p, main, 300, 300),
+  m_info(info)
+{
+  SetCleanup(kDeepCleanup);
+
+  TGLayoutHints *layout = new TGLayoutHints(kLHintsExpandX, 2, 2, 2, 2);
+
+  TGHorizontalFrame *frame_dir = new TGHorizontalFrame(this);
+  frame_dir->AddFrame(new TGLabel(frame_dir, "Directory"), new TGLayoutHints(kLHintsLeft, 2, 2, 4, 2));
+  frame_dir->AddFrame(entry_dir = new TGTextEntry(frame_dir, m_info->dir), new TGLayoutHints(kLHintsRight | kLHintsExpandX, 2, 2, 2, 2));
+  AddFrame(frame_dir, layout);
+
+  TGHorizontalFrame *frame_name = new TGHorizontalFrame(this);
+  frame_name->AddFrame(new TGLabel(frame_name, "Name"), new TGLayoutHints(kLHintsLeft, 2, 2, 4, 2));
+  frame_name->AddFrame(entry_name = new TGTextEntry(frame_name, m_info->name), new TGLayoutHints(kLHintsRight | kLHintsExpandX, 2, 2, 2, 2));
+  entry_name->SetToolTipText("Name of the multi-page pdf and the root file. The other files are named as the canvases.");
+  AddFrame(frame_name, layout);
+
+  TGGroupFrame *group_formats = new TGGroupFrame(this, "Formats", kVerticalFrame);
+  group_formats->AddFrame(check_pdf  = new TGCheckButton(group_formats, "pdf (all canvases in one file)"), layout);
+  group_formats->AddFrame(check_png  = new TGCheckButton(group_formats, "png"), layout);
+  group_formats->AddFrame(check_svg  = new TGCheckButton(group_formats, "svg"), layout);
+  group_formats->AddFrame(check_eps  = new TGCheckButton(group_formats, "eps"), layout);
+  group_formats->AddFrame(check_root = new TGCheckButton(group_formats, "root (all canvases in one file)"), layout);
+  AddFrame(group_formats, layout);
+
+  check_pdf->SetState(m_info->formats.Contains("pdf") ? kButtonDown : kButtonUp);
+  check_png->SetState(m_info->formats.Contains("png") ? kButtonDown : kButtonUp);
+  check_svg->SetState(m_info->formats.Contains("svg") ? kButtonDown : kButtonUp);
+  check_eps->SetState(m_info->formats.Contains("eps") ? kButtonDown : kButtonUp);
+  check_root->SetState(m_info->formats.Contains("root") ? kButtonDown : kButtonUp);
+
+  TGHorizontalFrame *frame_dpi = new TGHorizontalFrame(this);
+  frame_dpi->AddFrame(new TGLabel(frame_dpi, "png dpi"), new TGLayoutHints(kLHintsLeft, 2, 2, 4, 2));
+  frame_dpi->AddFrame(nentry_dpi = new TGNumberEntry(frame_dpi, m_info->dpi, 5, -1, TGNumberFormat::kNESInteger, TGNumberFormat::kNEAPositive), new TGLayoutHints(kLHintsRight, 2, 2, 2, 2));
+  AddFrame(frame_dpi, layout);
+
+  TGHorizontalFrame *frame_jobs = new TGHorizontalFrame(this);
+  frame_jobs->AddFrame(new TGLabel(frame_jobs, "Workers"), new TGLayoutHints(kLHintsLeft, 2, 2, 4, 2));
+  frame_jobs->AddFrame(nentry_jobs = new TGNumberEntry(frame_jobs, m_info->jobs, 5, -1, TGNumberFormat::kNESInteger, TGNumberFormat::kNEAPositive), new TGLayoutHints(kLHintsRight, 2, 2, 2, 2));
+  AddFrame(frame_jobs, layout);
+
+  TGHorizontalFrame *frame_buttons = new TGHorizontalFrame(this);
+  TGTextButton *button_ok = new TGTextButton(frame_buttons, "Export", B_EXPORT_OK);
+  TGTextButton *button_cancel = new TGTextButton(frame_buttons, "Cancel", B_EXPORT_CANCEL);
+  button_ok->Associate(this);
+  button_cancel->Associate(this);
+  frame_buttons->AddFrame(button_ok, new TGLayoutHints(kLHintsExpandX, 2, 2, 2, 2));
+  frame_buttons->AddFrame(button_cancel, new TGLayoutHints(kLHintsExpandX, 2, 2, 2, 2));
+  AddFrame(frame_buttons, new TGLayoutHints(kLHintsExpandX | kLHintsBottom, 2, 2, 10, 2));
+
+  SetWindowName("Export canvases");
+  MapSubwindows();
+  Resize(GetDefaultSize());
+  CenterOnParent();
+  MapWindow();
+
+  m_info->accepted = false;
+  gClient->WaitFor(this);
+}
+
+ExportDialog::~ExportDialog()
+{
+  Cleanup();
+}
+
+void ExportDialog::CloseWindow()
+{
+  DeleteWindow();
+}
+
+Bool_t ExportDialog::ProcessMessage(Long_t msg, Long_t parm1, Long_t)
+{
+  if(GET_MSG(msg) != kC_COMMAND || GET_SUBMSG(msg) != kCM_BUTTON) return kTRUE;
+
+  if(parm1 == B_EXPORT_OK) {
+    m_info->dir = entry_dir->GetText();
+    m_info->name = entry_name->GetText();
+
+    m_info->formats = "";
+    if(check_pdf->IsOn())  m_info->formats += "pdf,";
+    if(check_png->IsOn())  m_info->formats += "png,";
+    if(check_svg->IsOn())  m_info->formats += "svg,";
+    if(check_eps->IsOn())  m_info->formats += "eps,";
+    if(check_root->IsOn()) m_info->formats += "root,";
+
+    m_info->dpi = nentry_dpi->GetIntNumber();
+    m_info->jobs = nentry_jobs->GetIntNumber();
+    m_info->accepted = true;
+  }
+
+  CloseWindow();
+  return kTRUE;
+}
@@ -0,0 +1,112 @@
+/** @file export.h
+    @brief Header file for the export of canvases
+*/
+
+#ifndef EXPORT_H
+#define EXPORT_H
+
+#include <vector>
+
+#include <TROOT.h>
+#include <TString.h>
+#include <TCanvas.h>
+#include <TFile.h>
+#include <TGFrame.h>
+#include <TGButton.h>
+#include <TGTextEntry.h>
+#include <TGNumberEntry.h>
+
+/** Export options (filled by the export dialog) */
+struct ExportInfo {
+  ExportInfo();
+
+  TString dir;
+  TString name;     // multi-page pdf and root file name (without extension)
+  TString formats;  // comma separated: pdf,png,svg,eps,root
+  Int_t dpi;        // png resolution (96 = canvas size)
+  UInt_t jobs;
+  bool accepted;
+};
+
+/** Export many canvases to several formats at once.
+
+    All the canvases are first written to a ROOT file (kept if the root
+    format is requested), and then worker processes read them back in
+    batch mode and print them: png/svg/eps are one file per canvas and
+    pdf is a single multi-page file made in one pass by one of the
+    workers, while the others make the rest of the files.
+
+    From the gui the export runs in a new plotter process in batch mode
+    (plotter --export-canvases FILE), so the workers are not forked from
+    a process connected to the X server, and the canvases are drawn off
+    screen with the size needed for the dpi. The objects named
+    screen_only (e.g. the I/O stats of the tree draws) are not exported.
+*/
+class Exporter {
+
+ public:
+  Exporter(TString dir, TString name);
+
+  void SetFormats(TString);
+  void SetDpi(Int_t dpi) { m_dpi = (dpi > 0) ? dpi : 96; }
+  void SetJobs(UInt_t n) { m_jobs = (n > 0) ? n : 1; }
+
+  void Add(TCanvas *c, TString name);
+  int Export();
+  int ExportFile(TString filename);
+
+  static void SetProgram(TString program) { m_program = program; }
+
+  static const char *screen_only; // name of the objects only shown on the screen
+
+ private:
+  int RunExportProcess();
+  static bool RunWorker(unsigned int, unsigned int, void*);
+  TCanvas* GetCanvas(unsigned int);
+  void ReleaseCanvas(TCanvas*);
+  void ExportCanvas(unsigned int);
+  void ExportPDF();
+
+  TString m_dir;
+  TString m_name;
+  TString m_file;
+  TString m_formats_list;
+  std::vector<TString> m_formats; // one file per canvas
+  bool do_pdf;
+  bool do_root;
+  Int_t m_dpi;
+  UInt_t m_jobs;
+
+  std::vector<TCanvas*> m_canvases; // only in the process that writes the file
+  std::vector<TString> m_names;
+
+  TFile *m_input; // canvases file, only in the workers
+
+  static TString m_program; // plotter executable, for the export process
+};
+
+/** Dialog to choose the export options */
+class ExportDialog : public TGTransientFrame {
+
+ public:
+  ExportDialog(const TGWindow *p, const TGWindow *main, ExportInfo *info);
+  virtual ~ExportDialog();
+
+  virtual void CloseWindow();
+  virtual Bool_t ProcessMessage(Long_t msg, Long_t parm1, Long_t parm2);
+
+ private:
+  ExportInfo *m_info;
+
+  TGTextEntry *entry_dir;
+  TGTextEntry *entry_name;
+  TGCheckButton *check_pdf;
+  TGCheckButton *check_png;
+  TGCheckButton *check_svg;
+  TGCheckButton *check_eps;
+  TGCheckButton *check_root;
+  TGNumberEntry *nentry_dpi;
+  TGNumberEntry *nentry_jobs;
+};
+
+#endif
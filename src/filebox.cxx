@@ -4,27 +4,20 @@
 #include <TGResourcePool.h>
 
 #include "filebox.h"
+#include "stats.h"
 
 ClassImp(FileBox);
 
-FileBox::FileBox(TGWindow *main, UInt_t w, UInt_t h, TString filename) :
+FileBox::FileBox(TGWindow *main, UInt_t w, UInt_t h, Catalog *catalog) :
   TGVerticalFrame(main, w, h, kVerticalFrame),
-  entry(0)
+  m_catalog(catalog)
 {
   SetCleanup(kDeepCleanup);
 
-  m_file = new TFile(filename, "open");
+  CreateGui(m_catalog->GetShortName());
 
-  filename.ReplaceAll(".root","");
-  while(filename.Contains("/")){
-    filename = filename(filename.Index("/")+1, filename.Length());
-  }
-
-  CreateGui(filename);
-
-  parent = new ParentItem(0, "", "", Dir);
-
-  BrowseDir(parent);
+  // The file is scanned the first time its box is shown
+  m_catalog->Scan();
 
   ShowItems();
 
@@ -35,8 +28,6 @@ FileBox::FileBox(TGWindow *main, UInt_t w, UInt_t h, TString filename) :
 
 FileBox::~FileBox()
 {
-  m_file->Close();
-  delete m_file;
   delete m_header;
   delete m_content;
 }
@@ -76,77 +67,21 @@ void FileBox::CreateGui(TString filename)
   MapWindow();
 }
 
-void FileBox::BrowseDir(ParentItem* pt)
+/** Entry of an item. Branches show their size on disk, on a background
+    from white to red (the largest branch of the tree) */
+TGIconLBEntry* FileBox::CreateEntry(Item *item)
 {
-  last_path = current_path;
-  current_path = pt->GetName();;
-
-  TDirectory *dir = m_file->GetDirectory(pt->GetName());
-
-  TIter next(dir->GetListOfKeys());
-  TKey *key;
-  TObject *obj;
-  TString name, title;
-
-  while ((key=(TKey*)next())) {
-
-    obj  = key->ReadObj() ;
-    name = obj->GetName();
-    title = obj->GetTitle();
-
-    if(name.IsNull()) name = obj->GetTitle();
-
-    if(key->IsFolder()){
-      if(obj->InheritsFrom("TTree")){
-        ParentItem *it = new ParentItem(entry, name, title, Tree);
-        pt->AddItem(it);
-        entry++;
-        BrowseTree(it);
-
-      }
-      else{
-        ParentItem *it = new ParentItem(entry, name, title, Dir);
-        pt->AddItem(it);
-        entry++;
-        BrowseDir(it);
-      }
-    }
-    else if(obj->InheritsFrom("TH1")) {
-      Item *it;
-      if(obj->InheritsFrom("TH3"))
-        it = new Item(entry, name, title, Hist3D);
-      else if(obj->InheritsFrom("TH2"))
-        it = new Item(entry, name, title, Hist2D);
-      else
-        it = new Item(entry, name, title, Hist1D);
-      pt->AddItem(it);
-      entry++;
-    }
-    else if (obj->InheritsFrom("TGraph")) {
-      Item *it = new Item(entry, name, title, Graph);
-      pt->AddItem(it);
-      entry++;
-    }
+  TString text = item->GetText();
+  Pixel_t back = GetWhitePixel();
 
+  BranchItem *branch = dynamic_cast<BranchItem*>(item);
+  if(branch) {
+    text += Form("  (%s)", format_bytes(branch->GetZipBytes()).Data());
+    back = branch->GetHeatColor();
   }
 
-}
-
-void FileBox::BrowseTree(ParentItem *pt)
-{
-  TTree *t = new TTree(pt->GetName(), "");
-  m_file->GetObject(pt->GetName(), t);
-
-  TObjArray *l = t->GetListOfBranches();
-  int nbranches = l->GetSize();
-  for(Int_t k=0; k<nbranches; k++){
-    TObject *branch = l->At(k);
-    if(!branch) continue;
-    Item *it = new Item(entry, branch->GetName(), branch->GetTitle(), Branch);
-    pt->AddItem(it);
-    entry++;
-  }
-
+  return new TGIconLBEntry(m_content->GetContainer(), item->GetId(), text,
+                           gClient->GetPicture(item->GetIcon()), 0, kVerticalFrame, back);
 }
 
 /** Clear and then display the list of items in the ListBox  */
@@ -154,33 +89,23 @@ void FileBox::ShowItems()
 {
   m_content->RemoveAll();
 
+  ParentItem *parent = m_catalog->GetRoot();
   for(unsigned int k=0; k<parent->GetN(); k++){
-    TGIconLBEntry *it = new TGIconLBEntry(m_content->GetContainer(),
-                                          parent->GetItem(k)->GetId(),
-                                          parent->GetItem(k)->GetText(),
-                                          gClient->GetPicture(parent->GetItem(k)->GetIcon()),
-                                          0, kVerticalFrame,
-                                          GetWhitePixel());
-    m_content->AddEntry(it, new TGLayoutHints(kLHintsExpandX));
+    m_content->AddEntry(CreateEntry(parent->GetItem(k)), new TGLayoutHints(kLHintsExpandX));
   }
 
   RefreshGui();
 }
 
 
-void FileBox::OpenItem(int id)
+void FileBox::OpenItem(ParentItem *pt)
 {
-  ParentItem *pt = (ParentItem*)parent->GetItemFromId(id);
+  // children are inserted one after the other below the parent
+  Int_t after = pt->GetId();
 
   for(unsigned int k=0; k<pt->GetN(); k++){
-    TGIconLBEntry *it = new TGIconLBEntry(m_content->GetContainer(),
-                                          pt->GetItem(k)->GetId(),
-                                          pt->GetItem(k)->GetText(),
-                                          gClient->GetPicture(pt->GetItem(k)->GetIcon()),
-                                          0, kVerticalFrame,
-                                          GetWhitePixel());
-
-    m_content->InsertEntry(it, new TGLayoutHints(kLHintsExpandX), id+k);
+    m_content->InsertEntry(CreateEntry(pt->GetItem(k)), new TGLayoutHints(kLHintsExpandX), after);
+    after = pt->GetItem(k)->GetId();
   }
 
   pt->ToggleStatus();
@@ -188,12 +113,13 @@ void FileBox::OpenItem(int id)
   RefreshGui();
 }
 
-void FileBox::CloseItem(int id)
+void FileBox::CloseItem(ParentItem *pt)
 {
-  ParentItem *pt = (ParentItem*) parent->GetItemFromId(id);
-
   for(unsigned int k=0; k<pt->GetN(); k++){
-    m_content->RemoveEntry(id+k+1);
+    Item *it = pt->GetItem(k);
+    if((it->IsDir() || it->IsTree()) && ((ParentItem*)it)->IsOpen())
+      CloseItem((ParentItem*)it);
+    m_content->RemoveEntry(it->GetId());
   }
 
   pt->ToggleStatus();
@@ -202,9 +128,12 @@ void FileBox::CloseItem(int id)
 
 void FileBox::Clear()
 {
-  for(unsigned int i=0; i<parent->GetN();i++){
-    parent->GetItem(i)->SetStatus(false);
-    m_content->GetEntry(parent->GetItem(i)->GetId())->Activate(false);
+  for(unsigned int i=0; i<m_catalog->GetN(); i++){
+    Item *it = m_catalog->GetItem(i);
+    if(!it->IsPlotable()) continue;
+    it->SetStatus(false);
+    TGLBEntry *e = m_content->GetEntry(it->GetId());
+    if(e) e->Activate(false);
   }
 
   RefreshGui();
@@ -223,17 +152,23 @@ void FileBox::RefreshGui()
    ---- */
 void FileBox::OnItemClick(Int_t id)
 {
-  //  if(parent->GetItem(k)->IsPlotable()) return;
+  if(id < 0 || id >= (Int_t)m_catalog->GetN()) return;
+  Item *it = GetItem(id);
 
-  if(parent->GetItemFromId(id)->IsTree() || parent->GetItemFromId(id)->IsDir()){
-    if(((ParentItem*)parent->GetItemFromId(id))->IsOpen()) CloseItem(id);
-    else OpenItem(id);
+  if(it->IsTree() || it->IsDir()){
+    if(((ParentItem*)it)->IsOpen()) CloseItem((ParentItem*)it);
+    else OpenItem((ParentItem*)it);
   }
 
+  ItemClicked((Long_t)it);
 }
 
 void FileBox::OnItemDoubleClick(TGFrame* f, Int_t btn)
 {
+  Int_t id = ((TGLBEntry*)f)->EntryId();
+  if(btn == 1 && id >= 0 && id < (Int_t)m_catalog->GetN())
+    ItemDoubleClicked((Long_t)GetItem(id));
+
   // if (btn!=kButton1) return;
 
   // TGLBEntry *entry = (TGLBEntry *)f;
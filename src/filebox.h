@@ -17,19 +17,18 @@
 
 #include "common.h"
 #include "item.h"
+#include "catalog.h"
 
 class FileBox  : public TGVerticalFrame {
 
 public:
-  FileBox(TGWindow *main, UInt_t, UInt_t, TString);
+  FileBox(TGWindow *main, UInt_t, UInt_t, Catalog*);
   ~FileBox();
 
-  Item* GetItem(int entry) { return parent->GetItem(entry); };
+  Item* GetItem(int entry) { return m_catalog->GetItem(entry); };
   TString GetHeaderText() { return m_header->GetText(); };
   TGListBox* GetContent() { return m_content; };
-  TFile* GetFile() { return m_file; };
-  TDirectory* GetCurrentDir()  { return m_file->GetDirectory(current_path); };
-  TTree* GetCurrentTree() {  return (TTree*)m_file->Get(current_path); };
+  Catalog* GetCatalog() { return m_catalog; };
 
   void Clear();
 
@@ -37,24 +36,20 @@ public:
   void OnItemDoubleClick(TGFrame*, Int_t);
   void OnItemClick(Int_t);
 
+  //signals (with the Item* of the entry)
+  void ItemClicked(Long_t item) { Emit("ItemClicked(Long_t)", item); } // *SIGNAL*
+  void ItemDoubleClicked(Long_t item) { Emit("ItemDoubleClicked(Long_t)", item); } // *SIGNAL*
+
  protected:
   void CreateGui(TString);
   void RefreshGui();
 
-  void BrowseDir(ParentItem*);
-  void BrowseTree(ParentItem*);
-
   void ShowItems();
-  void OpenItem(int);
-  void CloseItem(int);
-
-  TFile *m_file;
-  //  std::vector<Item*> m_items;
-
-  ParentItem *parent;
-  int entry;
+  TGIconLBEntry* CreateEntry(Item*);
+  void OpenItem(ParentItem*);
+  void CloseItem(ParentItem*);
 
-  TString last_path, current_path;
+  Catalog *m_catalog;
 
   //gui
   TGTextEntry *m_header;
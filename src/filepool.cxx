@@ -0,0 +1,128 @@
+/** @file filepool.cxx
+    @brief FilePool class implementation
+*/
+
+#include <TH1.h>
+#include <TDirectory.h>
+
+#include "common.h"
+#include "filepool.h"
+#include "stats.h"
+#include "trace.h"
+
+FilePool* FilePool::Instance()
+{
+  static FilePool pool;
+  return &pool;
+}
+
+FilePool::FilePool() :
+  m_max_open(50)
+{
+}
+
+FilePool::~FilePool()
+{
+  CloseAll();
+}
+
+void FilePool::SetMaxOpen(unsigned int n)
+{
+  m_max_open = (n > 0) ? n : 1;
+  Trim();
+}
+
+/** Return the open file, opening it (and closing the least recently
+    used one if needed). The pointer is valid until the next call to Get */
+TFile* FilePool::Get(TString filename)
+{
+  std::map<TString, TFile*>::iterator it = m_files.find(filename);
+
+  if(it != m_files.end()){
+    Trace::Instance()->Instant("pool_hit", "cache", filename);
+    Touch(filename);
+    return it->second;
+  }
+
+  Trace::Instance()->Instant("pool_miss", "cache", filename);
+
+  // make room before opening, so we never go above the limit
+  while(m_files.size() >= m_max_open && !m_lru.empty())
+    Close(m_lru.back());
+
+  ScopedTimer timer(kStageOpen, filename);
+  Stats::Instance()->Count(kCountFilesOpened);
+
+  TDirectory::TContext ctx(gDirectory); // keep gDirectory unchanged
+  TFile *file = TFile::Open(filename, "read");
+  if(!file || file->IsZombie()){
+    error("Cannot open file " << filename);
+    delete file;
+    return 0;
+  }
+
+  m_files[filename] = file;
+  m_lru.push_front(filename);
+
+  return file;
+}
+
+/** Read an object from the file and detach it, so the caller owns it */
+TObject* FilePool::ReadObject(TString filename, TString path, TString name)
+{
+  TFile *file = Get(filename);
+  if(!file) return 0;
+
+  TDirectory *dir = path.IsNull() ? file : file->GetDirectory(path);
+  if(!dir) return 0;
+
+  ScopedTimer timer(kStageRead, path.IsNull() ? name : path + "/" + name);
+  Stats::Instance()->Count(kCountObjectsRead);
+
+  TObject *obj = dir->Get(name);
+  if(obj && obj->InheritsFrom("TH1"))
+    ((TH1*)obj)->SetDirectory(0);
+
+  return obj;
+}
+
+/** Return a tree owned by the file. It is only valid until the next
+    call to Get, so don't keep it */
+TTree* FilePool::GetTree(TString filename, TString path)
+{
+  TFile *file = Get(filename);
+  if(!file) return 0;
+
+  return (TTree*)file->Get(path);
+}
+
+void FilePool::Close(TString filename)
+{
+  std::map<TString, TFile*>::iterator it = m_files.find(filename);
+  if(it == m_files.end()) return;
+
+  it->second->Close();
+  delete it->second;
+
+  m_files.erase(it);
+  m_lru.remove(filename);
+}
+
+void FilePool::CloseAll()
+{
+  while(!m_lru.empty())
+    Close(m_lru.back());
+}
+
+void FilePool::Touch(TString filename)
+{
+  if(m_lru.front() == filename) return;
+  m_lru.remove(filename);
+  m_lru.push_front(filename);
+}
+
+void FilePool::Trim()
+{
+  while(m_files.size() > m_max_open && !m_lru.empty())
+    Close(m_lru.back());
+}
@@ -0,0 +1,53 @@
+/** @file filepool.h
+    @brief Header file for the pool of open files
+*/
+
+#ifndef FILEPOOL_H
+#define FILEPOOL_H
+
+#include <list>
+#include <map>
+
+#include <TROOT.h>
+#include <TString.h>
+#include <TFile.h>
+#include <TTree.h>
+
+/** Bounded pool of open TFiles.
+
+    Files are opened on demand. When more than max_open files are open
+    the least recently used one is closed, and it is reopened the next
+    time it is needed. Objects read through the pool are detached from
+    the file, so they survive when the file is closed. The memory of the
+    open files is not accounted (nor freed when the memory budget is
+    exceeded): it's only bounded by max_open.
+*/
+class FilePool {
+
+ public:
+  static FilePool* Instance();
+
+  TFile* Get(TString filename);
+  TObject* ReadObject(TString filename, TString path, TString name);
+  TTree* GetTree(TString filename, TString path);
+
+  void Close(TString filename);
+  void CloseAll();
+
+  void SetMaxOpen(unsigned int n);
+  unsigned int GetMaxOpen() { return m_max_open; }
+  unsigned int GetNOpen() { return m_files.size(); }
+
+ private:
+  FilePool();
+  ~FilePool();
+
+  void Touch(TString filename);
+  void Trim();
+
+  unsigned int m_max_open;
+  std::list<TString> m_lru; // front: most recently used
+  std::map<TString, TFile*> m_files;
+};
+
+#endif
@@ -0,0 +1,82 @@
+/** @file ioperf.cxx
+    @brief TreePerf implementation
+*/
+
+#include <TTree.h>
+#include <TFile.h>
+#include <TTreeCache.h>
+#include <TTreePerfStats.h>
+#include <TVirtualPerfStats.h>
+
+#include "ioperf.h"
+#include "stats.h"
+#include "common.h"
+
+/** One line, e.g. "12 reads, 3.1 MB (~9.8 MB unzipped), cache 97%, cpu 0.80 s / real 1.21 s" */
+TString IOStats::GetSummary()
+{
+  TString s = Form("%i reads, %s (~%s unzipped)", read_calls,
+                   format_bytes(bytes_read).Data(), format_bytes(bytes_unzipped).Data());
+  if(cache_efficiency >= 0) s += Form(", cache %.0f%%", 100*cache_efficiency);
+  else s += ", no cache";
+  s += Form(", unzip %.2f s, cpu %.2f s / real %.2f s", unzip_time, cpu_time, real_time);
+  return s;
+}
+
+/** The stats are collected through gPerfStats (file reads) and the tree
+    (basket unzipping): both are set for the lifetime of the object */
+TreePerf::TreePerf(TTree *tree) :
+  m_tree(tree),
+  m_file(tree->GetCurrentFile()),
+  m_perf(0),
+  m_previous(gPerfStats),
+  m_bytes_start(m_file ? m_file->GetBytesRead() : 0)
+{
+  m_perf = new TTreePerfStats("plotter_ioperf", tree);
+  gPerfStats = m_perf;
+}
+
+TreePerf::~TreePerf()
+{
+  Stop();
+}
+
+void TreePerf::Stop()
+{
+  if(!m_perf) return;
+  m_tree->SetPerfStats(0);
+  gPerfStats = m_previous;
+  delete m_perf;
+  m_perf = 0;
+}
+
+IOStats TreePerf::Finish()
+{
+  IOStats io;
+  io.read_calls = 0;
+  io.bytes_read = 0;
+  io.bytes_unzipped = 0;
+  io.cache_efficiency = -1;
+  io.unzip_time = 0;
+  io.cpu_time = 0;
+  io.real_time = 0;
+
+  if(!m_perf) return io;
+
+  m_perf->Finish();
+
+  // the file counters are totals since it was opened
+  io.read_calls = m_perf->GetReadCalls();
+  io.bytes_read = m_file ? m_file->GetBytesRead() - m_bytes_start : 0;
+  io.bytes_unzipped = (Long64_t)(io.bytes_read*m_perf->GetCompress());
+  io.unzip_time = m_perf->GetUnzipTime();
+  io.cpu_time = m_perf->GetCpuTime();
+  io.real_time = m_perf->GetRealTime();
+
+  TTreeCache *cache = m_file ? dynamic_cast<TTreeCache*>(m_file->GetCacheRead(m_tree)) : 0;
+  if(cache) io.cache_efficiency = cache->GetEfficiency();
+
+  Stop();
+
+  return io;
+}
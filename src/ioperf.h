@@ -0,0 +1,49 @@
+/** @file ioperf.h
+    @brief I/O statistics of a tree draw
+*/
+
+#ifndef IOPERF_H
+#define IOPERF_H
+
+#include <TROOT.h>
+#include <TString.h>
+
+class TTree;
+class TFile;
+class TTreePerfStats;
+class TVirtualPerfStats;
+
+/** What a tree draw read from its file */
+struct IOStats {
+  Int_t read_calls;
+  Long64_t bytes_read;     // compressed, from the disk
+  Long64_t bytes_unzipped; // estimated with the compression factor of the tree
+  Double_t cache_efficiency; // fraction of the baskets found in the tree cache, -1 without cache
+  Double_t unzip_time;
+  Double_t cpu_time;
+  Double_t real_time;
+
+  TString GetSummary();
+};
+
+/** Measure the I/O of a tree from the creation to Finish(), with
+    TTreePerfStats */
+class TreePerf {
+
+ public:
+  TreePerf(TTree *tree);
+  ~TreePerf();
+
+  IOStats Finish();
+
+ private:
+  void Stop();
+
+  TTree *m_tree;
+  TFile *m_file;
+  TTreePerfStats *m_perf;
+  TVirtualPerfStats *m_previous;
+  Long64_t m_bytes_start;
+};
+
+#endif
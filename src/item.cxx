@@ -1,8 +1,11 @@
 /** @file item.cxx */
 
+#include <TColor.h>
+
 #include "item.h"
 
-Item::Item(Int_t entry, TString name, TString title, ItemType type) :
+Item::Item(Int_t file, Int_t entry, TString name, TString title, ItemType type) :
+  m_file(file),
   m_entry(entry),
   m_name(name),
   m_title(title),
@@ -10,13 +13,14 @@ Item::Item(Int_t entry, TString name, TString title, ItemType type) :
   m_status(false)
 {
 
-  // Calcula id
-  // file = id/100000-1
-  // entry = id-((id/100000)*100000)
-  //m_id = 100000 * (m_file + 1) + m_entry;
-
+  // id of the list box entry: the entries of a file are all in its own box
   m_id = m_entry;
+}
 
+ParentItem::~ParentItem()
+{
+  for(unsigned int k=0; k<m_items.size(); k++) delete m_items[k];
+  m_items.clear();
 }
 
 TString Item::GetIcon()
@@ -49,3 +53,10 @@ TString Item::GetIcon()
 
   return iconpic;
 }
+
+/** From white (cheap) to red (the largest branch of the tree) */
+Pixel_t BranchItem::GetHeatColor()
+{
+  Int_t level = 255 - (Int_t)(165*m_heat);
+  return TColor::RGB2Pixel(255, level, level);
+}
@@ -7,7 +7,9 @@
 #include <iomanip>
 #include <iostream>
 #include <TString.h>
+#include <GuiTypes.h>
 #include <cmath>
+#include <vector>
 
 #include "common.h"
 
@@ -37,9 +39,12 @@ class Item {
   Int_t     m_id;
 
  public:
-  Item(Int_t entry, TString name, TString title, ItemType type);
+  Item(Int_t file, Int_t entry, TString name, TString title, ItemType type);
+  virtual ~Item() {}
 
   TString GetName() { return m_name; }
+  TString GetPath() { return m_path; }
+  TString GetFullPath() { return m_path.IsNull() ? m_name : m_path + "/" + m_name; }
   TString GetTitle() { return m_title; }
   TString GetText() { return m_name.EqualTo("") ? "no name" : m_name; }
   TString GetLegendText() { return m_title.EqualTo("") ? m_name : m_title; }
@@ -60,6 +65,7 @@ class Item {
 
   void ToggleStatus() { m_status = m_status ? false : true; }
   void SetStatus(bool st) { m_status = st; }
+  void SetPath(TString path) { m_path = path; }
 };
 
 
@@ -69,7 +75,7 @@ class ParentItem : public Item {
   std::vector<Item*> m_items;
 
  public:
-  ParentItem(Int_t entry, TString name, TString title, ItemType type) : Item(entry, name, title, type) { m_items.clear(); };
+  ParentItem(Int_t file, Int_t entry, TString name, TString title, ItemType type) : Item(file, entry, name, title, type) { m_items.clear(); };
   ~ParentItem();
 
   bool IsOpen() { return GetStatus(); }
@@ -82,9 +88,38 @@ class ParentItem : public Item {
       if(m_items[k]->GetId() == id) return m_items[k];
       else continue;
     }
+    return 0;
   }
 
 };
 
 
+/** A branch with its I/O cost, from the tree metadata (no data read) */
+class BranchItem : public Item {
+
+ private:
+  Long64_t m_entries;
+  Long64_t m_tot_bytes; // uncompressed
+  Long64_t m_zip_bytes; // compressed, on disk
+  Int_t    m_baskets;
+  Double_t m_heat;      // zip bytes relative to the largest branch of the tree
+
+ public:
+  BranchItem(Int_t file, Int_t entry, TString name, TString title,
+             Long64_t entries, Long64_t tot_bytes, Long64_t zip_bytes, Int_t baskets) :
+    Item(file, entry, name, title, Branch),
+    m_entries(entries), m_tot_bytes(tot_bytes), m_zip_bytes(zip_bytes), m_baskets(baskets), m_heat(0) { };
+
+  Long64_t GetEntries() { return m_entries; }
+  Long64_t GetTotBytes() { return m_tot_bytes; }
+  Long64_t GetZipBytes() { return m_zip_bytes; }
+  Int_t GetBaskets() { return m_baskets; }
+  Double_t GetCompression() { return m_zip_bytes > 0 ? (Double_t)m_tot_bytes/m_zip_bytes : 0; }
+  Long64_t GetBasketSize() { return m_baskets > 0 ? m_zip_bytes/m_baskets : 0; }
+  Double_t GetHeat() { return m_heat; }
+  void SetHeat(Double_t heat) { m_heat = heat; }
+  Pixel_t GetHeatColor();
+};
+
+
 #endif
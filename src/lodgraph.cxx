@@ -0,0 +1,201 @@
+/** @file lodgraph.cxx
+    @brief LodGraph class implementation
+*/
+
+#include <cmath>
+#include <algorithm>
+
+#include <TVirtualPad.h>
+#include <TVirtualPS.h>
+#include <TH1.h>
+
+#include "lodgraph.h"
+
+ClassImp(LodGraph)
+
+Int_t LodGraph::min_points = 50000;
+
+// columns of the first decimation, before the pad is painted
+static const Int_t initial_columns = 2000;
+
+/** Graphs worth decimating: many points, sorted in x and without errors */
+bool LodGraph::IsLarge(TGraph *g)
+{
+  if(!g || g->GetN() < min_points) return false;
+  if(g->IsA() != TGraph::Class()) return false;
+
+  const Double_t *x = g->GetX();
+  for(Int_t i=1; i<g->GetN(); i++){
+    if(x[i] < x[i-1]) return false;
+  }
+  return true;
+}
+
+LodGraph::LodGraph() :
+  TGraph(),
+  m_full(0),
+  m_owner(true),
+  m_xmin(0.),
+  m_xmax(0.),
+  m_columns(0),
+  m_logx(false)
+{
+}
+
+LodGraph::LodGraph(TGraph *full) :
+  TGraph(),
+  m_full(full),
+  m_owner(false),
+  m_xmin(0.),
+  m_xmax(0.),
+  m_columns(0),
+  m_logx(false)
+{
+  SetName(full->GetName());
+  SetTitle(full->GetTitle());
+  full->TAttLine::Copy(*this);
+  full->TAttFill::Copy(*this);
+  full->TAttMarker::Copy(*this);
+  SetMinimum(full->GetMinimum());
+  SetMaximum(full->GetMaximum());
+
+  // the min/max of the columns keep the range of the full graph
+  Int_t n = full->GetN();
+  if(n > 0) Decimate(full->GetX()[0], full->GetX()[n-1], initial_columns, false);
+}
+
+LodGraph::~LodGraph()
+{
+  if(m_owner) delete m_full;
+}
+
+void LodGraph::Paint(Option_t *option)
+{
+  TString opt = option;
+  opt.ToLower();
+
+  // printing to a file: full resolution
+  if(gVirtualPS && m_full) {
+    PaintFull(option);
+    return;
+  }
+
+  if(m_full) Update(opt.Contains("a") && !opt.Contains("same"));
+
+  TGraph::Paint(option);
+}
+
+/** Decimate again if the visible range or the pad width have changed */
+void LodGraph::Update(bool axis)
+{
+  if(!gPad) return;
+
+  bool logx = gPad->GetLogx();
+  Double_t xmin, xmax;
+
+  if(axis) {
+    // the axis is ours: zoom is in its range. First paint: keep the initial points
+    if(!fHistogram) return;
+    TAxis *a = fHistogram->GetXaxis();
+    xmin = a->GetBinLowEdge(a->GetFirst());
+    xmax = a->GetBinUpEdge(a->GetLast());
+  }
+  else {
+    xmin = gPad->GetUxmin();
+    xmax = gPad->GetUxmax();
+    if(logx) {
+      xmin = std::pow(10., xmin);
+      xmax = std::pow(10., xmax);
+    }
+  }
+
+  Int_t columns = Int_t(gPad->GetWw() * gPad->GetAbsWNDC() *
+                        (1. - gPad->GetLeftMargin() - gPad->GetRightMargin()));
+  columns = std::max(columns, 1);
+
+  if(xmin == m_xmin && xmax == m_xmax && columns == m_columns && logx == m_logx) return;
+
+  Decimate(xmin, xmax, columns, logx);
+}
+
+/** Points of the full graph in [xmin, xmax] (and the next one on each
+    side, so the lines reach the edges), reduced to the first, minimum,
+    maximum and last points of each pixel column */
+void LodGraph::Decimate(Double_t xmin, Double_t xmax, Int_t columns, bool logx)
+{
+  m_xmin = xmin;
+  m_xmax = xmax;
+  m_columns = columns;
+  m_logx = logx;
+
+  const Int_t n = m_full->GetN();
+  const Double_t *x = m_full->GetX();
+  const Double_t *y = m_full->GetY();
+
+  Int_t first = std::lower_bound(x, x+n, xmin) - x;
+  Int_t last  = std::upper_bound(x, x+n, xmax) - x;
+  if(first > 0) first--;
+  if(last < n) last++;
+
+  std::vector<Int_t> keep;
+
+  if(last - first <= 4*columns) {
+    for(Int_t i=first; i<last; i++) keep.push_back(i);
+  }
+  else {
+    keep.reserve(4*columns + 8);
+
+    Double_t tmin = logx ? std::log10(std::max(xmin, 1e-300)) : xmin;
+    Double_t tmax = logx ? std::log10(std::max(xmax, 1e-300)) : xmax;
+    Double_t scale = (tmax > tmin) ? columns/(tmax - tmin) : 0.;
+
+    Int_t i = first;
+    while(i < last){
+      Int_t begin = i, imin = i, imax = i;
+      Int_t col = -1;
+      while(i < last){
+        Double_t t = logx ? (x[i] > 0. ? std::log10(x[i]) : tmin - 1.) : x[i];
+        Int_t c = std::min(std::max(Int_t(std::floor((t - tmin)*scale)), -1), columns);
+        if(i == begin) col = c;
+        else if(c != col) break;
+        if(y[i] < y[imin]) imin = i;
+        if(y[i] > y[imax]) imax = i;
+        i++;
+      }
+
+      // in x order, without repeating points
+      Int_t end = i - 1;
+      Int_t lo = std::min(imin, imax);
+      Int_t hi = std::max(imin, imax);
+      keep.push_back(begin);
+      if(lo != begin) keep.push_back(lo);
+      if(hi != lo && hi != end) keep.push_back(hi);
+      if(end != begin && end != lo) keep.push_back(end);
+    }
+  }
+
+  Int_t size = keep.size();
+  Set(size);
+  for(Int_t k=0; k<size; k++){
+    fX[k] = x[keep[k]];
+    fY[k] = y[keep[k]];
+  }
+}
+
+/** The full graph, with the style and axis of this one */
+void LodGraph::PaintFull(Option_t *option)
+{
+  TString opt = option;
+  opt.ToLower();
+
+  if(opt.Contains("a") && !opt.Contains("same")) {
+    GetHistogram()->Paint("axis");
+    opt.ReplaceAll("a", "");
+  }
+
+  TAttLine::Copy(*m_full);
+  TAttFill::Copy(*m_full);
+  TAttMarker::Copy(*m_full);
+
+  m_full->Paint(opt);
+}
@@ -0,0 +1,49 @@
+/** @file lodgraph.h
+    @brief Display graph for very large graphs
+*/
+
+#ifndef LODGRAPH_H
+#define LODGRAPH_H
+
+#include <TROOT.h>
+#include <TGraph.h>
+
+/** What is drawn instead of a graph with too many points.
+
+    Its points are a decimation of the full graph to the pixel columns
+    of the pad: for each column the first, minimum, maximum and last
+    points are kept, so the drawn line looks the same as the full one.
+    The decimation is only redone when the visible x range or the width
+    of the pad change (zoom, resize). The full graph is not modified,
+    and it's the one painted when the pad is printed to a file.
+*/
+class LodGraph : public TGraph {
+
+ public:
+  LodGraph();
+  LodGraph(TGraph *full);
+  virtual ~LodGraph();
+
+  virtual void Paint(Option_t *option="");
+
+  TGraph* GetFullGraph() { return m_full; }
+
+  static bool IsLarge(TGraph*);
+  static Int_t min_points;
+
+ private:
+  void Update(bool axis);
+  void Decimate(Double_t xmin, Double_t xmax, Int_t columns, bool logx);
+  void PaintFull(Option_t *option);
+
+  TGraph *m_full;     // full resolution graph (written with the canvas)
+  bool m_owner;       //! m_full was read from a file
+  Double_t m_xmin;    //! range and columns of the last decimation
+  Double_t m_xmax;    //!
+  Int_t m_columns;    //!
+  bool m_logx;        //!
+
+  ClassDef(LodGraph, 1);
+};
+
+#endif
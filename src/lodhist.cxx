@@ -0,0 +1,333 @@
+/** @file lodhist.cxx
+    @brief HistPyramid, LodHist2D and LodHist3D implementation
+*/
+
+#include <cmath>
+#include <algorithm>
+
+#include <TVirtualPad.h>
+#include <TVirtualPS.h>
+#include <TArrayD.h>
+
+#include "ratio.h"
+#include "lodhist.h"
+
+ClassImp(LodHist2D)
+ClassImp(LodHist3D)
+
+Int_t HistPyramid::min_cells = 250000;
+Int_t HistPyramid::min_axis_bins = 64;
+Int_t LodHist3D::max_bins = 40;
+
+static TAxis* get_axis(TH1 *h, Int_t a)
+{
+  if(a == 0) return h->GetXaxis();
+  if(a == 1) return h->GetYaxis();
+  return h->GetZaxis();
+}
+
+/** Low edges of the bins of the axis, and its upper edge, merging
+    factor bins in each bin */
+static std::vector<Double_t> merged_edges(TAxis *axis, Int_t factor)
+{
+  Int_t n = axis->GetNbins();
+  std::vector<Double_t> edges;
+  for(Int_t i=1; i<=n; i+=factor) edges.push_back(axis->GetBinLowEdge(i));
+  edges.push_back(axis->GetBinUpEdge(n));
+  return edges;
+}
+
+/** Profiles are not summed into levels (their bins are means): they are drawn as they are */
+bool HistPyramid::IsLarge(TH1 *h)
+{
+  if(!h || h->GetDimension() < 2 || is_profile(h)) return false;
+  return h->GetNbinsX() * h->GetNbinsY() * h->GetNbinsZ() >= min_cells;
+}
+
+HistPyramid::HistPyramid(TH1 *h) :
+  m_dim(h->GetDimension())
+{
+  m_levels.push_back(h);
+  for(Int_t a=0; a<3; a++) m_factors[a].push_back(1);
+
+  MemoryAccountant::Instance()->AddCache(this);
+  Build();
+}
+
+HistPyramid::~HistPyramid()
+{
+  for(unsigned int k=1; k<m_levels.size(); k++) delete m_levels[k];
+  MemoryAccountant::Instance()->RemoveCache(this);
+  MemoryAccountant::Instance()->Remove(this);
+}
+
+/** Add the coarser levels to the level 0 */
+void HistPyramid::Build()
+{
+  while(true){
+    TH1 *last = m_levels.back();
+
+    Int_t factor[3] = { 1, 1, 1 };
+    bool coarser = false;
+    for(Int_t a=0; a<m_dim; a++){
+      if(get_axis(last, a)->GetNbins() > min_axis_bins) {
+        factor[a] = 2;
+        coarser = true;
+      }
+    }
+    if(!coarser) break;
+
+    m_levels.push_back(Coarsen(last, factor));
+    for(Int_t a=0; a<3; a++) m_factors[a].push_back(m_factors[a].back() * factor[a]);
+  }
+
+  Long64_t bytes = 0;
+  for(unsigned int k=1; k<m_levels.size(); k++) bytes += MemoryAccountant::ObjectBytes(m_levels[k]);
+  if(bytes > 0) MemoryAccountant::Instance()->Add(this, kMemCaches, bytes);
+}
+
+/** Keep only the level 0 */
+Long64_t HistPyramid::Evict()
+{
+  Long64_t freed = 0;
+  for(unsigned int k=1; k<m_levels.size(); k++){
+    freed += MemoryAccountant::ObjectBytes(m_levels[k]);
+    delete m_levels[k];
+  }
+  m_levels.resize(1);
+  for(Int_t a=0; a<3; a++) m_factors[a].resize(1);
+
+  MemoryAccountant::Instance()->Remove(this);
+  return freed;
+}
+
+/** New histogram with the sums of blocks of factor[x] x factor[y] (x factor[z]) bins */
+TH1* HistPyramid::Coarsen(TH1 *h, const Int_t *factor)
+{
+  std::vector<Double_t> ex = merged_edges(h->GetXaxis(), factor[0]);
+  std::vector<Double_t> ey = merged_edges(h->GetYaxis(), factor[1]);
+
+  TString name = Form("%s_lod%i", h->GetName(), (int)m_levels.size());
+
+  bool add_status = TH1::AddDirectoryStatus();
+  TH1::AddDirectory(kFALSE);
+
+  TH1 *out = 0;
+  if(m_dim == 3) {
+    std::vector<Double_t> ez = merged_edges(h->GetZaxis(), factor[2]);
+    out = new TH3D(name, h->GetTitle(), ex.size()-1, &ex[0], ey.size()-1, &ey[0], ez.size()-1, &ez[0]);
+  }
+  else
+    out = new TH2D(name, h->GetTitle(), ex.size()-1, &ex[0], ey.size()-1, &ey[0]);
+
+  TH1::AddDirectory(add_status);
+
+  bool errors = h->GetSumw2N() > 0;
+  if(errors) out->Sumw2();
+
+  Double_t *content = dynamic_cast<TArrayD*>(out)->GetArray();
+  Double_t *err2 = errors ? out->GetSumw2()->GetArray() : 0;
+  const Double_t *h_err2 = errors ? h->GetSumw2()->GetArray() : 0;
+
+  Int_t nz = (m_dim == 3) ? h->GetNbinsZ() : 1;
+  for(Int_t iz=1; iz<=nz; iz++){
+    Int_t oz = (m_dim == 3) ? (iz-1)/factor[2] + 1 : 0;
+    for(Int_t iy=1; iy<=h->GetNbinsY(); iy++){
+      Int_t oy = (iy-1)/factor[1] + 1;
+      for(Int_t ix=1; ix<=h->GetNbinsX(); ix++){
+        Int_t bin = h->GetBin(ix, iy, m_dim == 3 ? iz : 0);
+        Int_t obin = out->GetBin((ix-1)/factor[0] + 1, oy, oz);
+        content[obin] += h->GetBinContent(bin);
+        if(errors) err2[obin] += h_err2[bin];
+      }
+    }
+  }
+
+  out->SetEntries(h->GetEntries());
+
+  return out;
+}
+
+/** Finest level with at most max_bins[a] bins in the visible range of
+    each axis of the display histogram */
+Int_t HistPyramid::ChooseLevel(TH1 *display, const Int_t *max_bins)
+{
+  MemoryAccountant::Instance()->Touch(this);
+  if(m_levels.size() == 1) Build();
+
+  Int_t visible[3];
+  for(Int_t a=0; a<m_dim; a++){
+    TAxis *axis = get_axis(display, a);
+    Double_t u0 = axis->GetBinLowEdge(axis->GetFirst());
+    Double_t u1 = axis->GetBinUpEdge(axis->GetLast());
+
+    TAxis *full = get_axis(m_levels[0], a);
+    Int_t first = full->FindFixBin(u0);
+    Int_t last = full->FindFixBin(u1);
+    if(last > full->GetNbins() || full->GetBinLowEdge(last) >= u1) last--;
+    visible[a] = std::max(last - first + 1, 1);
+  }
+
+  for(Int_t level=0; level<GetNLevels(); level++){
+    bool fits = true;
+    for(Int_t a=0; a<m_dim; a++){
+      Int_t f = m_factors[a][level];
+      if((visible[a] + f - 1)/f > std::max(max_bins[a], 1)) fits = false;
+    }
+    if(fits) return level;
+  }
+
+  return GetNLevels() - 1;
+}
+
+/** Set the bins and contents of the display histogram to the level,
+    keeping its visible range */
+void HistPyramid::Show(Int_t level, TH1 *display)
+{
+  TH1 *h = m_levels[level];
+
+  Double_t u0[3], u1[3];
+  bool zoomed[3];
+  for(Int_t a=0; a<m_dim; a++){
+    TAxis *axis = get_axis(display, a);
+    zoomed[a] = axis->GetNbins() > 0 && (axis->GetFirst() > 1 || axis->GetLast() < axis->GetNbins());
+    u0[a] = axis->GetBinLowEdge(axis->GetFirst());
+    u1[a] = axis->GetBinUpEdge(axis->GetLast());
+  }
+
+  std::vector<Double_t> ex = merged_edges(h->GetXaxis(), 1);
+  std::vector<Double_t> ey = merged_edges(h->GetYaxis(), 1);
+  if(m_dim == 3) {
+    std::vector<Double_t> ez = merged_edges(h->GetZaxis(), 1);
+    display->SetBins(ex.size()-1, &ex[0], ey.size()-1, &ey[0], ez.size()-1, &ez[0]);
+  }
+  else
+    display->SetBins(ex.size()-1, &ex[0], ey.size()-1, &ey[0]);
+
+  TArrayD *out = dynamic_cast<TArrayD*>(display);
+  Int_t n = h->GetNcells();
+
+  // the levels > 0 are doubles, the original may be any type
+  TArrayD *in = dynamic_cast<TArrayD*>(h);
+  if(in) std::copy(in->GetArray(), in->GetArray()+n, out->GetArray());
+  else {
+    for(Int_t i=0; i<n; i++) out->GetArray()[i] = h->GetBinContent(i);
+  }
+
+  if(h->GetSumw2N() > 0) {
+    if(display->GetSumw2N() == 0) display->Sumw2();
+    std::copy(h->GetSumw2()->GetArray(), h->GetSumw2()->GetArray()+n, display->GetSumw2()->GetArray());
+  }
+
+  display->ResetStats();
+  display->SetEntries(m_levels[0]->GetEntries());
+
+  for(Int_t a=0; a<m_dim; a++){
+    if(zoomed[a]) get_axis(display, a)->SetRangeUser(u0[a], u1[a]);
+  }
+}
+
+/** Name, titles, style and ranges of the original histogram */
+static void copy_display_style(TH1 *from, TH1 *to)
+{
+  to->SetName(from->GetName());
+  to->SetTitle(from->GetTitle());
+  from->TAttLine::Copy(*to);
+  from->TAttFill::Copy(*to);
+  from->TAttMarker::Copy(*to);
+  to->SetStats(!from->TestBit(TH1::kNoStats));
+  to->SetMinimum(from->GetMinimumStored());
+  to->SetMaximum(from->GetMaximumStored());
+
+  for(Int_t a=0; a<from->GetDimension(); a++){
+    TAxis *in = get_axis(from, a);
+    TAxis *out = get_axis(to, a);
+    out->SetTitle(in->GetTitle());
+    if(in->GetFirst() > 1 || in->GetLast() < in->GetNbins())
+      out->SetRangeUser(in->GetBinLowEdge(in->GetFirst()), in->GetBinUpEdge(in->GetLast()));
+  }
+}
+
+/** Pixels of the frame of the current pad */
+static Int_t pad_columns()
+{
+  return Int_t(gPad->GetWw() * gPad->GetAbsWNDC() * (1. - gPad->GetLeftMargin() - gPad->GetRightMargin()));
+}
+
+static Int_t pad_rows()
+{
+  return Int_t(gPad->GetWh() * gPad->GetAbsHNDC() * (1. - gPad->GetBottomMargin() - gPad->GetTopMargin()));
+}
+
+LodHist2D::LodHist2D() :
+  TH2D(),
+  m_pyramid(0),
+  m_level(-1)
+{
+}
+
+LodHist2D::LodHist2D(TH1 *full) :
+  TH2D(),
+  m_pyramid(new HistPyramid(full)),
+  m_level(m_pyramid->GetNLevels()-1)
+{
+  SetDirectory(0);
+  m_pyramid->Show(m_level, this);
+  copy_display_style(full, this);
+}
+
+LodHist2D::~LodHist2D()
+{
+  delete m_pyramid;
+}
+
+void LodHist2D::Paint(Option_t *option)
+{
+  if(m_pyramid && gPad) {
+    Int_t max_bins[3] = { pad_columns(), pad_rows(), 0 };
+    // printing to a file: full resolution
+    Int_t level = gVirtualPS ? 0 : m_pyramid->ChooseLevel(this, max_bins);
+    if(level != m_level) {
+      m_pyramid->Show(level, this);
+      m_level = level;
+    }
+  }
+
+  TH2D::Paint(option);
+}
+
+LodHist3D::LodHist3D() :
+  TH3D(),
+  m_pyramid(0),
+  m_level(-1)
+{
+}
+
+LodHist3D::LodHist3D(TH1 *full) :
+  TH3D(),
+  m_pyramid(new HistPyramid(full)),
+  m_level(m_pyramid->GetNLevels()-1)
+{
+  SetDirectory(0);
+  m_pyramid->Show(m_level, this);
+  copy_display_style(full, this);
+}
+
+LodHist3D::~LodHist3D()
+{
+  delete m_pyramid;
+}
+
+void LodHist3D::Paint(Option_t *option)
+{
+  if(m_pyramid) {
+    Int_t bins[3] = { max_bins, max_bins, max_bins };
+    Int_t level = gVirtualPS ? 0 : m_pyramid->ChooseLevel(this, bins);
+    if(level != m_level) {
+      m_pyramid->Show(level, this);
+      m_level = level;
+    }
+  }
+
+  TH3D::Paint(option);
+}
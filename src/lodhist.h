@@ -0,0 +1,85 @@
+/** @file lodhist.h
+    @brief Display histograms for very large 2D/3D histograms
+*/
+
+#ifndef LODHIST_H
+#define LODHIST_H
+
+#include <vector>
+
+#include <TROOT.h>
+#include <TH2.h>
+#include <TH3.h>
+
+#include "memory.h"
+
+/** Coarser versions of a 2D/3D histogram: each level sums blocks of 2
+    bins (in each axis with more than min_axis_bins) of the previous one.
+    The level 0 is the histogram itself (not owned). The coarser levels
+    are a cache: they are evicted when the memory budget is exceeded and
+    built again when needed */
+class HistPyramid : public MemoryCache {
+
+ public:
+  HistPyramid(TH1 *h);
+  ~HistPyramid();
+
+  virtual Long64_t Evict();
+
+  Int_t GetNLevels() { return m_levels.size(); }
+  Int_t ChooseLevel(TH1 *display, const Int_t *max_bins);
+  void Show(Int_t level, TH1 *display);
+
+  static bool IsLarge(TH1*);
+  static Int_t min_cells;
+  static Int_t min_axis_bins;
+
+ private:
+  void Build();
+  TH1* Coarsen(TH1 *h, const Int_t *factor);
+
+  Int_t m_dim;
+  std::vector<TH1*> m_levels;
+  std::vector<Int_t> m_factors[3]; // original bins in a bin, for each level and axis
+};
+
+/** What is drawn instead of a 2D histogram with too many bins: the
+    level of the pyramid with about one bin per pixel of the visible
+    range. The level is chosen again in each repaint, so it follows the
+    zoom and the size of the pad */
+class LodHist2D : public TH2D {
+
+ public:
+  LodHist2D();
+  LodHist2D(TH1 *full);
+  virtual ~LodHist2D();
+
+  virtual void Paint(Option_t *option="");
+
+ private:
+  HistPyramid *m_pyramid; //!
+  Int_t m_level;          //!
+
+  ClassDef(LodHist2D, 1);
+};
+
+/** Same for 3D histograms, with at most max_bins bins in each axis */
+class LodHist3D : public TH3D {
+
+ public:
+  LodHist3D();
+  LodHist3D(TH1 *full);
+  virtual ~LodHist3D();
+
+  virtual void Paint(Option_t *option="");
+
+  static Int_t max_bins;
+
+ private:
+  HistPyramid *m_pyramid; //!
+  Int_t m_level;          //!
+
+  ClassDef(LodHist3D, 1);
+};
+
+#endif
@@ -2,30 +2,77 @@
  */
 
 #include "macro.h"
+#include "common.h"
 
 HistoInfo::HistoInfo(Int_t file, TString name, TString title) :
   m_file(file),
   m_name(name),
   m_title(title),
+  m_path(""),
+  m_tree(""),
+  m_cut(""),
+  m_binning(""),
+  m_is_graph(false),
   m_drawoption(""),
   m_rebin(1),
   m_colour(1),
+  m_fill(false),
   m_scale_factor(1.0)
 {
 
 }
 
+/** The object is drawn from a tree: name is the expression */
+void HistoInfo::SetTreeDraw(TString tree, TString cut, TString binning)
+{
+  m_tree = tree;
+  m_cut = cut;
+  m_binning = binning;
+}
+
 TString HistoInfo::GetMacroName()
 {
   TString macroname = Form("h_file%i_%s", m_file, m_name.Data());
   return macroname;
 }
 
+/** Identifies what has to be loaded: the same key is loaded only once */
+TString HistoInfo::GetKey()
+{
+  if(IsTreeDraw())
+    return Form("%i|%s|%s|%s|%s", m_file, m_tree.Data(), m_name.Data(), m_cut.Data(), m_binning.Data());
+  return Form("%i|%s", m_file, GetFullPath().Data());
+}
+
 Bool_t HistoInfo::operator= (HistoInfo* other)
 {
-  if( m_file == other->GetFile() && m_name == other->GetName())
-    return true;
-  return false;
+  return GetKey() == other->GetKey();
+}
+
+CanvasInfo::CanvasInfo(TString name) :
+  m_name(name),
+  m_logx(false),
+  m_logy(false),
+  m_normalise(false),
+  m_normalise_to_first(false),
+  m_ratio(false),
+  m_diff(false)
+{
+}
+
+/** Ratio or difference pad below the histograms (not for graphs) */
+Bool_t CanvasInfo::HasLowerPad()
+{
+  if(!(m_ratio || m_diff) || m_histos.size() < 2) return false;
+  for(unsigned int k=0; k<m_histos.size(); k++){
+    if(m_histos[k]->IsGraph()) return false;
+  }
+  return true;
+}
+
+CanvasInfo::~CanvasInfo()
+{
+  for(unsigned int k=0; k<m_histos.size(); k++) delete m_histos[k];
 }
 
 void CanvasInfo::AddHisto(HistoInfo* histo)
@@ -34,190 +81,427 @@ void CanvasInfo::AddHisto(HistoInfo* histo)
   return;
 }
 
-void Macro::AddFile(TString file)
+void CanvasInfo::AddLegend(std::vector<TString> legend)
 {
+  for(unsigned int index=0; index<m_histos.size() && index<legend.size(); index++){
+    m_histos[index]->SetLegendText(legend[index]);
+  }
+}
+
+Macro::~Macro()
+{
+  Reset();
+}
+
+/** Index of the file in the macro (added if it's not there yet) */
+Int_t Macro::AddFile(TString file)
+{
+  for(unsigned int i=0; i<m_files.size(); i++){
+    if(m_files[i] == file) return i;
+  }
   m_files.push_back(file);
+  return m_files.size()-1;
 }
 
 void Macro::AddCanvas(TString name)
 {
-  CanvasInfo *c = new CanvasInfo(name);
+  m_canvases.push_back(new CanvasInfo(name));
+}
+
+void Macro::AddCanvas(CanvasInfo *c)
+{
   m_canvases.push_back(c);
-  canvas_counter = m_canvases.size()-1;
+}
+
+/** The plot of the canvas was closed */
+void Macro::RemoveCanvas(TString name)
+{
+  for(unsigned int i=0; i<m_canvases.size(); i++){
+    if(m_canvases[i]->GetName() != name) continue;
+    delete m_canvases[i];
+    m_canvases.erase(m_canvases.begin()+i);
+    return;
+  }
 }
 
 void Macro::AddHisto(HistoInfo* h)
 {
-  m_canvases[canvas_counter]->AddHisto(h);
+  if(m_canvases.empty()) AddCanvas(Form("canvas%i", 0));
+  m_canvases.back()->AddHisto(h);
 }
 
 void Macro::AddLegend(std::vector<TString> legend)
 {
-  for(int index=0; index<m_canvases[canvas_counter]->GetNumberOfHistos(); index++){
-    m_canvases[canvas_counter]->GetHisto(index)->SetLegendText(legend[index]);
-  }
+  if(m_canvases.empty()) return;
+  m_canvases.back()->AddLegend(legend);
 }
 
 void Macro::Reset()
 {
+  for(unsigned int i=0; i<m_canvases.size(); i++) delete m_canvases[i];
   m_canvases.clear();
+  m_files.clear();
+  m_loads.clear();
+  m_loops.clear();
+  m_load_names.clear();
 }
 
-void Macro::SaveMacro(TString name, OutputFormat type)
+/** Valid variable name from an object name */
+static TString var_name(TString name)
 {
-  // Int_t n_canvas = m_canvases.size();
-  // Int_t n_files  = m_files.size();
-
-
-  // // Add all histos and remove repeated
-  // Int_t all_histos_size = 0;
-  // for(unsigned int i=0; i< m_canvases.size(); i++){
-  //   all_histos_size += m_canvases[i]->Histos().size();
-  // }
-
-  // vector<HistoInfo*> all_histos;
-  // all_histos.reserve( all_histos_size ); // preallocate memory
-  // for(unsigned int i=0; i<canvases.size(); i++){
-  //   for(unsigned int j=0; j<canvases[i]->Histos().size(); j++){
-  //     all_histos.push_back( canvases[i]->Histo(j) );
-  //   }
-  // }
-
-  // for(int k=0; k<all_histos_size; k++){
-  //    sort(all_histos.begin(), all_histos.end());
-  //    all_histos.erase(unique(all_histos.begin(), all_histos.end()), all_histos.end());
-  // }
-
-
-
-
-  // // Write Macro
-  // ofstream macrofile(name.Data());
-
-
-  // // Root macro
-  // if(type == MRoot){
-
-  //   macrofile << "// ROOT macro creado con plotter */  \n" << endl;
-  //   macrofile << "{ \n" << endl;
-
-  //   macrofile << "// Files" << endl;
-  //   for(int i=0;i<n_files;i++){
-  //     macrofile << "TFile *file" << i << " = TFile(\"" << files[i]  << "\", \"open\");" << endl;
-  //   }
-
-  //   macrofile << "\n" << endl;
-
-  //   macrofile << "// Load Histos" << endl;
-  //   for(int j=0; j<all_histos_size; j++){
-  //     macrofile << "TH1 *h_file" << all_histos[j]->File()  << "_" << all_histos[j]->Name() << " = (TH1*) file" << all_histos[j]->File() << "->Get(\"" << all_histos[j]->Name()  << "\");" << endl;
-  //   }
-
-  //   macrofile << "\n" << endl;
-
-  //   macrofile << "// Plots" << endl;
-  //   for(int i=0; i<n_canvas; i++){
-  //     macrofile << "TCanvas *canvas" << i << " = new TCanvas();" << endl;
-  //     for(int j=0; j < canvases[i]->NumberOfHistos(); j++){
-  //   if(j==0)   macrofile << canvases[i]->Histo(j)->Name() << "->SetStats(0);" << endl;
-  //   macrofile << canvases[i]->Histo(j)->Name() << "->SetLineColor(" << canvases[i]->Histo(j)->Colour() << ");" << endl;
-  //   macrofile << canvases[i]->Histo(j)->Name() << "->SetMarkerColor(" << canvases[i]->Histo(j)->Colour() << ");" << endl;
-  //     }
-  //     for(int j=0; j < canvases[i]->NumberOfHistos(); j++){
-  //       macrofile << canvases[i]->Histo(j)->Name() << "->Draw(\"" << canvases[i]->Histo(j)->DrawOption() <<"\");" << endl;
-  //     }
-
-
-  //     if(canvases[i]->NumberOfHistos() > 1){
-  //   macrofile << "\n" << endl;
-  //   macrofile << "TLegend *legend" << i << " = new TLegend(0.7,0.7,0.8,0.8);" << endl;
-  //   macrofile << "legend" << i << "->SetFillColor(0);" << endl;
-  //   macrofile << "legend" << i << "->SetBorderSize(0);" << endl;
-  //   for(int j=0; j<canvases[i]->NumberOfHistos(); j++){
-  //     macrofile << "legend" << i << "->AddEntry(" << canvases[i]->Histo(j)->MacroName() << ",\"" << canvases[i]->Histo(j)->LegendText() << "\");" << endl;
-  //   }
-  //   macrofile << "legend" << i << "->Draw();" << endl;
-  //   macrofile << "\n" << endl;
-  //     }
-
-  //     macrofile << "canvas" << i << "->Print(\"canvas" << i << ".eps\");" << endl;
-  //     macrofile << "\n" << endl;
-  //   }
-
-
-  //   macrofile << "}" << endl;
-  // }
-
-
-
-
-
-  // // Python macro
-  // if(type == MPython){
-  //   macrofile << "#! /usr/bin/env python" << endl;
-  //   macrofile << "# Macro creado con plotter" <<  endl;
-  //   macrofile << " " << endl;
-  //   macrofile << "from ROOT import * \n" << endl;
+  for(Int_t k=0; k<name.Length(); k++){
+    if(!isalnum(name[k])) name[k] = '_';
+  }
+  return name;
+}
 
-  //   macrofile << "# Files" << endl;
-  //   for(int i=0; i<n_files; i++){
-  //     macrofile << "file" << i << " = TFile(\"" << files[i]  << "\", \"open\" )" << endl;
-  //   }
+/** Escape the double quotes to write a string in the macro */
+static TString escape(TString str)
+{
+  str.ReplaceAll("\\", "\\\\");
+  str.ReplaceAll("\"", "\\\"");
+  return str;
+}
 
-  //   macrofile << "\n" << endl;
+/** Histogram binning of a tree draw (automatic range if not given) */
+static TString binning_args(TString binning)
+{
+  if(binning.IsNull()) return "100, 0, 0";
+  binning.ReplaceAll(",", ", ");
+  return binning;
+}
 
-  //   macrofile << "# Load Histos" << endl;
-  //   for(int j=0; j<all_histos_size; j++){
-  //     macrofile << "h_file" << all_histos[j]->File()  << "_" << all_histos[j]->Name() << " = file" << all_histos[j]->File() << ".Get(\"" << all_histos[j]->Name()  << "\")" << endl;
-  //   }
+/** Find what has to be loaded: the objects read from the files and the
+    tree draws grouped by (file, tree, cut), each object only once */
+void Macro::BuildLoads()
+{
+  m_loads.clear();
+  m_loops.clear();
+  m_load_names.clear();
+
+  std::map<TString, unsigned int> loop_index;
+
+  for(unsigned int i=0; i<m_canvases.size(); i++){
+    for(int j=0; j<m_canvases[i]->GetNumberOfHistos(); j++){
+      HistoInfo *h = m_canvases[i]->GetHisto(j);
+
+      TString key = h->GetKey();
+      if(m_load_names.count(key)) continue;
+
+      TString var = Form("h%i_%s", (int)m_load_names.size(), var_name(h->GetName()).Data());
+      m_load_names[key] = var;
+
+      if(h->IsTreeDraw()) {
+        TString loop_key = Form("%i|%s|%s", h->GetFile(), h->GetTree().Data(), h->GetCut().Data());
+        if(!loop_index.count(loop_key)) {
+          loop_index[loop_key] = m_loops.size();
+          m_loops.push_back(std::vector<HistoInfo*>());
+        }
+        m_loops[loop_index[loop_key]].push_back(h);
+      }
+      else {
+        m_loads.push_back(h);
+      }
+    }
+  }
+}
 
-  //   macrofile << "\n" << endl;
+void Macro::SaveMacro(TString name, OutputFormat type)
+{
+  if(m_canvases.empty()) {
+    error("There are no canvases in the macro.");
+    return;
+  }
 
-  //   macrofile << "# Configure histos" << endl;
-  //   macrofile << "def configHisto(h, colour):" << endl;
-  //   macrofile << "    h.SetLineColor(colour)" <<endl;
-  //   macrofile << "    h.SetMarkerColor(colour)" <<endl;
-  //   macrofile << "    h.SetLineWidth(2)" <<endl;
-  //   macrofile << "    h.SetMarkerSize(0.8)" <<endl;
-  //   macrofile << "    h.SetTitle(\"\")" <<endl;
-  //   macrofile << "    h.SetStats(0)" <<endl;
+  std::ofstream macrofile(name.Data());
+  if(!macrofile) {
+    error("Cannot write " << name);
+    return;
+  }
 
-  //   macrofile << "\n" << endl;
+  BuildLoads();
 
-  //   for(int j=0; j<all_histos_size; j++){
-  //     macrofile << "configHisto(" << all_histos[j]->MacroName() << "," << all_histos[j]->Colour() << ")" << endl;
-  //     if(all_histos[j]->RebinNumber()>1) macrofile << all_histos[j]->MacroName() << ".Rebin(" << all_histos[j]->RebinNumber() << ")" << endl;
-  //     if(all_histos[j]->ScaleFactor()!=1) macrofile << all_histos[j]->MacroName() << ".Scale(" << all_histos[j]->ScaleFactor() << ")" << endl;
-  //   }
+  if(type == MRoot) WriteRoot(macrofile);
+  else if(type == MPython) WritePython(macrofile);
+}
 
-  //   macrofile << "\n" << endl;
+void Macro::WriteRoot(std::ofstream &out)
+{
+  out << "// ROOT macro created with plotter" << std::endl;
+  out << "{" << std::endl;
 
-  //   macrofile << "# Plots" << endl;
-  //   for(int i=0; i<n_canvas; i++){
+  out << "  // Files" << std::endl;
+  for(unsigned int i=0; i<m_files.size(); i++){
+    out << "  TFile *file" << i << " = TFile::Open(\"" << escape(m_files[i]) << "\");" << std::endl;
+  }
+  out << std::endl;
+
+  if(!m_loads.empty()) {
+    out << "  // Objects (each one is read only once)" << std::endl;
+    for(unsigned int i=0; i<m_loads.size(); i++){
+      HistoInfo *h = m_loads[i];
+      TString var = m_load_names[h->GetKey()];
+      TString cl = h->IsGraph() ? "TGraph" : "TH1";
+      out << "  " << cl << " *" << var << " = (" << cl << "*)file" << h->GetFile()
+          << "->Get(\"" << escape(h->GetFullPath()) << "\");" << std::endl;
+      if(!h->IsGraph()) out << "  " << var << "->SetDirectory(0);" << std::endl;
+    }
+    out << std::endl;
+  }
 
-  //     macrofile << "\n" << endl;
+  for(unsigned int l=0; l<m_loops.size(); l++){
+    std::vector<HistoInfo*> &draws = m_loops[l];
+    HistoInfo *first = draws[0];
+    bool has_cut = !first->GetCut().IsNull();
+
+    out << "  // Tree " << first->GetTree() << " (file" << first->GetFile() << ")";
+    if(has_cut) out << " with cut " << first->GetCut();
+    out << ": " << draws.size() << " draws in a single loop" << std::endl;
+
+    for(unsigned int j=0; j<draws.size(); j++){
+      TString var = m_load_names[draws[j]->GetKey()];
+      out << "  TH1 *" << var << " = new TH1D(\"" << var << "\", \"" << escape(draws[j]->GetName())
+          << "\", " << binning_args(draws[j]->GetBinning()) << ");" << std::endl;
+      out << "  " << var << "->SetDirectory(0);" << std::endl;
+      if(has_cut) out << "  " << var << "->Sumw2();" << std::endl;
+    }
+
+    out << "  {" << std::endl;
+    out << "    TTree *tree = (TTree*)file" << first->GetFile() << "->Get(\"" << escape(first->GetTree()) << "\");" << std::endl;
+    if(has_cut)
+      out << "    TTreeFormula *cut = new TTreeFormula(\"cut\", \"" << escape(first->GetCut()) << "\", tree);" << std::endl;
+    for(unsigned int j=0; j<draws.size(); j++){
+      out << "    TTreeFormula *x" << j << " = new TTreeFormula(\"x" << j << "\", \"" << escape(draws[j]->GetName()) << "\", tree);" << std::endl;
+    }
+    out << "    for(Long64_t i=0; i<tree->GetEntries(); i++){" << std::endl;
+    out << "      tree->LoadTree(i);" << std::endl;
+    if(has_cut) {
+      out << "      if(cut->GetNdata() == 0) continue;" << std::endl;
+      out << "      Double_t w = cut->EvalInstance();" << std::endl;
+      out << "      if(w == 0) continue;" << std::endl;
+    }
+    else {
+      out << "      Double_t w = 1.;" << std::endl;
+    }
+    for(unsigned int j=0; j<draws.size(); j++){
+      out << "      for(Int_t k=0; k<x" << j << "->GetNdata(); k++) "
+          << m_load_names[draws[j]->GetKey()] << "->Fill(x" << j << "->EvalInstance(k), w);" << std::endl;
+    }
+    out << "    }" << std::endl;
+    for(unsigned int j=0; j<draws.size(); j++){
+      out << "    " << m_load_names[draws[j]->GetKey()] << "->BufferEmpty(1);" << std::endl;
+    }
+    out << "  }" << std::endl;
+    out << std::endl;
+  }
 
-  //     macrofile << "# Canvas" << i << endl;
-  //     macrofile << "canvas" << i << " = TCanvas()" << endl;
-  //     for(int j=0; j < canvases[i]->NumberOfHistos(); j++){
-  //       macrofile << all_histos[j]->MacroName() << ".Draw(\"" << canvases[i]->Histo(j)->DrawOption() <<"\")" << endl;
-  //     }
+  out << "  // Canvases" << std::endl;
+  for(unsigned int i=0; i<m_canvases.size(); i++){
+    CanvasInfo *c = m_canvases[i];
+    TString canvas = Form("canvas%i", i);
+
+    out << "  TCanvas *" << canvas << " = new TCanvas(\"" << canvas << "\", \"" << escape(c->GetName()) << "\", 800, 600);" << std::endl;
+
+    TString pad = canvas;
+    if(c->HasLowerPad()) {
+      pad = Form("up%i", i);
+      out << "  TPad *up" << i << " = new TPad(\"up" << i << "\", \"\", .001, .29, .999, .999);" << std::endl;
+      out << "  TPad *down" << i << " = new TPad(\"down" << i << "\", \"\", .001, .001, .999, .28);" << std::endl;
+      out << "  up" << i << "->SetBottomMargin(0.01);" << std::endl;
+      out << "  down" << i << "->SetTopMargin(0.01);" << std::endl;
+      out << "  down" << i << "->SetBottomMargin(0.2);" << std::endl;
+      out << "  up" << i << "->Draw();" << std::endl;
+      out << "  down" << i << "->Draw();" << std::endl;
+      out << "  up" << i << "->cd();" << std::endl;
+    }
+    if(c->GetLogX()) out << "  " << pad << "->SetLogx();" << std::endl;
+    if(c->GetLogY()) out << "  " << pad << "->SetLogy();" << std::endl;
+
+    for(int j=0; j<c->GetNumberOfHistos(); j++){
+      HistoInfo *h = c->GetHisto(j);
+      TString var = Form("c%i_%i", i, j);
+      TString cl = h->IsGraph() ? "TGraph" : "TH1";
+
+      out << "  " << cl << " *" << var << " = (" << cl << "*)" << m_load_names[h->GetKey()] << "->Clone(\"" << var << "\");" << std::endl;
+      out << "  " << var << "->SetLineColor(" << h->GetColour() << ");" << std::endl;
+      out << "  " << var << "->SetMarkerColor(" << h->GetColour() << ");" << std::endl;
+      out << "  " << var << "->SetMarkerStyle(20);" << std::endl;
+      out << "  " << var << "->SetMarkerSize(0.8);" << std::endl;
+      if(h->IsGraph()) continue;
+
+      if(h->GetFill()) out << "  " << var << "->SetFillColor(" << h->GetColour() << ");" << std::endl;
+      out << "  " << var << "->SetLineWidth(2);" << std::endl;
+      out << "  " << var << "->SetStats(0);" << std::endl;
+      if(h->GetRebinNumber()) out << "  " << var << "->Rebin(" << h->GetRebinNumber() << ");" << std::endl;
+      if(h->GetScaleFactor() != 1.) out << "  " << var << "->Scale(" << h->GetScaleFactor() << ");" << std::endl;
+      if(c->GetNormalise())
+        out << "  " << var << "->Scale(1./" << var << "->Integral());" << std::endl;
+      else if(c->GetNormaliseToFirst() && j > 0)
+        out << "  " << var << "->Scale(c" << i << "_0->Integral()/" << var << "->Integral());" << std::endl;
+    }
+
+    for(int j=0; j<c->GetNumberOfHistos(); j++){
+      HistoInfo *h = c->GetHisto(j);
+      TString opts = h->GetDrawOption();
+      if(h->IsGraph()) opts = (j==0 ? "APZ" : "PZ") + opts;
+      else if(j > 0) opts += "same";
+      out << "  c" << i << "_" << j << "->Draw(\"" << opts << "\");" << std::endl;
+    }
+
+    if(c->GetNumberOfHistos() > 1){
+      out << "  TLegend *legend" << i << " = new TLegend(0.7,0.7,0.9,0.9);" << std::endl;
+      out << "  legend" << i << "->SetFillColor(0);" << std::endl;
+      out << "  legend" << i << "->SetBorderSize(0);" << std::endl;
+      for(int j=0; j<c->GetNumberOfHistos(); j++){
+        out << "  legend" << i << "->AddEntry(c" << i << "_" << j << ", \"" << escape(c->GetHisto(j)->GetLegendText()) << "\");" << std::endl;
+      }
+      out << "  legend" << i << "->Draw();" << std::endl;
+    }
+
+    if(c->HasLowerPad()) {
+      out << "  down" << i << "->cd();" << std::endl;
+      if(c->GetLogX()) out << "  down" << i << "->SetLogx();" << std::endl;
+      for(int j=1; j<c->GetNumberOfHistos(); j++){
+        TString var = Form("r%i_%i", i, j);
+        out << "  TH1 *" << var << " = (TH1*)c" << i << "_" << j << "->Clone(\"" << var << "\");" << std::endl;
+        if(c->GetDiff()) out << "  " << var << "->Add(c" << i << "_0, -1);" << std::endl;
+        out << "  " << var << "->Divide(c" << i << "_0);" << std::endl;
+        if(j == 1) out << "  " << var << "->GetYaxis()->SetTitle(\"" << (c->GetDiff() ? "Relative difference" : "Ratio") << "\");" << std::endl;
+        out << "  " << var << "->Draw(\"" << (j == 1 ? "" : "same") << "\");" << std::endl;
+      }
+    }
+
+    out << "  " << canvas << "->Print(\"" << escape(c->GetName()) << ".eps\");" << std::endl;
+    out << std::endl;
+  }
 
-  //     if(canvases[i]->NumberOfHistos() > 1){
-  //   macrofile << "\n" << endl;
-  //   macrofile << "legend" << i << " = TLegend(0.7,0.7,0.8,0.8)" << endl;
-  //   macrofile << "legend" << i << ".SetFillColor(0)" << endl;
-  //   macrofile << "legend" << i << ".SetBorderSize(0)" << endl;
-  //   for(int j=0; j<canvases[i]->NumberOfHistos(); j++){
-  //     macrofile << "legend" << i << ".AddEntry(" << canvases[i]->Histo(j)->MacroName() << ",\"" << canvases[i]->Histo(j)->LegendText() << "\")" << endl;
-  //   }
-  //   macrofile << "legend" << i << ".Draw()" << endl;
-  //   macrofile << "\n" << endl;
-  //     }
+  out << "}" << std::endl;
+}
 
-  //     macrofile << "canvas" << i << ".Print(\"canvas" << i << ".eps\")" << endl;
-  //   }
+void Macro::WritePython(std::ofstream &out)
+{
+  out << "#! /usr/bin/env python" << std::endl;
+  out << "# Macro created with plotter" << std::endl;
+  out << std::endl;
+  out << "import ROOT" << std::endl;
+  out << std::endl;
+
+  out << "# Files" << std::endl;
+  for(unsigned int i=0; i<m_files.size(); i++){
+    out << "file" << i << " = ROOT.TFile.Open(\"" << escape(m_files[i]) << "\")" << std::endl;
+  }
+  out << std::endl;
+
+  if(!m_loads.empty()) {
+    out << "# Objects (each one is read only once)" << std::endl;
+    for(unsigned int i=0; i<m_loads.size(); i++){
+      HistoInfo *h = m_loads[i];
+      TString var = m_load_names[h->GetKey()];
+      out << var << " = file" << h->GetFile() << ".Get(\"" << escape(h->GetFullPath()) << "\")" << std::endl;
+      if(!h->IsGraph()) out << var << ".SetDirectory(0)" << std::endl;
+    }
+    out << std::endl;
+  }
 
-  // }//end python macro
+  for(unsigned int l=0; l<m_loops.size(); l++){
+    std::vector<HistoInfo*> &draws = m_loops[l];
+    HistoInfo *first = draws[0];
+    bool has_cut = !first->GetCut().IsNull();
+
+    out << "# Tree " << first->GetTree() << " (file" << first->GetFile() << ")";
+    if(has_cut) out << " with cut " << first->GetCut();
+    out << ": " << draws.size() << " draws" << std::endl;
+
+    out << "tree = file" << first->GetFile() << ".Get(\"" << escape(first->GetTree()) << "\")" << std::endl;
+    for(unsigned int j=0; j<draws.size(); j++){
+      TString var = m_load_names[draws[j]->GetKey()];
+      TString target = var;
+      if(!draws[j]->GetBinning().IsNull()) target += "(" + draws[j]->GetBinning() + ")";
+
+      out << "tree.Draw(\"" << escape(draws[j]->GetName()) << ">>" << target << "\", \""
+          << escape(first->GetCut()) << "\", \"goff\")" << std::endl;
+      out << var << " = ROOT.gDirectory.Get(\"" << var << "\")" << std::endl;
+      out << var << ".SetDirectory(0)" << std::endl;
+    }
+    out << std::endl;
+  }
 
+  out << "# Canvases" << std::endl;
+  for(unsigned int i=0; i<m_canvases.size(); i++){
+    CanvasInfo *c = m_canvases[i];
+    TString canvas = Form("canvas%i", i);
+
+    out << canvas << " = ROOT.TCanvas(\"" << canvas << "\", \"" << escape(c->GetName()) << "\", 800, 600)" << std::endl;
+
+    TString pad = canvas;
+    if(c->HasLowerPad()) {
+      pad = Form("up%i", i);
+      out << "up" << i << " = ROOT.TPad(\"up" << i << "\", \"\", .001, .29, .999, .999)" << std::endl;
+      out << "down" << i << " = ROOT.TPad(\"down" << i << "\", \"\", .001, .001, .999, .28)" << std::endl;
+      out << "up" << i << ".SetBottomMargin(0.01)" << std::endl;
+      out << "down" << i << ".SetTopMargin(0.01)" << std::endl;
+      out << "down" << i << ".SetBottomMargin(0.2)" << std::endl;
+      out << "up" << i << ".Draw()" << std::endl;
+      out << "down" << i << ".Draw()" << std::endl;
+      out << "up" << i << ".cd()" << std::endl;
+    }
+    if(c->GetLogX()) out << pad << ".SetLogx()" << std::endl;
+    if(c->GetLogY()) out << pad << ".SetLogy()" << std::endl;
+
+    for(int j=0; j<c->GetNumberOfHistos(); j++){
+      HistoInfo *h = c->GetHisto(j);
+      TString var = Form("c%i_%i", i, j);
+
+      out << var << " = " << m_load_names[h->GetKey()] << ".Clone(\"" << var << "\")" << std::endl;
+      out << var << ".SetLineColor(" << h->GetColour() << ")" << std::endl;
+      out << var << ".SetMarkerColor(" << h->GetColour() << ")" << std::endl;
+      out << var << ".SetMarkerStyle(20)" << std::endl;
+      out << var << ".SetMarkerSize(0.8)" << std::endl;
+      if(h->IsGraph()) continue;
+
+      if(h->GetFill()) out << var << ".SetFillColor(" << h->GetColour() << ")" << std::endl;
+      out << var << ".SetLineWidth(2)" << std::endl;
+      out << var << ".SetStats(0)" << std::endl;
+      if(h->GetRebinNumber()) out << var << ".Rebin(" << h->GetRebinNumber() << ")" << std::endl;
+      if(h->GetScaleFactor() != 1.) out << var << ".Scale(" << h->GetScaleFactor() << ")" << std::endl;
+      if(c->GetNormalise())
+        out << var << ".Scale(1./" << var << ".Integral())" << std::endl;
+      else if(c->GetNormaliseToFirst() && j > 0)
+        out << var << ".Scale(c" << i << "_0.Integral()/" << var << ".Integral())" << std::endl;
+    }
+
+    for(int j=0; j<c->GetNumberOfHistos(); j++){
+      HistoInfo *h = c->GetHisto(j);
+      TString opts = h->GetDrawOption();
+      if(h->IsGraph()) opts = (j==0 ? "APZ" : "PZ") + opts;
+      else if(j > 0) opts += "same";
+      out << "c" << i << "_" << j << ".Draw(\"" << opts << "\")" << std::endl;
+    }
+
+    if(c->GetNumberOfHistos() > 1){
+      out << "legend" << i << " = ROOT.TLegend(0.7,0.7,0.9,0.9)" << std::endl;
+      out << "legend" << i << ".SetFillColor(0)" << std::endl;
+      out << "legend" << i << ".SetBorderSize(0)" << std::endl;
+      for(int j=0; j<c->GetNumberOfHistos(); j++){
+        out << "legend" << i << ".AddEntry(c" << i << "_" << j << ", \"" << escape(c->GetHisto(j)->GetLegendText()) << "\")" << std::endl;
+      }
+      out << "legend" << i << ".Draw()" << std::endl;
+    }
+
+    if(c->HasLowerPad()) {
+      out << "down" << i << ".cd()" << std::endl;
+      if(c->GetLogX()) out << "down" << i << ".SetLogx()" << std::endl;
+      for(int j=1; j<c->GetNumberOfHistos(); j++){
+        TString var = Form("r%i_%i", i, j);
+        out << var << " = c" << i << "_" << j << ".Clone(\"" << var << "\")" << std::endl;
+        if(c->GetDiff()) out << var << ".Add(c" << i << "_0, -1)" << std::endl;
+        out << var << ".Divide(c" << i << "_0)" << std::endl;
+        if(j == 1) out << var << ".GetYaxis().SetTitle(\"" << (c->GetDiff() ? "Relative difference" : "Ratio") << "\")" << std::endl;
+        out << var << ".Draw(\"" << (j == 1 ? "" : "same") << "\")" << std::endl;
+      }
+    }
+
+    out << canvas << ".Print(\"" << escape(c->GetName()) << ".eps\")" << std::endl;
+    out << std::endl;
+  }
 }
@@ -10,6 +10,7 @@
 #include <TString.h>
 #include <algorithm>
 #include <vector>
+#include <map>
 #include <fstream>
 #include <sstream>
 
@@ -24,15 +25,23 @@ struct Axis {
   Double_t max;
 };
 
+/** One object drawn in a canvas: an object of a file (path/name) or a
+    tree draw (tree, expression in name, cut and binning) */
 class HistoInfo
 {
  private:
   Int_t    m_file;
   TString  m_name;
   TString  m_title;
+  TString  m_path;
+  TString  m_tree;
+  TString  m_cut;
+  TString  m_binning;
+  Bool_t   m_is_graph;
   TString  m_drawoption;
   Int_t    m_rebin;
   Color_t  m_colour;
+  Bool_t   m_fill;
   Double_t m_scale_factor;
   TString  m_leg_text;
 
@@ -43,17 +52,31 @@ class HistoInfo
   void SetRebinNumber(Int_t input){ m_rebin = input; };
   void SetScaleFactor(Double_t input){ m_scale_factor = input; };
   void SetColour(Color_t input){ m_colour = input; };
+  void SetFill(Bool_t input){ m_fill = input; };
   void SetLegendText(TString input){ m_leg_text = input; };
+  void SetPath(TString input){ m_path = input; };
+  void SetGraph(Bool_t input){ m_is_graph = input; };
+  void SetTreeDraw(TString tree, TString cut, TString binning="");
   Bool_t operator= (HistoInfo* other);
 
   Int_t    GetFile() { return m_file; };
   TString  GetName() { return m_name; };
+  TString  GetTitle() { return m_title; };
+  TString  GetFullPath() { return m_path.IsNull() ? m_name : m_path + "/" + m_name; };
+  TString  GetTree() { return m_tree; };
+  TString  GetCut() { return m_cut; };
+  TString  GetBinning() { return m_binning; };
   TString  GetDrawOption() { return m_drawoption; };
   Color_t  GetColour() { return m_colour; };
+  Bool_t   GetFill() { return m_fill; };
   Int_t    GetRebinNumber() { return (m_rebin >1) ? m_rebin : 0; };
   Double_t GetScaleFactor() { return m_scale_factor; };
   TString  GetMacroName();
   TString  GetLegendText(){ return m_leg_text; };
+  TString  GetKey();
+
+  Bool_t   IsTreeDraw() { return !m_tree.IsNull(); };
+  Bool_t   IsGraph() { return m_is_graph; };
 
 };
 
@@ -63,21 +86,47 @@ class CanvasInfo {
   TString m_name;
   Axis m_xaxis, m_yaxis;
   std::vector<HistoInfo*> m_histos;
+  Bool_t m_logx, m_logy;
+  Bool_t m_normalise, m_normalise_to_first;
+  Bool_t m_ratio, m_diff;
 
  public:
- CanvasInfo(TString name) : m_name(name) {};
+  CanvasInfo(TString name);
+  ~CanvasInfo();
 
   TString GetName() { return m_name; };
   std::vector<HistoInfo*> GetHistos(){ return m_histos; };
   HistoInfo* GetHisto(int index){ return m_histos[index]; };
   Int_t GetNumberOfHistos(){ return m_histos.size(); };
 
+  void SetLog(Bool_t x, Bool_t y) { m_logx = x; m_logy = y; };
+  void SetNormalise(Bool_t norm, Bool_t to_first) { m_normalise = norm; m_normalise_to_first = to_first; };
+  Bool_t GetLogX() { return m_logx; };
+  Bool_t GetLogY() { return m_logy; };
+  Bool_t GetNormalise() { return m_normalise; };
+  Bool_t GetNormaliseToFirst() { return m_normalise_to_first; };
+
+  void SetRatio(Bool_t ratio, Bool_t diff) { m_ratio = ratio; m_diff = diff; };
+  Bool_t GetRatio() { return m_ratio; };
+  Bool_t GetDiff() { return m_diff; };
+  Bool_t HasLowerPad();
+
   void AddHisto(HistoInfo* histo);
   void AddLegend(std::vector<TString>);
 
 };
 
 
+/** Records the canvases drawn and writes a ROOT or python macro to make
+    them again.
+
+    In the macro each (file, object) is loaded only once, even if it is
+    drawn in many canvases. In ROOT macros all the tree draws with the
+    same tree and cut are filled in a single loop over the tree; python
+    macros use one tree.Draw each (a loop in python would be much
+    slower). Each canvas then draws its own copy of the loaded objects,
+    so the styling of one canvas doesn't change the others.
+*/
 class Macro
 {
 
@@ -85,19 +134,31 @@ class Macro
   TString m_name;
   std::vector<TString> m_files;
   std::vector<CanvasInfo*>  m_canvases;
-  Int_t canvas_counter;
+
+  void WriteRoot(std::ofstream&);
+  void WritePython(std::ofstream&);
+  void BuildLoads();
+
+  // filled by BuildLoads
+  std::vector<HistoInfo*> m_loads;                 // objects to read, one per key
+  std::vector<std::vector<HistoInfo*> > m_loops;   // tree draws, one loop each
+  std::map<TString, TString> m_load_names;          // key -> variable in the macro
 
  public:
   Macro(TString name) : m_name(name) {};
   virtual ~Macro();
 
-  void   AddFile(TString);
+  Int_t  AddFile(TString);
   void   AddCanvas(TString);
+  void   AddCanvas(CanvasInfo*);
+  void   RemoveCanvas(TString);
   void   AddHisto(HistoInfo *h);
   void   AddLegend(std::vector<TString>);
   void   Reset();
   void   SaveMacro(TString, OutputFormat);
 
+  Int_t  GetNumberOfCanvases() { return m_canvases.size(); };
+
 };
 
 #endif
@@ -11,23 +11,96 @@
 #define NAME    "plotter"
 #define VERSION "0.4"
 
+#include <glob.h>
+#include <algorithm>
+
+#include <TSystem.h>
+
 #include "plotter.h"
+#include "catalog.h"
+#include "filepool.h"
+#include "batch.h"
+#include "export.h"
+#include "workers.h"
+#include "stats.h"
+#include "trace.h"
+#include "memory.h"
+#include "daemon.h"
+#include "resultcache.h"
 
 void show_usage()
 {
   std::cout << NAME << " " << VERSION << std::endl;
   std::cout << std::endl;
-  std::cout << "Usage: " << NAME << " file1.root file2.root file3.root ..." << std::endl;
+  std::cout << "Usage: " << NAME << " [options] file1.root file2.root dir/ 'files*.root' ..." << std::endl;
+  std::cout << std::endl;
+  std::cout << "Options:" << std::endl;
+  std::cout << "  --max-open-files N  Maximum number of files kept open at the same time (default: 50)" << std::endl;
+  std::cout << "  --max-plots N       Maximum number of plots kept open, the oldest ones are closed (default: no limit)" << std::endl;
+  std::cout << "  --memory-budget N   Memory for objects, plots and caches, e.g. 4G or 500M (default: half of the RAM)" << std::endl;
+  std::cout << "  --cache-size N      Size of the cache of tree draws kept between sessions, 0 to disable (default: 1G)" << std::endl;
+  std::cout << "  --clear-cache       Empty the cache of tree draws and exit" << std::endl;
+  std::cout << "  --stats FILE        Write the time spent in each stage and the I/O counters of the session to FILE (JSON)" << std::endl;
+  std::cout << "  --trace FILE        Record a Chrome trace of the session in FILE (or set PLOTTER_TRACE=FILE)" << std::endl;
+  std::cout << std::endl;
+  std::cout << "Batch mode (no gui):" << std::endl;
+  std::cout << "  -b, --batch         Plot each object of the first file together with the same object of the other files" << std::endl;
+  std::cout << "  -s, --spec FILE     Make the plots of a plot specification file (no input files needed)" << std::endl;
+  std::cout << "  -o, --output DIR    Output directory (default: .)" << std::endl;
+  std::cout << "  -f, --formats LIST  Comma separated output formats: png,pdf,svg,eps,... (default: png)" << std::endl;
+  std::cout << "  -j, --jobs N        Number of worker processes (default: number of cores)" << std::endl;
+  std::cout << "  --ratio             Include the ratio to the first file" << std::endl;
+  std::cout << "  --logy              Use log scale in the y axis" << std::endl;
+  std::cout << std::endl;
+  std::cout << "Export (no gui):" << std::endl;
+  std::cout << "  --export-canvases FILE" << std::endl;
+  std::cout << "                      Export the canvases of a ROOT file to the formats of -f, in -o (with -j workers)" << std::endl;
+  std::cout << "  --name NAME         Name of the multi-page pdf (default: plots)" << std::endl;
+  std::cout << "  --dpi N             Resolution of the png files (default: 96)" << std::endl;
+  std::cout << std::endl;
+  std::cout << "Daemon:" << std::endl;
+  std::cout << "  --daemon            Keep files, catalogs and loaded objects warm and serve the other plotter processes" << std::endl;
+  std::cout << "  --socket PATH       Socket of the daemon (default: $PLOTTER_SOCKET, $XDG_RUNTIME_DIR/plotter.sock or plotter-UID/plotter.sock in the temp directory)" << std::endl;
+  std::cout << "  --client            Send the request to the daemon: plots of --spec, catalog of the files, or its stats" << std::endl;
+  std::cout << "  --stop-daemon       Stop the daemon" << std::endl;
   std::cout << std::endl;
 }
 
-int main(int argc, char **argv)
+/** Add the files of an argument: a file, a directory (all the .root
+    files inside) or a glob pattern */
+void add_files(TString arg, std::vector<TString> &files)
 {
-  if(gROOT->IsBatch()) {
-    fprintf(stderr, "%s: cannot run in batch mode\n", argv[0]);
-    return 1;
+  if(arg.Contains("*") || arg.Contains("?") || arg.Contains("[")) {
+    glob_t g;
+    if(glob(arg.Data(), 0, 0, &g) == 0) {
+      for(size_t i=0; i<g.gl_pathc; i++) files.push_back(g.gl_pathv[i]);
+    }
+    globfree(&g);
+    return;
+  }
+
+  Long_t id, flags, modtime;
+  Long64_t size;
+  if(gSystem->GetPathInfo(arg, &id, &size, &flags, &modtime) == 0 && (flags & 2)) {
+    std::vector<TString> dir_files;
+    void *dir = gSystem->OpenDirectory(arg);
+    const char *entry;
+    while((entry = gSystem->GetDirEntry(dir))) {
+      TString name = entry;
+      if(name.EndsWith(".root")) dir_files.push_back(arg + "/" + name);
+    }
+    gSystem->FreeDirectory(dir);
+
+    std::sort(dir_files.begin(), dir_files.end());
+    files.insert(files.end(), dir_files.begin(), dir_files.end());
+    return;
   }
 
+  files.push_back(arg);
+}
+
+int main(int argc, char **argv)
+{
   // If no arguments: show version/usage
   if(argc < 2 || strcmp("-h",argv[1])==0 || strcmp("--help",argv[1])==0){
     show_usage();
@@ -47,13 +120,207 @@ int main(int argc, char **argv)
   //   }
   // }
 
+  if(gSystem->Getenv("PLOTTER_TRACE")) Trace::Instance()->Enable(gSystem->Getenv("PLOTTER_TRACE"));
+
+  // Batch mode options
+  unsigned int max_plots = 0;
+  TString stats_file = "";
+  bool batch = false;
+  TString spec_file = "";
+  TString output_dir = ".";
+  TString formats = "png";
+  unsigned int jobs = number_of_cores();
+  bool ratio = false;
+  bool logy = false;
+
+  // Export options
+  TString export_file = "";
+  TString export_name = "plots";
+  Int_t dpi = 96;
+
+  // Daemon options
+  bool daemon = false;
+  bool client = false;
+  bool stop_daemon = false;
+  TString socket = default_socket_path();
+
+  while(argpos < argc && argv[argpos][0] == '-') {
+    if(strcmp(argv[argpos], "--max-open-files")==0 && argpos+1 < argc) {
+      FilePool::Instance()->SetMaxOpen(atoi(argv[++argpos]));
+    }
+    else if(strcmp(argv[argpos], "--max-plots")==0 && argpos+1 < argc) {
+      max_plots = atoi(argv[++argpos]);
+    }
+    else if(strcmp(argv[argpos], "--memory-budget")==0 && argpos+1 < argc) {
+      Long64_t budget = MemoryAccountant::ParseSize(argv[++argpos]);
+      if(budget < 0) {
+        error("Invalid memory budget " << argv[argpos]);
+        return 1;
+      }
+      MemoryAccountant::Instance()->SetBudget(budget);
+    }
+    else if(strcmp(argv[argpos], "--cache-size")==0 && argpos+1 < argc) {
+      Long64_t size = MemoryAccountant::ParseSize(argv[++argpos]);
+      if(size < 0) {
+        error("Invalid cache size " << argv[argpos]);
+        return 1;
+      }
+      ResultCache::Instance()->SetMaxSize(size);
+    }
+    else if(strcmp(argv[argpos], "--clear-cache")==0) {
+      ResultCache::Instance()->Clear();
+      msg("Cache of tree draws in " << ResultCache::Instance()->GetDir() << " cleared");
+      return 0;
+    }
+    else if(strcmp(argv[argpos], "--stats")==0 && argpos+1 < argc) {
+      stats_file = argv[++argpos];
+    }
+    else if(strcmp(argv[argpos], "--trace")==0 && argpos+1 < argc) {
+      Trace::Instance()->Enable(argv[++argpos]);
+    }
+    else if(strcmp(argv[argpos], "-b")==0 || strcmp(argv[argpos], "--batch")==0) {
+      batch = true;
+    }
+    else if((strcmp(argv[argpos], "-s")==0 || strcmp(argv[argpos], "--spec")==0) && argpos+1 < argc) {
+      spec_file = argv[++argpos];
+    }
+    else if((strcmp(argv[argpos], "-o")==0 || strcmp(argv[argpos], "--output")==0) && argpos+1 < argc) {
+      output_dir = argv[++argpos];
+    }
+    else if((strcmp(argv[argpos], "-f")==0 || strcmp(argv[argpos], "--formats")==0) && argpos+1 < argc) {
+      formats = argv[++argpos];
+    }
+    else if((strcmp(argv[argpos], "-j")==0 || strcmp(argv[argpos], "--jobs")==0) && argpos+1 < argc) {
+      jobs = atoi(argv[++argpos]);
+    }
+    else if(strcmp(argv[argpos], "--ratio")==0) {
+      ratio = true;
+    }
+    else if(strcmp(argv[argpos], "--logy")==0) {
+      logy = true;
+    }
+    else if(strcmp(argv[argpos], "--export-canvases")==0 && argpos+1 < argc) {
+      export_file = argv[++argpos];
+    }
+    else if(strcmp(argv[argpos], "--name")==0 && argpos+1 < argc) {
+      export_name = argv[++argpos];
+    }
+    else if(strcmp(argv[argpos], "--dpi")==0 && argpos+1 < argc) {
+      dpi = atoi(argv[++argpos]);
+    }
+    else if(strcmp(argv[argpos], "--daemon")==0) {
+      daemon = true;
+    }
+    else if(strcmp(argv[argpos], "--socket")==0 && argpos+1 < argc) {
+      socket = argv[++argpos];
+    }
+    else if(strcmp(argv[argpos], "--client")==0) {
+      client = true;
+    }
+    else if(strcmp(argv[argpos], "--stop-daemon")==0) {
+      client = true;
+      stop_daemon = true;
+    }
+    else {
+      show_usage();
+      return 1;
+    }
+    argpos++;
+  }
+
+  if(argc <= argpos && !(batch && !spec_file.IsNull()) && !daemon && !client && export_file.IsNull()) {
+    show_usage();
+    return 1;
+  }
+
   // Get files from args
   std::vector<TString> files;
   for (int i = argpos; i < argc; i++){
-    TString tmp = argv[i];
-    files.push_back(tmp);
+    add_files(argv[i], files);
+  }
+
+  // Export: canvases of a file, also used by the gui to export
+  if(!export_file.IsNull()) {
+    gROOT->SetBatch(kTRUE);
+
+    Exporter e(output_dir, export_name);
+    e.SetFormats(formats);
+    e.SetDpi(dpi);
+    e.SetJobs(jobs);
+    return e.ExportFile(export_file) ? 1 : 0;
   }
 
+  // Daemon: serve requests until stopped
+  if(daemon) {
+    gROOT->SetBatch(kTRUE);
+
+    int status = Daemon(socket).Run();
+    if(!stats_file.IsNull()) Stats::Instance()->WriteJson(stats_file);
+    Trace::Instance()->Write();
+    return status;
+  }
+
+  // Client: the daemon does the work
+  if(client) {
+    std::vector<TString> requests;
+    if(stop_daemon)
+      requests.push_back("stop");
+    else if(!spec_file.IsNull())
+      requests.push_back(Form("plot\t%s\t%s\t%s\t%s\t%u", gSystem->WorkingDirectory(), absolute_path(spec_file).Data(),
+                              absolute_path(output_dir).Data(), formats.Data(), jobs));
+    else if(!files.empty()) {
+      for(unsigned int i=0; i<files.size(); i++) requests.push_back("scan\t" + absolute_path(files[i]));
+    }
+    else
+      requests.push_back("stats");
+
+    DaemonClient dc(socket);
+    if(!dc.IsRunning()) {
+      error("No daemon listening on " << socket << " (start it with plotter --daemon)");
+      return 1;
+    }
+
+    int status = 0;
+    for(unsigned int i=0; i<requests.size(); i++){
+      TString reply;
+      if(!dc.Request(requests[i], reply)) {
+        error(reply);
+        status = 1;
+      }
+      else std::cout << reply;
+    }
+    return status;
+  }
+
+  // Batch mode: no gui
+  if(batch) {
+    gROOT->SetBatch(kTRUE);
+
+    Batch b;
+    if(!spec_file.IsNull()) {
+      if(!b.AddSpecs(spec_file)) return 1;
+    }
+    else b.AddComparison(files);
+    b.SetOutputDir(output_dir);
+    b.SetFormats(formats);
+    b.SetJobs(jobs);
+    b.SetIncludeRatio(ratio);
+    b.SetLogY(logy);
+
+    int status = b.Run();
+    if(!stats_file.IsNull()) Stats::Instance()->WriteJson(stats_file);
+    Trace::Instance()->Write();
+    return status;
+  }
+
+  if(gROOT->IsBatch()) {
+    fprintf(stderr, "%s: cannot run the gui in batch mode (use --batch)\n", argv[0]);
+    return 1;
+  }
+
+  // the gui exports in a new plotter process
+  Exporter::SetProgram(argv[0]);
+
   // Application
   TApplication *rootApp = new TApplication("Plotter", &argc, argv);
 
@@ -61,7 +328,12 @@ int main(int argc, char **argv)
   std::cout << "   " << NAME << std::endl;
   std::cout << " -----------" << std::endl;
 
+  // the catalogs are taken from the daemon, if there is one
+  if(DaemonClient(socket).IsRunning()) Catalog::SetDaemon(socket);
+
   Plotter p(files, merge);
+  p.SetMaxPlots(max_plots);
+  p.SetStatsFile(stats_file);
 
   rootApp->Run();
 
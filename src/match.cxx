@@ -0,0 +1,70 @@
+/** @file match.cxx
+    @brief Matcher class implementation
+*/
+
+#include <string>
+#include <unordered_map>
+
+#include <TDirectory.h>
+#include <TFile.h>
+#include <TH1.h>
+
+#include "common.h"
+#include "item.h"
+#include "catalog.h"
+#include "match.h"
+
+Matcher::Matcher(std::vector<Catalog*> catalogs) :
+  m_catalogs(catalogs)
+{
+}
+
+Matcher::~Matcher()
+{
+  for(unsigned int k=0; k<m_matches.size(); k++) delete m_matches[k];
+}
+
+/** Paths found in at least min_files files, in the order of the files
+    and entries. Returns the number of matched paths */
+unsigned int Matcher::Join(unsigned int min_files)
+{
+  std::unordered_map<std::string, unsigned int> index;
+  std::vector<MatchedPath*> all;
+
+  for(unsigned int f=0; f<m_catalogs.size(); f++){
+    std::vector<Item*> items = m_catalogs[f]->GetPlotableItems();
+    for(unsigned int k=0; k<items.size(); k++){
+      std::string path = items[k]->GetFullPath().Data();
+
+      std::unordered_map<std::string, unsigned int>::iterator it = index.find(path);
+      MatchedPath *match = 0;
+      if(it == index.end()) {
+        match = new MatchedPath();
+        match->path = path.c_str();
+        index[path] = all.size();
+        all.push_back(match);
+      }
+      else match = all[it->second];
+
+      match->items.push_back(items[k]);
+      match->files.push_back(f);
+    }
+  }
+
+  for(unsigned int k=0; k<all.size(); k++){
+    if(all[k]->items.size() < min_files) delete all[k];
+    else m_matches.push_back(all[k]);
+  }
+
+  return m_matches.size();
+}
+
+/** Read the object of the item from a file opened outside the file pool
+    (e.g. in a worker), detached from the file */
+TObject* Matcher::ReadItem(TFile *file, Item *item)
+{
+  TDirectory *dir = item->GetPath().IsNull() ? file : file->GetDirectory(item->GetPath());
+  TObject *obj = dir ? dir->Get(item->GetName()) : 0;
+  if(obj && obj->InheritsFrom("TH1")) ((TH1*)obj)->SetDirectory(0);
+  return obj;
+}
@@ -0,0 +1,43 @@
+/** @file match.h
+    @brief Matching of the objects of several files by path
+*/
+
+#ifndef MATCH_H
+#define MATCH_H
+
+#include <vector>
+
+#include <TROOT.h>
+#include <TString.h>
+
+class Item;
+class Catalog;
+class TFile;
+
+/** An object path and its item and object in each file that has it */
+struct MatchedPath {
+  TString path;
+  std::vector<Item*> items;
+  std::vector<unsigned int> files; // position of the catalog of each item
+};
+
+/** Join the plotable objects (not branches) of all the catalogs on their
+    full path, with a hash index */
+class Matcher {
+
+ public:
+  Matcher(std::vector<Catalog*> catalogs);
+  ~Matcher();
+
+  unsigned int Join(unsigned int min_files=2);
+
+  std::vector<MatchedPath*>& GetMatches() { return m_matches; }
+
+  static TObject* ReadItem(TFile *file, Item *item);
+
+ private:
+  std::vector<Catalog*> m_catalogs;
+  std::vector<MatchedPath*> m_matches;
+};
+
+#endif
@@ -0,0 +1,164 @@
+/** @file memory.cxx
+    @brief MemoryAccountant implementation
+*/
+
+#include <unistd.h>
+#include <cstdlib>
+
+#include <TH1.h>
+#include <TGraph.h>
+
+#include "ratio.h"
+#include "memory.h"
+#include "stats.h"
+#include "common.h"
+
+MemoryAccountant* MemoryAccountant::Instance()
+{
+  static MemoryAccountant accountant;
+  return &accountant;
+}
+
+/** By default the budget is half of the physical memory */
+MemoryAccountant::MemoryAccountant() :
+  m_total(0),
+  m_budget(0),
+  m_enforcing(false),
+  m_warned(false)
+{
+  for(Int_t k=0; k<kNMemKinds; k++) m_kind_total[k] = 0;
+
+  long pages = sysconf(_SC_PHYS_PAGES);
+  long page_size = sysconf(_SC_PAGE_SIZE);
+  if(pages > 0 && page_size > 0) m_budget = (Long64_t)pages*page_size/2;
+}
+
+/** Set (or update) the bytes of an owner */
+void MemoryAccountant::Add(const void *owner, MemoryKind kind, Long64_t bytes)
+{
+  Remove(owner);
+
+  Entry e;
+  e.kind = kind;
+  e.bytes = bytes;
+  m_owners[owner] = e;
+  m_kind_total[kind] += bytes;
+  m_total += bytes;
+
+  Enforce();
+}
+
+void MemoryAccountant::Remove(const void *owner)
+{
+  std::map<const void*, Entry>::iterator it = m_owners.find(owner);
+  if(it == m_owners.end()) return;
+
+  m_kind_total[it->second.kind] -= it->second.bytes;
+  m_total -= it->second.bytes;
+  m_owners.erase(it);
+
+  if(m_warned && Fits(0)) m_warned = false;
+}
+
+void MemoryAccountant::AddCache(MemoryCache *cache)
+{
+  m_caches.push_back(cache);
+}
+
+void MemoryAccountant::RemoveCache(MemoryCache *cache)
+{
+  m_caches.remove(cache);
+}
+
+/** The cache was used: evict it last */
+void MemoryAccountant::Touch(MemoryCache *cache)
+{
+  if(!m_caches.empty() && m_caches.back() == cache) return;
+  m_caches.remove(cache);
+  m_caches.push_back(cache);
+}
+
+/** Over the budget, evict the least recently used caches until it fits
+    again (or there is nothing else to evict), and warn once */
+void MemoryAccountant::Enforce()
+{
+  if(Fits(0) || m_enforcing) return;
+  m_enforcing = true;
+
+  // the most recently used cache is the one being built or drawn
+  std::list<MemoryCache*> caches(m_caches);
+  if(!caches.empty()) caches.pop_back();
+
+  Long64_t freed = 0;
+  for(std::list<MemoryCache*>::iterator it=caches.begin(); it!=caches.end() && !Fits(0); ++it)
+    freed += (*it)->Evict();
+
+  m_enforcing = false;
+
+  if(freed > 0) {
+    msg("Memory budget exceeded: " << format_bytes(freed) << " of caches evicted");
+  }
+
+  if(!Fits(0) && !m_warned) {
+    error("Memory budget exceeded: " << format_bytes(m_total) << " used of " << format_bytes(m_budget)
+          << ". Close some plots");
+    m_warned = true;
+  }
+}
+
+/** e.g. "Memory: 1.2 GB / 7.8 GB" */
+TString MemoryAccountant::GetSummary()
+{
+  if(m_budget <= 0) return Form("Memory: %s", format_bytes(m_total).Data());
+  return Form("Memory: %s / %s", format_bytes(m_total).Data(), format_bytes(m_budget).Data());
+}
+
+/** Estimated bytes of the contents of a histogram or graph */
+Long64_t MemoryAccountant::ObjectBytes(TObject *obj)
+{
+  if(!obj) return 0;
+
+  if(obj->InheritsFrom("TH1")) {
+    TH1 *h = (TH1*)obj;
+    Long64_t cells = (Long64_t)(h->GetNbinsX()+2);
+    if(h->GetDimension() > 1) cells *= h->GetNbinsY()+2;
+    if(h->GetDimension() > 2) cells *= h->GetNbinsZ()+2;
+
+    Int_t size = 8;
+    if(h->InheritsFrom("TArrayF") || h->InheritsFrom("TArrayI")) size = 4;
+    else if(h->InheritsFrom("TArrayS")) size = 2;
+    else if(h->InheritsFrom("TArrayC")) size = 1;
+
+    Long64_t bytes = cells*size + (Long64_t)h->GetSumw2N()*8;
+
+    // profiles also keep the entries and the sum of weights^2 of each bin
+    if(is_profile(h)) bytes += 2*cells*8;
+
+    return bytes;
+  }
+
+  if(obj->InheritsFrom("TGraph")) {
+    Int_t arrays = 2;
+    if(obj->InheritsFrom("TGraphAsymmErrors")) arrays = 6;
+    else if(obj->InheritsFrom("TGraphErrors")) arrays = 4;
+    return (Long64_t)((TGraph*)obj)->GetN()*arrays*8;
+  }
+
+  return 0;
+}
+
+/** Size like 4G, 500M, 64k or a number of bytes. Returns -1 if invalid */
+Long64_t MemoryAccountant::ParseSize(TString size)
+{
+  size.ToUpper();
+  size.ReplaceAll("B", "");
+
+  Long64_t unit = 1;
+  if(size.EndsWith("K")) unit = 1024;
+  else if(size.EndsWith("M")) unit = 1048576;
+  else if(size.EndsWith("G")) unit = 1073741824;
+  if(unit > 1) size.Chop();
+
+  if(!size.IsFloat()) return -1;
+  return (Long64_t)(size.Atof()*unit);
+}
@@ -0,0 +1,78 @@
+/** @file memory.h
+    @brief Accounting of the memory used by objects, plots and caches
+*/
+
+#ifndef MEMORY_H
+#define MEMORY_H
+
+#include <list>
+#include <map>
+
+#include <TROOT.h>
+#include <TString.h>
+
+enum MemoryKind {
+  kMemObjects,  // histograms and graphs of the plots
+  kMemCanvases, // canvas pixmaps
+  kMemCaches,   // LOD pyramids, ...
+  kNMemKinds
+};
+
+/** A cache that can free memory when the budget is exceeded */
+class MemoryCache {
+
+ public:
+  virtual ~MemoryCache() {}
+
+  /** Free what can be rebuilt later. Returns the bytes freed */
+  virtual Long64_t Evict() = 0;
+};
+
+/** Estimated bytes of every registered owner (an Obj, a Plot, a
+    cache...), and a global budget. When a registration goes over the
+    budget the caches are asked to evict, least recently used first.
+    The estimates only count the bin contents/points and the pixmaps,
+    not the ROOT overhead of each object */
+class MemoryAccountant {
+
+ public:
+  static MemoryAccountant* Instance();
+
+  void Add(const void *owner, MemoryKind kind, Long64_t bytes);
+  void Remove(const void *owner);
+
+  void AddCache(MemoryCache *cache);
+  void RemoveCache(MemoryCache *cache);
+  void Touch(MemoryCache *cache);
+
+  void SetBudget(Long64_t bytes) { m_budget = bytes; Enforce(); }
+  Long64_t GetBudget() { return m_budget; }
+  Long64_t GetTotal() { return m_total; }
+  Long64_t GetTotal(MemoryKind kind) { return m_kind_total[kind]; }
+  bool Fits(Long64_t bytes) { return m_budget <= 0 || m_total + bytes <= m_budget; }
+
+  TString GetSummary();
+
+  static Long64_t ObjectBytes(TObject *obj);
+  static Long64_t ParseSize(TString size);
+
+ private:
+  MemoryAccountant();
+
+  void Enforce();
+
+  struct Entry {
+    MemoryKind kind;
+    Long64_t bytes;
+  };
+
+  std::map<const void*, Entry> m_owners;
+  std::list<MemoryCache*> m_caches; // front: least recently used
+  Long64_t m_kind_total[kNMemKinds];
+  Long64_t m_total;
+  Long64_t m_budget;
+  bool m_enforcing;
+  bool m_warned;
+};
+
+#endif
@@ -5,35 +5,48 @@
 #include <iostream>
 
 #include "obj.h"
-
-Obj::Obj(Obj *obj1, Obj *obj2, std::string operation)
-{
-  if(operation == "ratio"){
-    TH1 *h_ratio = (TH1*)obj1->GetHist()->Clone("h_ratio");
-    h_ratio->Divide(obj2->GetHist());
-
-    m_type = Hist;
-    m_hist = h_ratio;
-    m_opts = "";
-  }
-  else if(operation == "difference"){
-    TH1 *h_diff = (TH1*)obj1->GetHist()->Clone("h_diff");
-    h_diff->Add(obj2->GetHist(), -1.0);
-    h_diff->Divide(obj1->GetHist());
-
-    m_type = Hist;
-    m_hist = h_diff;
-    m_opts = "";
+#include "ratio.h"
+#include "efficiency.h"
+#include "lodgraph.h"
+#include "lodhist.h"
+#include "memory.h"
+
+Obj::Obj(Obj *obj1, Obj *obj2, std::string operation) :
+  m_type(Hist),
+  m_hist(0),
+  m_graph(0),
+  m_display(0),
+  m_opts("")
+{
+  if(operation == "ratio" || operation == "difference"){
+    std::vector<TH1*> num(1, obj1->GetHist());
+    std::vector<TH1*> result = compute_ratios(obj2->GetHist(), num,
+                                              operation == "ratio" ? kRatio : kDifference);
+    m_hist = result[0];
   }
   else if(operation == "efficiency"){
-    TGraphAsymmErrors *gr = new TGraphAsymmErrors();
-
-    gr->Divide(obj2->GetHist(), obj1->GetHist(), "cl=0.683 b(0.5,0.5) mode");
+    Efficiency engine(kJeffreys);
 
     m_type = Graph;
-    m_graph = gr;
-    m_opts = "";
+    m_graph = engine.Compute(obj2->GetHist(), obj1->GetHist());
   }
+
+  Account();
+}
+
+Obj::~Obj()
+{
+  MemoryAccountant::Instance()->Remove(this);
+  delete m_display;
+  delete m_hist;
+  delete m_graph;
+}
+
+/** Register the size of the object with the memory accountant */
+void Obj::Account()
+{
+  TObject *obj = (m_type == Hist) ? (TObject*)m_hist : (TObject*)m_graph;
+  MemoryAccountant::Instance()->Add(this, kMemObjects, MemoryAccountant::ObjectBytes(obj));
 }
 
 TString Obj::GetName()
@@ -107,9 +120,9 @@ void Obj::SetStyle()
     m_hist->SetLineWidth(2);
   }
   else if(m_type == Graph){
-    m_hist->SetMarkerStyle(20);
-    m_hist->SetMarkerSize(0.8);
-    m_opts += "PZT";
+    m_graph->SetMarkerStyle(20);
+    m_graph->SetMarkerSize(0.8);
+    m_opts = "PZ";
   }
 
 }
@@ -131,6 +144,7 @@ void Obj::Rebin(int group)
 {
   if(m_type == Hist) m_hist->Rebin(group);
   else return;
+  Account();
 }
 
 double Obj::Integral()
@@ -148,10 +162,23 @@ void Obj::NormaliseTo(double norm)
 
 void Obj::Draw(TString options)
 {
+  // large objects are drawn decimated, m_hist/m_graph keep all the points
+  delete m_display;
+  m_display = 0;
+
   if(m_type == Hist) {
-    m_hist->Draw(options+m_opts);
+    if(HistPyramid::IsLarge(m_hist)) {
+      if(m_hist->GetDimension() == 3) m_display = new LodHist3D(m_hist);
+      else m_display = new LodHist2D(m_hist);
+      m_display->Draw(options+m_opts);
+    }
+    else m_hist->Draw(options+m_opts);
   }
   else if(m_type == Graph) {
-    m_graph->Draw(options+m_opts);
+    if(LodGraph::IsLarge(m_graph)) {
+      m_display = new LodGraph(m_graph);
+      m_display->Draw(options+m_opts);
+    }
+    else m_graph->Draw(options+m_opts);
   }
 }
@@ -22,15 +22,21 @@ class Obj {
 
   TH1    *m_hist;
   TGraph *m_graph;
+  TObject *m_display; // decimated copy drawn instead of a very large graph/histogram
 
   TString m_opts;
+  TString m_info; // e.g. the I/O statistics of a tree draw
+
+  // the object is owned: no copies
+  Obj(const Obj&);
+  Obj& operator=(const Obj&);
 
  public:
-  Obj(TH1 *obj) : m_type(Hist), m_hist(obj), m_opts("") { }
-  Obj(TGraph *obj) : m_type(Graph), m_graph(obj), m_opts("") { }
+  Obj(TH1 *obj) : m_type(Hist), m_hist(obj), m_graph(0), m_display(0), m_opts("") { Account(); }
+  Obj(TGraph *obj) : m_type(Graph), m_hist(0), m_graph(obj), m_display(0), m_opts("") { Account(); }
   Obj(Obj*, Obj*, std::string);
 
-  ~Obj() { delete m_hist; delete m_graph; }
+  ~Obj();
 
   void Rebin(int);
   void NormaliseTo(double);
@@ -39,6 +45,7 @@ class Obj {
   // getters
   TH1* GetHist() { return m_hist; }
   TGraph* GetGraph() { return m_graph; }
+  bool IsGraph() { return m_type == Graph; }
 
   TString GetName();
   double GetMinX();
@@ -54,8 +61,13 @@ class Obj {
   void SetStats(bool stat) { if(m_type == Hist) m_hist->SetStats(stat); }
   void SetColor(Color_t, bool=false);
   void SetStyle();
+  void SetInfo(TString info) { m_info = info; }
+  TString GetInfo() { return m_info; }
 
   void Draw(TString options="");
+
+ private:
+  void Account();
 };
 
 #endif
@@ -0,0 +1,84 @@
+/** @file objcache.cxx
+    @brief ObjectCache implementation
+*/
+
+#include <TH1.h>
+
+#include "objcache.h"
+#include "common.h"
+
+ObjectCache::ObjectCache() :
+  m_bytes(0),
+  m_hits(0),
+  m_misses(0)
+{
+  MemoryAccountant::Instance()->AddCache(this);
+}
+
+ObjectCache::~ObjectCache()
+{
+  Clear();
+  MemoryAccountant::Instance()->RemoveCache(this);
+}
+
+/** Copy of the object (owned by the caller), or 0 if not cached */
+TObject* ObjectCache::Get(TString key)
+{
+  std::map<TString, TObject*>::iterator it = m_objects.find(key);
+  if(it == m_objects.end()) {
+    m_misses++;
+    return 0;
+  }
+
+  m_hits++;
+  MemoryAccountant::Instance()->Touch(this);
+
+  TObject *copy = it->second->Clone();
+  if(copy->InheritsFrom("TH1")) ((TH1*)copy)->SetDirectory(0);
+  return copy;
+}
+
+/** Keep a copy of the object */
+void ObjectCache::Put(TString key, TObject *obj)
+{
+  if(!obj || m_objects.count(key)) return;
+
+  TObject *copy = obj->Clone();
+  if(copy->InheritsFrom("TH1")) ((TH1*)copy)->SetDirectory(0);
+  m_objects[key] = copy;
+
+  m_bytes += MemoryAccountant::ObjectBytes(copy);
+  MemoryAccountant::Instance()->Touch(this);
+  MemoryAccountant::Instance()->Add(this, kMemCaches, m_bytes);
+}
+
+/** Drop the objects whose key begins with prefix (e.g. all the objects of a file) */
+void ObjectCache::RemovePrefix(TString prefix)
+{
+  std::map<TString, TObject*>::iterator it = m_objects.lower_bound(prefix);
+  while(it != m_objects.end() && it->first.BeginsWith(prefix)){
+    m_bytes -= MemoryAccountant::ObjectBytes(it->second);
+    delete it->second;
+    m_objects.erase(it++);
+  }
+
+  if(m_objects.empty()) MemoryAccountant::Instance()->Remove(this);
+  else MemoryAccountant::Instance()->Add(this, kMemCaches, m_bytes);
+}
+
+void ObjectCache::Clear()
+{
+  std::map<TString, TObject*>::iterator it;
+  for(it = m_objects.begin(); it != m_objects.end(); ++it) delete it->second;
+  m_objects.clear();
+
+  m_bytes = 0;
+  MemoryAccountant::Instance()->Remove(this);
+}
+
+Long64_t ObjectCache::Evict()
+{
+  Long64_t freed = m_bytes;
+  Clear();
+  return freed;
+}
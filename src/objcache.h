@@ -0,0 +1,43 @@
+/** @file objcache.h
+    @brief Objects kept in memory between requests of the daemon or pages
+*/
+
+#ifndef OBJCACHE_H
+#define OBJCACHE_H
+
+#include <map>
+
+#include <TROOT.h>
+#include <TString.h>
+
+#include "memory.h"
+
+/** Loaded objects and filled tree draws by key (file and path, or file,
+    tree, expression, selection and binning). The cache owns its objects
+    and gives copies. It is emptied when the memory budget is exceeded */
+class ObjectCache : public MemoryCache {
+
+ public:
+  ObjectCache();
+  ~ObjectCache();
+
+  TObject* Get(TString key);
+  bool Has(TString key) { return m_objects.count(key) > 0; }
+  void Put(TString key, TObject *obj);
+  void RemovePrefix(TString prefix);
+  void Clear();
+
+  unsigned int GetN() { return m_objects.size(); }
+  Long64_t GetHits() { return m_hits; }
+  Long64_t GetMisses() { return m_misses; }
+
+  virtual Long64_t Evict();
+
+ private:
+  std::map<TString, TObject*> m_objects;
+  Long64_t m_bytes;
+  Long64_t m_hits;
+  Long64_t m_misses;
+};
+
+#endif
@@ -0,0 +1,30 @@
+/** @file page.cxx
+    @brief Page class implementation
+*/
+
+#include "plot.h"
+#include "page.h"
+#include "common.h"
+
+Page::Page(TVirtualPad *canvas, UInt_t columns, UInt_t rows) :
+  m_canvas(canvas),
+  m_size(columns*rows)
+{
+  m_canvas->Clear();
+  m_canvas->Divide(columns, rows);
+}
+
+Page::~Page()
+{
+  for(unsigned int k=0; k<m_plots.size(); k++) delete m_plots[k];
+}
+
+/** New plot in the next free pad (owned by the page), or 0 if the page is full */
+Plot* Page::NewPlot()
+{
+  if(IsFull()) return 0;
+
+  Plot *p = new Plot(m_canvas->GetPad(m_plots.size()+1));
+  m_plots.push_back(p);
+  return p;
+}
@@ -0,0 +1,33 @@
+/** @file page.h
+    @brief Header file for the page class
+*/
+
+#ifndef PAGE_H
+#define PAGE_H
+
+#include <vector>
+
+#include <TROOT.h>
+#include <TVirtualPad.h>
+
+class Plot;
+
+/** A canvas (or pad) divided in columns x rows pads, with one plot in
+    each. The page owns the plots but not the canvas.
+*/
+class Page {
+
+ public:
+  Page(TVirtualPad *canvas, UInt_t columns, UInt_t rows);
+  ~Page();
+
+  Plot* NewPlot();
+  bool IsFull() { return m_plots.size() >= m_size; }
+
+ private:
+  TVirtualPad *m_canvas;
+  std::vector<Plot*> m_plots;
+  UInt_t m_size;
+};
+
+#endif
@@ -0,0 +1,342 @@
+/** @file pageview.cxx
+    @brief PageView class implementation
+*/
+
+#include <map>
+#include <set>
+#include <cerrno>
+#include <unistd.h>
+
+#include <TCanvas.h>
+#include <TGLayout.h>
+#include <TGFileDialog.h>
+#include <TSystem.h>
+#include <TFile.h>
+#include <TBufferFile.h>
+
+#include "catalog.h"
+#include "match.h"
+#include "plot.h"
+#include "page.h"
+#include "plotter.h"
+#include "objcache.h"
+#include "filepool.h"
+#include "memory.h"
+#include "pageview.h"
+#include "stats.h"
+#include "common.h"
+
+ClassImp(PageView)
+
+/** Header of an object sent by a worker, followed by the object streamed */
+struct PrefetchRecord {
+  UInt_t k;   // position in the objects to read
+  Int_t size; // 0 if it cannot be read
+};
+
+static bool write_all(int fd, const char *p, size_t left)
+{
+  while(left > 0){
+    ssize_t n = write(fd, p, left);
+    if(n < 0 && errno == EINTR) continue;
+    if(n <= 0) return false;
+    p += n;
+    left -= n;
+  }
+  return true;
+}
+
+PageView::PageView(const TGWindow *p, Plotter *plotter, TString title,
+                   std::vector<std::vector<Item*> > plots, UInt_t columns, UInt_t rows) :
+  TGMainFrame(p, 400*columns, 300*rows+30),
+  m_plotter(plotter),
+  m_plots(plots),
+  m_columns(columns),
+  m_rows(rows),
+  m_current(-1),
+  m_page(0),
+  m_prefetched(new ObjectCache()),
+  m_prefetch_timer(0)
+{
+  SetCleanup(kDeepCleanup);
+
+  m_n_pages = (m_plots.size() + columns*rows - 1) / (columns*rows);
+
+  TGHorizontalFrame *frame_buttons = new TGHorizontalFrame(this);
+  button_prev = new TGTextButton(frame_buttons, " < ", 0);
+  button_next = new TGTextButton(frame_buttons, " > ", 0);
+  button_save = new TGTextButton(frame_buttons, "Save all pages...", 0);
+  label_page = new TGLabel(frame_buttons, "Page 1/1");
+
+  button_prev->SetToolTipText("Previous page.");
+  button_next->SetToolTipText("Next page.");
+  button_save->SetToolTipText("Save all the pages in one pdf file.");
+
+  button_prev->Connect("Clicked()", "PageView", this, "OnButtonPrev()");
+  button_next->Connect("Clicked()", "PageView", this, "OnButtonNext()");
+  button_save->Connect("Clicked()", "PageView", this, "OnButtonSave()");
+
+  frame_buttons->AddFrame(button_prev, new TGLayoutHints(kLHintsLeft, 2, 2, 2, 2));
+  frame_buttons->AddFrame(label_page, new TGLayoutHints(kLHintsLeft | kLHintsCenterY, 5, 5, 2, 2));
+  frame_buttons->AddFrame(button_next, new TGLayoutHints(kLHintsLeft, 2, 2, 2, 2));
+  frame_buttons->AddFrame(button_save, new TGLayoutHints(kLHintsRight, 2, 2, 2, 2));
+  AddFrame(frame_buttons, new TGLayoutHints(kLHintsExpandX, 2, 2, 2, 2));
+
+  ecanvas = new TRootEmbeddedCanvas(Form("%s_pages", title.Data()), this, 400*columns, 300*rows);
+  AddFrame(ecanvas, new TGLayoutHints(kLHintsExpandX | kLHintsExpandY, 2, 2, 2, 2));
+
+  SetWindowName(Form("%s (%u plots)", title.Data(), (UInt_t)m_plots.size()));
+  MapSubwindows();
+  Resize(GetDefaultSize());
+  MapWindow();
+
+  m_prefetch_timer = new TTimer(20, kFALSE);
+  m_prefetch_timer->Connect("Timeout()", "PageView", this, "PollPrefetch()");
+
+  ShowPage(0);
+}
+
+PageView::~PageView()
+{
+  StopPrefetch();
+  delete m_prefetch_timer;
+  delete m_prefetched;
+  delete m_page;
+  ecanvas->GetCanvas()->Clear();
+  Cleanup();
+}
+
+void PageView::CloseWindow()
+{
+  StopPrefetch();
+  DeleteWindow();
+}
+
+/** Show a page, and start reading the objects of the next and previous
+    pages */
+void PageView::ShowPage(Int_t page)
+{
+  if(page < 0 || page >= (Int_t)m_n_pages) return;
+
+  // keep what the workers have read so far
+  PollPrefetch();
+  StopPrefetch();
+
+  label_page->SetText(Form("Page %i/%u", page+1, m_n_pages));
+  button_prev->SetEnabled(page > 0);
+  button_next->SetEnabled(page+1 < (Int_t)m_n_pages);
+  Layout();
+
+  DrawPage(page);
+
+  std::vector<Int_t> pages;
+  pages.push_back(page+1);
+  pages.push_back(page-1);
+  StartPrefetch(pages);
+}
+
+/** Draw the plots of a page, releasing the ones of the page drawn
+    before. The objects read by the workers are taken from the cache */
+void PageView::DrawPage(Int_t page)
+{
+  TCanvas *c = ecanvas->GetCanvas();
+
+  delete m_page;
+  m_page = new Page(c, m_columns, m_rows);
+  m_current = page;
+
+  UInt_t first = page*m_columns*m_rows;
+  for(UInt_t k=first; k<m_plots.size() && !m_page->IsFull(); k++){
+    Plot *p = m_page->NewPlot();
+    m_plotter->FillPlot(p, m_plots[k], m_prefetched);
+    p->Create();
+  }
+
+  ScopedTimer timer(kStagePaint);
+  c->cd();
+  c->Modified();
+  c->Update();
+}
+
+/** Start the workers that read the objects of some pages into the cache
+    (emptied first). Only the objects that fit in the memory budget are
+    read; the others are read when they are drawn */
+void PageView::StartPrefetch(std::vector<Int_t> pages)
+{
+  StopPrefetch();
+  m_prefetched->Clear();
+
+  UInt_t per_page = m_columns*m_rows;
+  std::map<TString, std::vector<Item*> > by_file;
+  std::set<TString> keys;
+  Long64_t total = 0;
+  for(UInt_t n=0; n<pages.size(); n++){
+    if(pages[n] < 0 || pages[n] >= (Int_t)m_n_pages) continue;
+    for(UInt_t k=pages[n]*per_page; k<m_plots.size() && k<(pages[n]+1)*per_page; k++){
+      for(UInt_t i=0; i<m_plots[k].size(); i++){
+        Item *item = m_plots[k][i];
+        Long64_t size = m_plotter->GetPrefetchSize(item, m_prefetched);
+        if(size < 0) continue;
+
+        TString key = m_plotter->GetObjectKey(item);
+        if(keys.count(key)) continue;
+        if(!MemoryAccountant::Instance()->Fits(2*(total+size))) continue;
+
+        keys.insert(key);
+        total += size;
+        by_file[m_plotter->GetCatalog(item)->GetFileName()].push_back(item);
+      }
+    }
+  }
+
+  // each worker reads a block of them, with as few files as possible
+  std::map<TString, std::vector<Item*> >::iterator it;
+  for(it = by_file.begin(); it != by_file.end(); ++it){
+    for(UInt_t i=0; i<it->second.size(); i++){
+      m_prefetch_items.push_back(it->second[i]);
+      m_prefetch_files.push_back(it->first);
+      m_prefetch_keys.push_back(m_plotter->GetObjectKey(it->second[i]));
+    }
+  }
+  if(m_prefetch_items.empty()) return;
+
+  unsigned int n_workers = std::min(number_of_cores(), (unsigned int)m_prefetch_items.size());
+
+  // workers can't share the open files
+  FilePool::Instance()->CloseAll();
+
+  m_workers = start_pipe_workers(n_workers, RunWorker, this);
+  m_buffers.assign(m_workers.size(), std::string());
+  if(!m_workers.empty()) m_prefetch_timer->Start(20, kFALSE);
+}
+
+/** Each worker reads a block of the objects and sends them streamed
+    through its pipe. Fails if the parent has gone */
+bool PageView::RunWorker(unsigned int worker, unsigned int n_workers, int fd, void *data)
+{
+  PageView *v = (PageView*)data;
+
+  TDirectory::TContext ctx(gDirectory);
+
+  unsigned int n = v->m_prefetch_items.size();
+  TFile *file = 0;
+  TString filename = "";
+  bool sent = true;
+  for(unsigned int k=worker*n/n_workers; k<(worker+1)*n/n_workers && sent; k++){
+    if(v->m_prefetch_files[k] != filename) {
+      if(file) file->Close();
+      delete file;
+      filename = v->m_prefetch_files[k];
+      file = TFile::Open(filename);
+      if(file && file->IsZombie()) {
+        delete file;
+        file = 0;
+      }
+    }
+
+    TObject *obj = file ? Matcher::ReadItem(file, v->m_prefetch_items[k]) : 0;
+
+    TBufferFile buffer(TBuffer::kWrite);
+    if(obj) buffer.WriteObject(obj);
+    delete obj;
+
+    PrefetchRecord record;
+    record.k = k;
+    record.size = obj ? buffer.Length() : 0;
+    sent = write_all(fd, (const char*)&record, sizeof(record)) && write_all(fd, buffer.Buffer(), record.size);
+  }
+
+  if(file) file->Close();
+  delete file;
+  return sent;
+}
+
+/** Put the objects sent by the workers so far in the cache */
+void PageView::PollPrefetch()
+{
+  for(unsigned int w=0; w<m_workers.size(); w++){
+    bool running = read_pipe_worker(m_workers[w], m_buffers[w]);
+
+    std::string &buffer = m_buffers[w];
+    size_t used = 0;
+    PrefetchRecord record;
+    while(buffer.size() - used >= sizeof(record)){
+      buffer.copy((char*)&record, sizeof(record), used);
+      if(buffer.size() - used - sizeof(record) < (size_t)record.size) break;
+      used += sizeof(record);
+
+      if(record.size > 0 && record.k < m_prefetch_keys.size()) {
+        TBufferFile in(TBuffer::kRead, record.size, &buffer[used], kFALSE);
+        TObject *obj = in.ReadObject(TObject::Class());
+        if(obj) {
+          m_prefetched->Put(m_prefetch_keys[record.k], obj);
+          delete obj;
+        }
+      }
+      used += record.size;
+    }
+    buffer.erase(0, used);
+
+    if(!running) {
+      m_workers.erase(m_workers.begin()+w);
+      m_buffers.erase(m_buffers.begin()+w);
+      w--;
+    }
+  }
+
+  if(m_workers.empty()) m_prefetch_timer->Stop();
+}
+
+/** Wait until the workers have sent all their objects */
+void PageView::WaitPrefetch()
+{
+  while(!m_workers.empty()){
+    PollPrefetch();
+    if(!m_workers.empty()) gSystem->Sleep(5);
+  }
+}
+
+/** Kill the workers still running */
+void PageView::StopPrefetch()
+{
+  m_prefetch_timer->Stop();
+  for(unsigned int w=0; w<m_workers.size(); w++) stop_pipe_worker(m_workers[w]);
+  m_workers.clear();
+  m_buffers.clear();
+  m_prefetch_items.clear();
+  m_prefetch_files.clear();
+  m_prefetch_keys.clear();
+}
+
+/** Draw all the pages, one after the other, in a multi-page pdf. The
+    workers read each page while the previous one is printed */
+void PageView::SavePages()
+{
+  static TString dir(".");
+  TGFileInfo fi;
+  fi.fIniDir = StrDup(dir);
+  new TGFileDialog(fClient->GetRoot(), this, kFDSave, &fi);
+  if(!fi.fFilename) return;
+  dir = fi.fIniDir;
+
+  TString filename = fi.fFilename;
+  if(!filename.EndsWith(".pdf")) filename += ".pdf";
+
+  Int_t current = m_current;
+  TCanvas *c = ecanvas->GetCanvas();
+
+  StartPrefetch(std::vector<Int_t>(1, 0));
+
+  c->Print(filename + "[");
+  for(UInt_t page=0; page<m_n_pages; page++){
+    WaitPrefetch();
+    DrawPage(page);
+    StartPrefetch(std::vector<Int_t>(1, page+1));
+    c->Print(filename);
+  }
+  c->Print(filename + "]");
+
+  ShowPage(current);
+
+  msg("Saved " << m_n_pages << " pages in " << filename);
+}
@@ -0,0 +1,85 @@
+/** @file pageview.h
+    @brief Window to flip through many plots in pages of pads
+*/
+
+#ifndef PAGEVIEW_H
+#define PAGEVIEW_H
+
+#include <vector>
+#include <string>
+
+#include <TROOT.h>
+#include <TTimer.h>
+#include <TGFrame.h>
+#include <TGLabel.h>
+#include <TGButton.h>
+#include <TRootEmbeddedCanvas.h>
+
+#include "workers.h"
+
+class Item;
+class Page;
+class Plotter;
+class ObjectCache;
+
+/** One window for any number of plots, shown in pages of columns x rows
+    pads. Each plot is a list of items drawn together. Only the page
+    shown is drawn (its objects are read when it's shown and released
+    when another page is shown), so flipping through hundreds of plots
+    costs one canvas. While a page is shown the objects of the next and
+    previous pages are read by background workers, which send them
+    through pipes, so flipping does not wait for the files. When the
+    pages are saved, the workers read each page while the previous one
+    is printed.
+
+    The window is deleted when it's closed.
+*/
+class PageView : public TGMainFrame {
+
+ public:
+  PageView(const TGWindow *p, Plotter *plotter, TString title,
+           std::vector<std::vector<Item*> > plots, UInt_t columns=3, UInt_t rows=2);
+  virtual ~PageView();
+
+  virtual void CloseWindow();
+
+  // Slots
+  void OnButtonPrev() { ShowPage(m_current-1); }
+  void OnButtonNext() { ShowPage(m_current+1); }
+  void OnButtonSave() { SavePages(); }
+  void PollPrefetch();
+
+ private:
+  void ShowPage(Int_t page);
+  void DrawPage(Int_t page);
+  void SavePages();
+  void StartPrefetch(std::vector<Int_t> pages);
+  void WaitPrefetch();
+  void StopPrefetch();
+  static bool RunWorker(unsigned int, unsigned int, int, void*);
+
+  Plotter *m_plotter;
+  std::vector<std::vector<Item*> > m_plots;
+  UInt_t m_columns;
+  UInt_t m_rows;
+  UInt_t m_n_pages;
+  Int_t m_current;
+  Page *m_page;
+  ObjectCache *m_prefetched;
+  std::vector<Item*> m_prefetch_items; // read by the workers
+  std::vector<TString> m_prefetch_files;
+  std::vector<TString> m_prefetch_keys;
+  std::vector<PipeWorker> m_workers;
+  std::vector<std::string> m_buffers;
+  TTimer *m_prefetch_timer; // polls the workers
+
+  TGTextButton *button_prev;
+  TGTextButton *button_next;
+  TGTextButton *button_save;
+  TGLabel *label_page;
+  TRootEmbeddedCanvas *ecanvas;
+
+  ClassDef(PageView, 0);
+};
+
+#endif
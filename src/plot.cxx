@@ -3,24 +3,52 @@
 */
 
 #include <iostream>
+#include <algorithm>
 #include <TGraph.h>
 #include <TH1.h>
 
 #include "common.h"
 #include "obj.h"
 #include "plot.h"
+#include "stats.h"
+#include "trace.h"
+#include "memory.h"
+#include "export.h"
 
 Plot::Plot()
 {
   m_name = Form("plot_%i", number_of_plot);
   m_canvas = new TCanvas(m_name, m_name, 800, 600);
+  m_pad = m_canvas;
+  Init();
+
+  // the pixmap of the canvas (32 bits per pixel)
+  MemoryAccountant::Instance()->Add(this, kMemCanvases, 800*600*4);
+}
+
+/** Plot drawn in a pad of another canvas (a page), not owned */
+Plot::Plot(TVirtualPad *pad)
+{
+  m_name = Form("plot_%i", number_of_plot);
+  m_canvas = 0;
+  m_pad = pad;
+  Init();
+}
+
+void Plot::Init()
+{
+  m_info = 0;
 
   rebin = 0;
   draw_options = "";
 
   show_stats = false;
+  show_info = false;
   include_ratio = false;
   include_diff = false;
+  do_efficiency = false;
+  m_interval = kClopperPearson;
+  do_bands = false;
   do_logx = false;
   do_logy = false;
   do_normalise = false;
@@ -31,8 +59,24 @@ Plot::Plot()
 
 Plot::~Plot()
 {
-  if(m_canvas) delete m_canvas;
-  if(m_legend) delete m_legend;
+  MemoryAccountant::Instance()->Remove(this);
+  if(m_canvas) {
+    // deleting the canvas emits Closed(), but the plot is already going away
+    m_canvas->Disconnect("Closed()");
+    delete m_canvas;
+  }
+  if(m_info) delete m_info;
+
+  for(unsigned int k=0; k<m_list.size(); k++) delete m_list[k];
+  for(unsigned int k=0; k<m_derived.size(); k++) delete m_derived[k];
+}
+
+/** The canvas was deleted by ROOT (its window was closed) */
+void Plot::DetachCanvas()
+{
+  m_canvas = 0;
+  m_pad = 0;
+  MemoryAccountant::Instance()->Remove(this);
 }
 
 void Plot::Add(Obj *obj, Color_t colour, bool fill)
@@ -46,11 +90,20 @@ void Plot::Save()
   if(!m_canvas || !m_canvas->IsOnHeap())
     return;
 
-  m_canvas->Print(m_name+".eps");
+  SaveAs(m_name+".eps");
+}
+
+/** Save the canvas. The format is given by the file extension */
+void Plot::SaveAs(TString filename)
+{
+  if(!m_canvas) return;
+
+  m_canvas->Print(filename);
 }
 
 void Plot::Configure()
 {
+  ScopedTimer timer(kStageConfigure);
 
   //-- Rebin
   if(rebin > 1){
@@ -74,7 +127,7 @@ void Plot::Configure()
 
   y_max *= 1.1;
 
-  if(m_canvas->GetLogy()){
+  if(m_pad->GetLogy()){
     if(y_min > 0) y_min *= .9;
     else          y_min = y_max * 1.e-3;
   }
@@ -119,6 +172,11 @@ void Plot::Create()
 {
   if(m_list.size() == 0) return;
 
+  Stats::Instance()->Count(kCountPlots);
+  ScopedTrace trace("Plot::Create", "plot", m_name);
+
+  m_pad->cd();
+
   // for(int k=0; k<m_list.size(); k++){
   //   if(m_list[k]->GetEntries() == 0) {
   //     error(m_list[k]->GetName() << " is empty.");
@@ -126,8 +184,27 @@ void Plot::Create()
   //   }
   // }
 
+  if(do_efficiency){
+    if(rebin > 1){
+      for(unsigned int k=0; k<m_list.size(); k++) m_list[k]->Rebin(rebin);
+    }
+    if(do_logx) m_pad->SetLogx();
+    if(do_logy) m_pad->SetLogy();
+    DrawEfficiency();
+    DrawInfo();
+    return;
+  }
+
   Configure();
 
+  if(do_bands){
+    if(do_logx) m_pad->SetLogx();
+    if(do_logy) m_pad->SetLogy();
+    DrawBands();
+    DrawInfo();
+    return;
+  }
+
   if(include_ratio){
     TPad *up   = new TPad("upperPad", "upperPad", .001, .29, .999, .999);
     TPad *down = new TPad("lowerPad", "lowerPad", .001, .001,  .999, .28);
@@ -181,34 +258,30 @@ void Plot::Create()
     DrawDiffs();
   }
   else {
-    if(do_logx) m_canvas->SetLogx();
-    if(do_logy) m_canvas->SetLogy();
+    if(do_logx) m_pad->SetLogx();
+    if(do_logy) m_pad->SetLogy();
     Draw();
   }
 
+  DrawInfo();
+
   return;
 }
 
 void Plot::Draw()
 {
-  m_list[0]->Draw(draw_options);
-  for(unsigned int i=1; i<m_list.size(); i++){
-    m_list[i]->Draw(draw_options+"same");
+  for(unsigned int i=0; i<m_list.size(); i++){
+    // the histogram options don't apply to graphs
+    if(m_list[i]->IsGraph()) m_list[i]->Draw(i==0 ? "A" : "");
+    else m_list[i]->Draw(i==0 ? draw_options : draw_options+"same");
   }
 }
 
 void Plot::DrawRatios()
 {
-  int n_ratios = m_list.size() - 1;
+  std::vector<Obj*> ratio = CreateRatios(kRatio);
 
-  if(n_ratios == 0) return;
-
-  Obj *ratio[n_ratios];
-  for(int k=0; k< n_ratios; k++){
-    ratio[k] = new Obj(m_list[k+1], m_list[0], "ratio");
-  }
-
-  if(!ratio[0]) {
+  if(ratio.empty()) {
     error("There are no ratios to plot.");
     return;
   }
@@ -224,9 +297,7 @@ void Plot::DrawRatios()
   // ratio[0]->GetYaxis()->SetTitleOffset( 0.4 );
   // ratio[0]->GetXaxis()->SetTitleOffset( 1.1 );
 
-  for(int n=0; n<n_ratios; n++){
-    //    ratio[n]->SetColor(m_colours[n+1]);
-
+  for(unsigned int n=0; n<ratio.size(); n++){
     if(n==0) ratio[n]->Draw();
     else ratio[n]->Draw("same");
   }
@@ -236,16 +307,9 @@ void Plot::DrawRatios()
    diff = (hN - h1)/h1 */
 void Plot::DrawDiffs()
 {
-  int n_diffs = m_list.size() - 1;
+  std::vector<Obj*> diff = CreateRatios(kDifference);
 
-  if(n_diffs==0) return;
-
-  Obj *diff[n_diffs];
-  for(int k=0; k<n_diffs; k++){
-    diff[k] = new Obj(m_list[k+1], m_list[0], "difference");
-  }
-
-  if(!diff[0]) {
+  if(diff.empty()) {
     error("There are no differences to plot.");
     return;
   }
@@ -261,14 +325,36 @@ void Plot::DrawDiffs()
   //   diff[0]->GetYaxis()->SetTitleOffset( 0.4 );
   //   diff[0]->GetXaxis()->SetTitleOffset( 1.1 );
 
-  for(int n=0; n<n_diffs; n++){
-    //diff[n]->SetColor(m_colours[n+1]);
-
+  for(unsigned int n=0; n<diff.size(); n++){
     if(n==0) diff[n]->Draw();
     else diff[n]->Draw("same");
   }
 }
 
+/** Ratios or differences of all the histograms with respect to the
+    first one, computed all together. They are owned by the plot */
+std::vector<Obj*> Plot::CreateRatios(RatioMode mode)
+{
+  std::vector<Obj*> objs;
+  if(m_list.size() < 2 || !m_list[0]->GetHist()) return objs;
+
+  std::vector<TH1*> hists;
+  for(unsigned int k=1; k<m_list.size(); k++){
+    hists.push_back(m_list[k]->GetHist());
+  }
+
+  std::vector<TH1*> ratios = compute_ratios(m_list[0]->GetHist(), hists, mode);
+
+  for(unsigned int k=0; k<ratios.size(); k++){
+    if(!ratios[k]) continue;
+    Obj *obj = new Obj(ratios[k]);
+    m_derived.push_back(obj);
+    objs.push_back(obj);
+  }
+
+  return objs;
+}
+
 void Plot::DrawLegend()
 {
   std::vector<TString> legend;
@@ -339,17 +425,64 @@ void Plot::DrawLegend()
   // leg->Draw();
 }
 
+/** The info of the objects (e.g. the I/O of the tree draws), in a box
+    in the top left corner of the whole plot */
+void Plot::DrawInfo()
+{
+  if(!show_info) return;
+
+  std::vector<TString> lines;
+  for(unsigned int k=0; k<m_list.size(); k++){
+    TString info = m_list[k]->GetInfo();
+    if(info.IsNull()) continue;
+    lines.push_back(m_list[k]->GetName() + ": " + info);
+  }
+  if(lines.empty()) return;
+
+  m_pad->cd();
+
+  Double_t y_low = std::max(0.5, 0.94 - 0.04*lines.size());
+  m_info = new TPaveText(0.1, y_low, 0.9, 0.94, "NDC");
+  m_info->SetName(Exporter::screen_only);
+  m_info->SetBorderSize(1);
+  m_info->SetFillColor(kWhite);
+  m_info->SetTextAlign(12);
+  m_info->SetTextSize(0.025);
+  for(unsigned int k=0; k<lines.size(); k++) m_info->AddText(lines[k]);
+  m_info->Draw();
+}
+
+/** Efficiency of each object with respect to the first one (the total),
+    all computed together */
 void Plot::DrawEfficiency()
 {
-  Obj *eff = new Obj(m_list[0], m_list[1], "efficiency");
+  if(m_list.size() < 2 || !m_list[0]->GetHist()) {
+    error("The efficiency needs a total histogram and at least one pass histogram.");
+    return;
+  }
 
-  eff->SetTitleX("");
-  eff->SetTitleY("Efficiency");
+  std::vector<TH1*> nums, dens;
+  for(unsigned int k=1; k<m_list.size(); k++){
+    nums.push_back(m_list[k]->GetHist());
+    dens.push_back(m_list[0]->GetHist());
+  }
+
+  Efficiency engine(m_interval);
+  std::vector<TGraphAsymmErrors*> graphs = engine.Compute(nums, dens);
 
-  eff->SetColor(1, false);
-  eff->SetStyle();
+  bool first = true;
+  for(unsigned int k=0; k<graphs.size(); k++){
+    if(!graphs[k]) continue;
 
-  // gr->Draw("PAZT");
+    Obj *eff = new Obj(graphs[k]);
+    m_derived.push_back(eff);
+
+    if(do_logy) Efficiency::SetLogMinimum(graphs[k]);
+    eff->SetColor(nums[k]->GetLineColor(), false);
+    eff->SetStyle();
+    eff->Draw(first ? "A" : "");
+    first = false;
+  }
 }
 
 void Plot::Dump()
@@ -365,3 +498,57 @@ void Plot::Dump()
 }
 
 int Plot::number_of_plot = 0;
+
+/** Percentile bands of all the histograms, instead of one line for
+    each: min/max, 2.5-97.5% and 16-84% as filled areas, the median and
+    the histograms that are most often out of the bands */
+void Plot::DrawBands()
+{
+  std::vector<TH1*> hists;
+  for(unsigned int k=0; k<m_list.size(); k++){
+    if(m_list[k]->GetHist()) hists.push_back(m_list[k]->GetHist());
+  }
+
+  PercentileBands bands = compute_bands(hists);
+  if(!bands.outer) {
+    error("There are no histograms for the bands.");
+    return;
+  }
+
+  bands.outer->SetFillColor(kGray);
+  bands.wide->SetFillColor(kAzure-9);
+  bands.inner->SetFillColor(kAzure-4);
+  bands.median->SetLineColor(kBlack);
+  bands.median->SetLineWidth(2);
+  bands.median->SetStats(0);
+
+  Double_t y_low = bands.outer->GetY()[0] - bands.outer->GetErrorYlow(0);
+  Double_t y_up  = bands.outer->GetY()[0] + bands.outer->GetErrorYhigh(0);
+  for(Int_t i=1; i<bands.outer->GetN(); i++){
+    y_low = std::min(y_low, bands.outer->GetY()[i] - bands.outer->GetErrorYlow(i));
+    y_up  = std::max(y_up,  bands.outer->GetY()[i] + bands.outer->GetErrorYhigh(i));
+  }
+  bands.outer->SetMinimum(do_logy && y_low <= 0 ? y_up*1.e-3 : y_low - 0.05*(y_up-y_low));
+  bands.outer->SetMaximum(y_up + 0.1*(y_up-y_low));
+
+  Obj *outer = new Obj(bands.outer);
+  Obj *wide = new Obj(bands.wide);
+  Obj *inner = new Obj(bands.inner);
+  Obj *median = new Obj(bands.median);
+  m_derived.push_back(outer);
+  m_derived.push_back(wide);
+  m_derived.push_back(inner);
+  m_derived.push_back(median);
+
+  outer->Draw("A2");
+  wide->Draw("2");
+  inner->Draw("2");
+  median->Draw("hist same");
+
+  for(unsigned int k=0; k<bands.outliers.size(); k++){
+    hists[bands.outliers[k]]->SetLineWidth(1);
+    hists[bands.outliers[k]]->Draw("hist same");
+  }
+
+  msg(hists.size() << " histograms in the bands, " << bands.outliers.size() << " outliers drawn");
+}
@@ -8,46 +8,79 @@
 #include <TROOT.h>
 #include <TLegend.h>
 #include <TCanvas.h>
+#include <TPaveText.h>
+
+#include "ratio.h"
+#include "efficiency.h"
+#include "band.h"
 
 
 class Obj;
 
-/** Base class for a root plot
+/** Base class for a root plot.
+
+    The plot owns its canvas and all the objects drawn in it (the added
+    ones and the ratios/differences made from them), and deletes them
+    when it is deleted. If the canvas window is closed by the user, the
+    canvas is deleted by ROOT and the plot must be detached from it
+    (DetachCanvas) before deleting the plot. A plot can also be drawn in
+    a pad of a Page, which owns the canvas.
  */
 class Plot {
 
  public:
   Plot();
+  Plot(TVirtualPad *pad);
   ~Plot();
 
   void Add(Obj*, Color_t colour=kBlack, bool=false);
   void Create();
   void Save();
+  void SaveAs(TString);
   void Dump();
 
   void SetLogX(bool set) { do_logx = set; }
   void SetLogY(bool set) { do_logy = set; }
   void SetIncludeRatio(bool set) { include_ratio = set; }
   void SetIncludeDiff(bool set) { include_diff = set; }
+  void SetEfficiency(bool set, EffInterval interval=kClopperPearson) { do_efficiency = set; m_interval = interval; }
+  void SetBands(bool set) { do_bands = set; }
   void SetDrawOptions(TString opts) { draw_options = opts; }
+  void SetRebin(int group) { rebin = group; }
+  void SetNormalise(bool set) { do_normalise = set; }
+  void SetNormaliseToFirst(bool set) { do_normalise_to_first = set; }
+  void SetShowStats(bool set) { show_stats = set; }
+  void SetShowInfo(bool set) { show_info = set; }
+  TString GetName() { return m_name; }
+  TCanvas* GetCanvas() { return m_canvas; }
+  void DetachCanvas();
   static int number_of_plot;
 
  private:
+  void Init();
   void Configure();
   void Draw();
   void DrawEfficiency();
+  void DrawBands();
   void DrawRatios();
   void DrawDiffs();
+  std::vector<Obj*> CreateRatios(RatioMode);
   void DrawLegend();
+  void DrawInfo();
 
   TString m_name;
-  TCanvas *m_canvas;
-  TLegend *m_legend;
+  TCanvas *m_canvas;  // own canvas (0 for the plots of a page)
+  TVirtualPad *m_pad; // where it's drawn
+  TPaveText *m_info;
   std::vector<Obj*> m_list;
+  std::vector<Obj*> m_derived; // ratios, differences, efficiencies, bands
 
   double x_min, x_max, y_min, y_max;
   bool include_ratio;
   bool include_diff;
+  bool do_efficiency;
+  EffInterval m_interval;
+  bool do_bands;
   TString draw_options;
   int rebin;
   bool do_logx;
@@ -55,6 +88,7 @@ class Plot {
   bool do_normalise;
   bool do_normalise_to_first;
   bool show_stats;
+  bool show_info;
 };
 
 #endif
@@ -0,0 +1,244 @@
+/** @file plotspec.cxx
+    @brief Plot specification files
+
+    Format (one plot per block, # starts a comment):
+
+      plot met_comparison
+        item file=data.root path=hists/met
+        item file=mc.root path=hists/met colour=2 fill=1
+        item file=mc.root tree=events expr=met cut="njets>2" bins=50,0,500
+        options hist
+        rebin 2
+        normalise [first]
+        logx
+        logy
+        stats
+        ratio | diff
+        bands
+        efficiency [clopper-pearson|jeffreys|wilson]
+      end
+
+    In an efficiency plot the first item is the total and the others
+    are the pass histograms.
+*/
+
+#include <fstream>
+
+#include <TColor.h>
+
+#include "common.h"
+#include "efficiency.h"
+#include "plotspec.h"
+
+PlotSpec::PlotSpec(TString n) :
+  name(n),
+  draw_options(""),
+  rebin(0),
+  logx(false),
+  logy(false),
+  normalise(false),
+  normalise_to_first(false),
+  stats(false),
+  ratio(false),
+  diff(false),
+  bands(false),
+  efficiency(-1)
+{
+}
+
+PlotSpec::~PlotSpec()
+{
+  for(unsigned int k=0; k<items.size(); k++) delete items[k];
+}
+
+/** Split a line in words. Double quotes group words and # starts a comment */
+static std::vector<TString> split_line(TString line)
+{
+  std::vector<TString> words;
+  TString word = "";
+  bool in_quotes = false;
+  bool in_word = false;
+
+  for(Int_t k=0; k<line.Length(); k++){
+    char c = line[k];
+    if(c == '"') {
+      in_quotes = !in_quotes;
+      in_word = true;
+    }
+    else if(!in_quotes && c == '#') {
+      break;
+    }
+    else if(!in_quotes && (c == ' ' || c == '\t')) {
+      if(in_word) words.push_back(word);
+      word = "";
+      in_word = false;
+    }
+    else {
+      word += c;
+      in_word = true;
+    }
+  }
+  if(in_word) words.push_back(word);
+
+  return words;
+}
+
+static SpecItem* parse_item(std::vector<TString> &words, TString where)
+{
+  SpecItem *item = new SpecItem();
+  item->colour = -1;
+  item->fill = false;
+  item->obj = 0;
+
+  for(unsigned int k=1; k<words.size(); k++){
+    Int_t eq = words[k].Index("=");
+    if(eq <= 0) {
+      error(where << ": expected key=value, found " << words[k]);
+      continue;
+    }
+    TString key = words[k](0, eq);
+    TString value = words[k](eq+1, words[k].Length());
+
+    if(key == "file")        item->file = value;
+    else if(key == "path")   item->path = value;
+    else if(key == "tree")   item->tree = value;
+    else if(key == "expr")   item->expr = value;
+    else if(key == "cut")    item->cut = value;
+    else if(key == "bins")   item->binning = value;
+    else if(key == "fill")   item->fill = (value == "1" || value == "true");
+    else if(key == "colour" || key == "color")
+      item->colour = value.IsDigit() ? value.Atoi() : TColor::GetColor(value.Data());
+    else
+      error(where << ": unknown key " << key);
+  }
+
+  if(item->file.IsNull() || (item->path.IsNull() && (item->tree.IsNull() || item->expr.IsNull()))) {
+    error(where << ": an item needs file and path, or file, tree and expr");
+    delete item;
+    return 0;
+  }
+
+  return item;
+}
+
+/** Read all the plots of a specification file */
+std::vector<PlotSpec*> read_plot_specs(TString filename)
+{
+  std::vector<PlotSpec*> specs;
+
+  std::ifstream in(filename.Data());
+  if(!in) {
+    error("Cannot open " << filename);
+    return specs;
+  }
+
+  PlotSpec *spec = 0;
+  std::string line;
+  int n_line = 0;
+
+  while(std::getline(in, line)) {
+    n_line++;
+    std::vector<TString> words = split_line(line.c_str());
+    if(words.empty()) continue;
+
+    TString where = Form("%s:%i", filename.Data(), n_line);
+    TString key = words[0];
+
+    if(key == "plot") {
+      if(spec) {
+        error(where << ": plot " << spec->name << " has no end");
+        delete spec;
+      }
+      spec = new PlotSpec(words.size() > 1 ? words[1] : Form("plot_%i", (int)specs.size()));
+      continue;
+    }
+
+    if(!spec) {
+      error(where << ": " << key << " outside a plot");
+      continue;
+    }
+
+    if(key == "end") {
+      if(spec->items.empty()) {
+        error(where << ": plot " << spec->name << " has no items");
+        delete spec;
+      }
+      else specs.push_back(spec);
+      spec = 0;
+    }
+    else if(key == "item") {
+      SpecItem *item = parse_item(words, where);
+      if(item) spec->items.push_back(item);
+    }
+    else if(key == "options")   spec->draw_options = words.size() > 1 ? words[1] : "";
+    else if(key == "rebin")     spec->rebin = words.size() > 1 ? words[1].Atoi() : 0;
+    else if(key == "normalise") {
+      if(words.size() > 1 && words[1] == "first") spec->normalise_to_first = true;
+      else spec->normalise = true;
+    }
+    else if(key == "logx")  spec->logx = true;
+    else if(key == "logy")  spec->logy = true;
+    else if(key == "stats") spec->stats = true;
+    else if(key == "ratio") spec->ratio = true;
+    else if(key == "diff")  spec->diff = true;
+    else if(key == "bands") spec->bands = true;
+    else if(key == "efficiency")
+      spec->efficiency = Efficiency::GetIntervalFromName(words.size() > 1 ? words[1] : "");
+    else error(where << ": unknown keyword " << key);
+  }
+
+  if(spec) {
+    error(filename << ": plot " << spec->name << " has no end");
+    delete spec;
+  }
+
+  return specs;
+}
+
+static TString quote(TString value)
+{
+  if(value.Contains(" ") || value.Contains("#")) return "\"" + value + "\"";
+  return value;
+}
+
+/** Write the plots in the specification format */
+void write_plot_specs(TString filename, std::vector<PlotSpec*> specs)
+{
+  std::ofstream out(filename.Data());
+
+  out << "# plot specifications created with plotter" << std::endl;
+
+  for(unsigned int i=0; i<specs.size(); i++){
+    PlotSpec *spec = specs[i];
+
+    out << std::endl << "plot " << spec->name << std::endl;
+
+    for(unsigned int k=0; k<spec->items.size(); k++){
+      SpecItem *item = spec->items[k];
+      out << "  item file=" << quote(item->file);
+      if(item->IsTreeDraw()) {
+        out << " tree=" << quote(item->tree) << " expr=" << quote(item->expr);
+        if(!item->cut.IsNull())     out << " cut=" << quote(item->cut);
+        if(!item->binning.IsNull()) out << " bins=" << item->binning;
+      }
+      else out << " path=" << quote(item->path);
+      if(item->colour >= 0) out << " colour=" << item->colour;
+      if(item->fill) out << " fill=1";
+      out << std::endl;
+    }
+
+    if(!spec->draw_options.IsNull()) out << "  options " << spec->draw_options << std::endl;
+    if(spec->rebin > 1)         out << "  rebin " << spec->rebin << std::endl;
+    if(spec->normalise)         out << "  normalise" << std::endl;
+    if(spec->normalise_to_first) out << "  normalise first" << std::endl;
+    if(spec->logx)  out << "  logx" << std::endl;
+    if(spec->logy)  out << "  logy" << std::endl;
+    if(spec->stats) out << "  stats" << std::endl;
+    if(spec->ratio) out << "  ratio" << std::endl;
+    if(spec->diff)  out << "  diff" << std::endl;
+    if(spec->bands) out << "  bands" << std::endl;
+    if(spec->efficiency >= 0)
+      out << "  efficiency " << Efficiency::GetIntervalName((EffInterval)spec->efficiency) << std::endl;
+    out << "end" << std::endl;
+  }
+}
@@ -0,0 +1,53 @@
+/** @file plotspec.h
+    @brief Plot specification files
+*/
+
+#ifndef PLOTSPEC_H
+#define PLOTSPEC_H
+
+#include <vector>
+
+#include <TROOT.h>
+#include <TString.h>
+
+/** One object of a plot: a histogram/graph (file + path) or a tree draw
+    (file + tree + expression, with optional selection and binning) */
+struct SpecItem {
+  TString file;
+  TString path;
+  TString tree;
+  TString expr;
+  TString cut;
+  TString binning;
+  Color_t colour; // -1: default colour
+  bool fill;
+
+  TObject *obj; // loaded object (owned by the plot once created)
+
+  bool IsTreeDraw() { return !tree.IsNull(); }
+};
+
+/** What Plotter::Draw puts in a Plot: objects and options */
+struct PlotSpec {
+  TString name;
+  std::vector<SpecItem*> items;
+  TString draw_options;
+  int rebin;
+  bool logx;
+  bool logy;
+  bool normalise;
+  bool normalise_to_first;
+  bool stats;
+  bool ratio;
+  bool diff;
+  bool bands;
+  int efficiency; // EffInterval of an efficiency plot, -1: none
+
+  PlotSpec(TString n);
+  ~PlotSpec();
+};
+
+std::vector<PlotSpec*> read_plot_specs(TString filename);
+void write_plot_specs(TString filename, std::vector<PlotSpec*> specs);
+
+#endif
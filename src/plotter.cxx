@@ -7,6 +7,7 @@
 #include <math.h>
 #include <vector>
 #include <algorithm>
+#include <set>
 
 #include <TBranch.h>
 #include <TLeaf.h>
@@ -14,12 +15,34 @@
 #include <TH2.h>
 #include <TH3.h>
 #include <TGraph.h>
+#include <TTimer.h>
+#include <TRegexp.h>
+#include <TSystem.h>
+#include <TGMsgBox.h>
 
 #include "item.h"
+#include "catalog.h"
 #include "filebox.h"
 #include "obj.h"
 #include "plot.h"
-
+#include "match.h"
+#include "pageview.h"
+#include "workers.h"
+#include "plotspec.h"
+#include "filepool.h"
+#include "export.h"
+#include "slicer.h"
+#include "ratio.h"
+#include "diffview.h"
+#include "branchview.h"
+#include "sum.h"
+#include "stats.h"
+#include "ioperf.h"
+#include "resultcache.h"
+#include "objcache.h"
+#include "memory.h"
+#include "trace.h"
+#include "statsview.h"
 
 #include "config.h"
 
@@ -27,6 +50,10 @@ enum MenuId {
   M_FILE_OPEN,
   M_FILE_SETTINGS,
   M_FILE_SAVE_CANVASES,
+  M_FILE_SAVE_SPECS,
+  M_FILE_MATCH,
+  M_FILE_DIFF,
+  M_FILE_SUM,
   M_FILE_RESET,
   M_FILE_CLOSE,
   M_FILE_EXIT,
@@ -41,6 +68,8 @@ enum MenuId {
   M_MACRO_CREATE_PYTHON,
   M_VIEW_CUTS,
   M_VIEW_COLOURS,
+  M_VIEW_STATS,
+  M_VIEW_BRANCHES,
   RB_COLZ,
   RB_SCATTER,
   RB_BOX
@@ -59,6 +88,9 @@ ClassImp(Plotter);
 Plotter::Plotter(std::vector<TString> filenames, bool merge) :
   TGMainFrame(gClient->GetRoot(), 800, 500),
   m_file_names(filenames),
+  m_max_plots(0),
+  m_status_timer(0),
+  macro(0),
   m_merge_mode(merge),
   m_macro_recording(false)
 {
@@ -87,8 +119,22 @@ Plotter::Plotter(std::vector<TString> filenames, bool merge) :
 
 Plotter::~Plotter()
 {
+  delete m_status_timer;
   Cleanup();
   for(unsigned int k=0; k<m_plots.size(); k++) delete m_plots[k];
+  ReleaseClosedPlots();
+  for(unsigned int k=0; k<m_specs.size(); k++) delete m_specs[k];
+  if(macro) delete macro;
+  for(unsigned int k=0; k<m_catalogs.size(); k++) delete m_catalogs[k];
+  RemoveSumFiles();
+}
+
+/** Remove the temporary files of the sums */
+void Plotter::RemoveSumFiles()
+{
+  FilePool::Instance()->CloseAll();
+  for(unsigned int k=0; k<m_sum_files.size(); k++) gSystem->Unlink(m_sum_files[k]);
+  m_sum_files.clear();
 }
 
 /** Create main window:
@@ -107,11 +153,12 @@ void Plotter::CreateMainWindow()
   CreateColoursFrame();
   AddFrame(frame_main, new TGLayoutHints(kLHintsExpandX | kLHintsExpandY, 0, 2, 0, 2));
   CreateCutsEntry();
+  CreateStatusBar();
 }
 
 /** Create menu bar:
-    - File: Save all canvases, Exit
-    - View : Colours, Cuts
+    - File: Match across files, Diff two files, Sum across files, Export all canvases, Save plot specs, Exit
+    - View : Colours, Cuts, Statistics
     - Macro: Begin, Reset, Save ROOT macro, Save python macro
 */
 void Plotter::CreateMenuBar()
@@ -120,7 +167,11 @@ void Plotter::CreateMenuBar()
   layout_menu_bar_item = new TGLayoutHints(kLHintsTop | kLHintsLeft, 0, 4, 0, 0);
 
   menu_file = new TGPopupMenu(fClient->GetRoot());
-  menu_file->AddEntry("Save all canvases ", M_FILE_SAVE_CANVASES);
+  menu_file->AddEntry("Match across files", M_FILE_MATCH);
+  menu_file->AddEntry("Diff two files", M_FILE_DIFF);
+  menu_file->AddEntry("Sum across files", M_FILE_SUM);
+  menu_file->AddEntry("Export all canvases... ", M_FILE_SAVE_CANVASES);
+  menu_file->AddEntry("Save plot specs... ", M_FILE_SAVE_SPECS);
   menu_file->AddEntry("Settings... ", M_FILE_SETTINGS);
   menu_file->DisableEntry(M_FILE_SETTINGS);
   menu_file->AddSeparator();
@@ -130,6 +181,8 @@ void Plotter::CreateMenuBar()
   menu_view = new TGPopupMenu(fClient->GetRoot());
   menu_view->AddEntry("Colours", M_VIEW_COLOURS);
   menu_view->AddEntry("Cuts", M_VIEW_CUTS);
+  menu_view->AddEntry("Statistics...", M_VIEW_STATS);
+  menu_view->AddEntry("Branch I/O costs...", M_VIEW_BRANCHES);
   menu_view->Associate(this);
 
   menu_macro = new TGPopupMenu(fClient->GetRoot());
@@ -151,32 +204,70 @@ void Plotter::CreateMenuBar()
 }
 
 /* Create frame with fileboxes.
-   Each box represents a file
+   Each box represents a file. The boxes are shown in pages, and the
+   boxes of a page (and their files) are only created when the page is
+   shown for the first time
 */
 void Plotter::CreateMainFrame()
 {
-  UInt_t n_cols = 0;
-  UInt_t n_rows = 0;
-
-  if(m_number_of_files <= 5){
-    n_rows = 1;
-    n_cols = m_number_of_files;
-  }
-  else if(m_number_of_files > 5 && m_number_of_files <= 10){
-    n_rows = 2;
-    n_cols = int(floor(m_number_of_files/2. + 0.5));
-  }
-  else{
-    n_rows = 3;
-    n_cols = int(floor(m_number_of_files/3. + 0.5));
-  }
-
   if(m_merge_mode) {
     m_number_of_files = 1;
-    n_rows = 1;
-    n_cols = 1;
   }
 
+  for(UInt_t i=0; i<m_number_of_files; i++){
+    m_catalogs.push_back(new Catalog(i, m_file_names[i]));
+    boxes.push_back(0);
+  }
+
+  frame_sums = 0;
+
+  m_number_of_pages = (m_number_of_files + files_per_page - 1) / files_per_page;
+  m_current_page = 0;
+  m_pages.assign(m_number_of_pages, (TGCompositeFrame*)0);
+
+  frame_aux = new TGCompositeFrame(frame_main, 0, 0, kVerticalFrame);
+
+  // Page navigation and search
+  frame_pages = new TGHorizontalFrame(frame_aux, 10, 10, kHorizontalFrame);
+
+  button_prev_page = new TGTextButton(frame_pages, " < ", 0);
+  button_next_page = new TGTextButton(frame_pages, " > ", 0);
+  label_page = new TGLabel(frame_pages, "Page 1/1");
+  entry_search = new TGTextEntry(frame_pages, "", 0);
+
+  button_prev_page->SetToolTipText("Previous page of files.");
+  button_next_page->SetToolTipText("Next page of files.");
+  entry_search->SetToolTipText("Search items in all the files (wildcards allowed) and go to the first file with a match.");
+
+  button_prev_page->Connect("Clicked()", "Plotter", this, "OnButtonPrevPage()");
+  button_next_page->Connect("Clicked()", "Plotter", this, "OnButtonNextPage()");
+  entry_search->Connect("ReturnPressed()", "Plotter", this, "OnSearch()");
+
+  frame_pages->AddFrame(button_prev_page, new TGLayoutHints(kLHintsLeft, 2, 2, 2, 2));
+  frame_pages->AddFrame(label_page, new TGLayoutHints(kLHintsLeft | kLHintsCenterY, 5, 5, 2, 2));
+  frame_pages->AddFrame(button_next_page, new TGLayoutHints(kLHintsLeft, 2, 2, 2, 2));
+  frame_pages->AddFrame(entry_search, new TGLayoutHints(kLHintsRight | kLHintsExpandX, 20, 2, 2, 2));
+
+  frame_aux->AddFrame(frame_pages, new TGLayoutHints(kLHintsExpandX, 0, 2, 0, 2));
+
+  frame_main->AddFrame(frame_aux, new TGLayoutHints(kLHintsExpandY | kLHintsExpandX, 2, 2, 2, 2));
+
+  ShowPage(0);
+}
+
+/** Create the boxes of a page (up to files_per_page, in at most 3 rows) */
+void Plotter::CreatePage(UInt_t page)
+{
+  UInt_t first = page * files_per_page;
+  UInt_t n_files = std::min(files_per_page, m_number_of_files - first);
+
+  UInt_t n_rows = 0;
+  if(n_files <= 5)       n_rows = 1;
+  else if(n_files <= 10) n_rows = 2;
+  else                   n_rows = 3;
+
+  UInt_t n_cols = (n_files + n_rows - 1) / n_rows;
+
   // Width and height of the filebox. Depends screen resolution
   Int_t  x, y;
   UInt_t width, height;
@@ -190,32 +281,54 @@ void Plotter::CreateMainFrame()
   else if(n_rows == 2) h = int(height/2);
   else                 h = int(height/3);
 
-  frame_aux = new TGCompositeFrame(frame_main, 0, 0, kVerticalFrame);
+  TGCompositeFrame *frame_page = new TGCompositeFrame(frame_aux, 0, 0, kVerticalFrame);
 
+  TGHorizontalFrame *frame_row[3];
   for(UInt_t i=0; i<n_rows; i++){
-    frame_row[i] = new TGHorizontalFrame(frame_aux, 10, 10, kHorizontalFrame);
+    frame_row[i] = new TGHorizontalFrame(frame_page, 10, 10, kHorizontalFrame);
   }
 
   // Create file boxes (one for each file)
-  for(UInt_t i=0; i<m_number_of_files; i++){
-    Int_t row;
-    if(i < n_cols) row = 0;
-    else if(i>=n_cols && i<2*n_cols) row = 1;
-    else row = 2;
+  for(UInt_t i=0; i<n_files; i++){
+    Int_t row = i / n_cols;
+    UInt_t file = first + i;
 
-    boxes[i] = new FileBox(frame_row[row], w, h, i, m_file_names[i]);
+    boxes[file] = new FileBox(frame_row[row], w, h, m_catalogs[file]);
 
-    boxes[i]->GetContent()->Connect("Selected(Int_t)", "Plotter", this, "OnItemClick(Int_t)");
-    boxes[i]->GetContent()->GetContainer()->Connect("DoubleClicked(TGFrame*, Int_t)", "Plotter", this, "OnItemDoubleClick(TGFrame*, Int_t)");
+    boxes[file]->Connect("ItemClicked(Long_t)", "Plotter", this, "OnItemClick(Long_t)");
+    boxes[file]->Connect("ItemDoubleClicked(Long_t)", "Plotter", this, "OnItemDoubleClick(Long_t)");
 
-    frame_row[row]->AddFrame(boxes[i], new TGLayoutHints(kLHintsExpandX | kLHintsExpandY, 0, 2, 0, 2));
+    frame_row[row]->AddFrame(boxes[file], new TGLayoutHints(kLHintsExpandX | kLHintsExpandY, 0, 2, 0, 2));
   }
 
   for(UInt_t i=0;i<n_rows;i++){
-    frame_aux->AddFrame(frame_row[i], new TGLayoutHints(kLHintsExpandX | kLHintsExpandY, 0, 2, 0, 2));
+    frame_page->AddFrame(frame_row[i], new TGLayoutHints(kLHintsExpandX | kLHintsExpandY, 0, 2, 0, 2));
   }
 
-  frame_main->AddFrame(frame_aux, new TGLayoutHints(kLHintsExpandY | kLHintsExpandX, 2, 2, 2, 2));
+  frame_aux->AddFrame(frame_page, new TGLayoutHints(kLHintsExpandY | kLHintsExpandX, 0, 0, 0, 0));
+  frame_page->MapSubwindows();
+
+  m_pages[page] = frame_page;
+}
+
+/** Show a page of boxes, creating it if needed */
+void Plotter::ShowPage(UInt_t page)
+{
+  if(page >= m_number_of_pages) return;
+
+  if(m_pages[m_current_page] && page != m_current_page)
+    frame_aux->HideFrame(m_pages[m_current_page]);
+
+  if(!m_pages[page]) CreatePage(page);
+
+  frame_aux->ShowFrame(m_pages[page]);
+  m_current_page = page;
+
+  label_page->SetText(Form("Page %i/%i", page+1, m_number_of_pages));
+  button_prev_page->SetEnabled(page > 0);
+  button_next_page->SetEnabled(page+1 < m_number_of_pages);
+
+  frame_aux->Layout();
 }
 
 /** Creates the frame with all the plot options and buttons */
@@ -229,31 +342,41 @@ void Plotter::CreateOptionsFrame()
   //-- Buttons
   button_clear_selection = new TGTextButton(frame_options, "Clear selection", 0);
   button_draw            = new TGTextButton(frame_options, "Draw!",           0);
+  button_draw_pages      = new TGTextButton(frame_options, "Draw Pages",      0);
   button_draw_efficiency = new TGTextButton(frame_options, "Draw Efficiency", 0);
   button_draw_ratio      = new TGTextButton(frame_options, "Draw Ratio",      0);
+  button_slices          = new TGTextButton(frame_options, "Slices",          0);
   button_exit            = new TGTextButton(frame_options, "Exit",            0);
 
   button_clear_selection->SetToolTipText("Clear selected entries.");
   button_draw->SetToolTipText("Plot items.");
-  button_draw_efficiency->SetToolTipText("Plot the efficiency between the two selected histos (hlast/hfirst).");
+  button_draw_pages->SetToolTipText("Plot each selected item in its own pad, in pages of 3x2 pads of one window.");
+  button_draw_efficiency->SetToolTipText("Plot the efficiency of the selected histos wrt the first one selected (hn/hfirst). With histos from two files, each histo is divided by the one with the same name in the file of the first selected.");
   button_draw_ratio->SetToolTipText("Plot the ratio between the selected histos wrt the first one selected (hn/hfirst).");
+  button_slices->SetToolTipText("Open the projections of the first selected 2D/3D histo, with a range slider for each axis.");
 
   button_clear_selection->SetStyle("modern");
   button_draw->SetStyle("modern");
+  button_draw_pages->SetStyle("modern");
   button_draw_efficiency->SetStyle("modern");
   button_draw_ratio->SetStyle("modern");
+  button_slices->SetStyle("modern");
   button_exit->SetStyle("modern");
 
   button_clear_selection->Associate(this);
   button_draw->Associate(this);
+  button_draw_pages->Associate(this);
   button_draw_efficiency->Associate(this);
   button_draw_ratio->Associate(this);
+  button_slices->Associate(this);
   button_exit->Associate(this);
 
   button_clear_selection->Connect("Clicked()", "Plotter", this, "OnButtonClearSelection()");
   button_draw->Connect("Clicked()", "Plotter", this, "OnButtonDraw()");
+  button_draw_pages->Connect("Clicked()", "Plotter", this, "OnButtonDrawPages()");
   button_draw_efficiency->Connect("Clicked()", "Plotter", this, "OnButtonDrawEfficiency()");
   button_draw_ratio->Connect("Clicked()", "Plotter", this, "OnButtonDrawRatio()");
+  button_slices->Connect("Clicked()", "Plotter", this, "OnButtonSlices()");
   button_exit->Connect("Clicked()", "Plotter", this, "OnButtonExit()");
 
   //-- General Options
@@ -263,12 +386,25 @@ void Plotter::CreateOptionsFrame()
   group_options->AddFrame(check_include_diff  = new TGCheckButton(group_options, "Include Difference", 0), new TGLayoutHints(kLHintsLeft, 2, 2, 2, 2));
   group_options->AddFrame(check_order         = new TGCheckButton(group_options, "Keep file order", 0), new TGLayoutHints(kLHintsLeft, 2, 2, 2, 2));
   check_order->SetToolTipText("Draw the selected histos in the files/entries order instead the selection order.");
+  group_options->AddFrame(check_bands         = new TGCheckButton(group_options, "Percentile bands", 0), new TGLayoutHints(kLHintsLeft, 2, 2, 2, 2));
+  check_bands->SetToolTipText("Draw the min/max, 2.5-97.5% and 16-84% bands and the median of the selected histos, and only the histos that are often out of the bands (for many histos).");
 
   frame_log = new TGCompositeFrame(group_options, 10, 10, kHorizontalFrame);
   frame_log->AddFrame(check_log_x = new TGCheckButton(frame_log, "SetLogX", 0), new TGLayoutHints( kLHintsLeft, 2, 2, 5, 2));
   frame_log->AddFrame(check_log_y = new TGCheckButton(frame_log, "SetLogY", 0), new TGLayoutHints( kLHintsLeft, 10, 2, 5, 2));
   group_options->AddFrame(frame_log, new TGLayoutHints( kLHintsLeft, 0, 0, 0, 0));
 
+  frame_interval = new TGCompositeFrame(group_options, 10, 10, kHorizontalFrame);
+  frame_interval->AddFrame(new TGLabel(frame_interval, "Eff. interval"), new TGLayoutHints( kLHintsLeft, 2, 2, 7, 2));
+  combo_interval = new TGComboBox(frame_interval);
+  combo_interval->AddEntry("Clopper-Pearson", kClopperPearson);
+  combo_interval->AddEntry("Jeffreys", kJeffreys);
+  combo_interval->AddEntry("Wilson", kWilson);
+  combo_interval->Select(kClopperPearson);
+  combo_interval->Resize(120, 20);
+  frame_interval->AddFrame(combo_interval, new TGLayoutHints( kLHintsRight, 2, 2, 5, 2));
+  group_options->AddFrame(frame_interval, new TGLayoutHints( kLHintsLeft, 0, 0, 0, 0));
+
   //-- Histos options
   group_hist_options = new TGGroupFrame(frame_options, "Histos", kVerticalFrame);
   group_hist_options->SetTitlePos(TGGroupFrame::kLeft);
@@ -289,6 +425,9 @@ void Plotter::CreateOptionsFrame()
 
   group_hist_options->AddFrame(check_stats = new TGCheckButton(group_hist_options, "Show Stats", 0), layout_checks);
   check_stats->SetToolTipText("Show the histogram stats.");
+  group_hist_options->AddFrame(check_io_stats = new TGCheckButton(group_hist_options, "I/O Stats", 0), layout_checks);
+  check_io_stats->SetToolTipText("Show the I/O statistics of the tree draws (read calls, bytes, cache efficiency, time).");
+  check_io_stats->SetState(kButtonDown);
   group_hist_options->AddFrame(check_hist = new TGCheckButton(group_hist_options, "Line", 0), layout_checks);
   check_hist->SetToolTipText("Use the \"hist\" option.");
   group_hist_options->AddFrame(check_p = new TGCheckButton(group_hist_options, "Point", 0), layout_checks);
@@ -315,8 +454,10 @@ void Plotter::CreateOptionsFrame()
 
   frame_options->AddFrame(button_clear_selection, new TGLayoutHints(kLHintsExpandX, 2, 2, 29, 2));
   frame_options->AddFrame(button_draw, layout_buttons);
+  frame_options->AddFrame(button_draw_pages, layout_buttons);
   frame_options->AddFrame(button_draw_efficiency, layout_buttons);
   frame_options->AddFrame(button_draw_ratio,layout_buttons);
+  frame_options->AddFrame(button_slices, layout_buttons);
   frame_options->AddFrame(button_exit, new TGLayoutHints(kLHintsExpandX, 2, 2, 5, 20));
   frame_options->AddFrame(group_options, new TGLayoutHints(kLHintsExpandX, 2, 5, 5, 20));
   frame_options->AddFrame(group_hist_options, new TGLayoutHints(kLHintsExpandX, 2, 5, 5, 20));
@@ -355,10 +496,33 @@ void Plotter::CreateCutsEntry()
   menu_view->CheckEntry(M_VIEW_CUTS);
 }
 
-void Plotter::CreateStatusBar() // Sin uso por ahora :P
+/** Status bar with the session stats and the memory used, updated
+    every second */
+void Plotter::CreateStatusBar()
 {
   status_bar = new TGStatusBar(this, 50, 10, kHorizontalFrame);
   AddFrame(status_bar, new TGLayoutHints(kLHintsBottom | kLHintsLeft | kLHintsExpandX,0,0,2,0));
+
+  Int_t parts[2] = { 75, 25 };
+  status_bar->SetParts(parts, 2);
+
+  m_status_timer = new TTimer(1000, kFALSE);
+  m_status_timer->Connect("Timeout()", "Plotter", this, "UpdateStatusBar()");
+  m_status_timer->Start(1000, kFALSE);
+}
+
+void Plotter::UpdateStatusBar()
+{
+  status_bar->SetText(Stats::Instance()->GetSummary());
+  status_bar->SetText(MemoryAccountant::Instance()->GetSummary(), 1);
+}
+
+void Plotter::CloseWindow()
+{
+  if(!m_stats_file.IsNull()) Stats::Instance()->WriteJson(m_stats_file);
+  Trace::Instance()->Write();
+  RemoveSumFiles(); // Terminate exits without destroying the plotter
+  gApplication->Terminate(0);
 }
 
 Bool_t Plotter::ProcessMessage(Long_t msg, Long_t parm1, Long_t parm2)
@@ -376,10 +540,26 @@ Bool_t Plotter::ProcessMessage(Long_t msg, Long_t parm1, Long_t parm2)
         Exit();
         break;
 
+      case M_FILE_MATCH:
+        MatchAcrossFiles();
+        break;
+
+      case M_FILE_DIFF:
+        OpenDiff();
+        break;
+
+      case M_FILE_SUM:
+        SumAcrossFiles();
+        break;
+
       case M_FILE_SAVE_CANVASES:
         SavePlots();
         break;
 
+      case M_FILE_SAVE_SPECS:
+        SaveSpecs();
+        break;
+
       case M_FILE_SETTINGS:
         break;
 
@@ -391,24 +571,30 @@ Bool_t Plotter::ProcessMessage(Long_t msg, Long_t parm1, Long_t parm2)
         ShowHideColours();
         break;
 
+      case M_VIEW_STATS:
+        new StatsView(fClient->GetRoot());
+        break;
+
+      case M_VIEW_BRANCHES:
+        OpenBranchCosts();
+        break;
+
       case M_MACRO_BEGIN:
         {
-          // macro = new Macro("macro");
-          // for(unsigned int i=0; i<m_number_of_files; i++){
-          //   macro->AddFile(m_file_names[i]);
-          // }
-          // menu_macro->DisableEntry(M_MACRO_BEGIN);
-          // menu_macro->EnableEntry(M_MACRO_RESET);
-          // menu_macro->EnableEntry(M_MACRO_CREATE_ROOT);
-          // menu_macro->EnableEntry(M_MACRO_CREATE_PYTHON);
-          // m_macro_recording = true;
+          if(!macro) macro = new Macro("macro");
+          menu_macro->DisableEntry(M_MACRO_BEGIN);
+          menu_macro->EnableEntry(M_MACRO_RESET);
+          menu_macro->EnableEntry(M_MACRO_CREATE_ROOT);
+          menu_macro->EnableEntry(M_MACRO_CREATE_PYTHON);
+          m_macro_recording = true;
+          msg("Recording macro...");
         }
         break;
 
       case M_MACRO_RESET:
         {
-          //macro->Reset();
-          //msg("The macro has been reseted.");
+          if(macro) macro->Reset();
+          msg("The macro has been reseted.");
         }
         break;
 
@@ -483,7 +669,7 @@ void Plotter::CreateMergedFileBox()
 
 void Plotter::GetColours()
 {
-  for(unsigned int k=0; k<m_items.size(); k++){
+  for(unsigned int k=0; k<20; k++){
     colours[k] = TColor::GetColor(pcolors[k]);
     if(frame_main->IsVisible(frame_colours))
       colours[k] = TColor::GetColor(colorselect[k]->GetColor());
@@ -498,43 +684,157 @@ void Plotter::GetColours()
 void Plotter::ClearSelection()
 {
   m_items.clear();
-  for(UInt_t i=0; i<m_number_of_files; i++){
-    boxes[i]->Clear();
+  for(UInt_t i=0; i<boxes.size(); i++){
+    if(boxes[i]) boxes[i]->Clear();
   }
 
   return;
 }
 
-Obj* Plotter::GetObject(Item* it)
+/** Catalog of the file of an item, or 0 (with an error) if there's none */
+Catalog* Plotter::GetCatalog(Item *it)
+{
+  if(it->GetFile() < 0 || it->GetFile() >= (Int_t)m_catalogs.size()) {
+    error("No file " << it->GetFile() << " for " << it->GetFullPath());
+    return 0;
+  }
+  return m_catalogs[it->GetFile()];
+}
+
+/** Key of the object of an item in an ObjectCache */
+TString Plotter::GetObjectKey(Item* it)
+{
+  Catalog *catalog = GetCatalog(it);
+  return catalog ? catalog->GetFileName() + ":" + it->GetFullPath() : "";
+}
+
+/** Size of the object of an item (not a tree draw) that can be read
+    in advance into the cache, or -1 if it's already there or it cannot
+    be read in advance */
+Long64_t Plotter::GetPrefetchSize(Item* it, ObjectCache *cache)
 {
-  int file = it->GetFile();
+  Catalog *catalog = GetCatalog(it);
+  if(!catalog || it->IsBranch() || !it->IsPlotable()) return -1;
+  if(cache->Has(GetObjectKey(it))) return -1;
+
+  return catalog->GetObjectSize(it);
+}
+
+/** Get the object associated with the item from its file (or from the
+    prefetched objects). The file is (re)opened through the file pool if
+    it was closed */
+Obj* Plotter::GetObject(Item* it, ObjectCache *prefetched)
+{
+  Catalog *catalog = GetCatalog(it);
+  if(!catalog) return 0;
   TString name = it->GetName();
 
-  TObject *obj;
-  Obj *pobj;
+  TObject *obj = 0;
+  TString io_info = "";
+
+  if(prefetched && !it->IsBranch()) obj = prefetched->Get(GetObjectKey(it));
 
-  if(it->IsBranch()){
+  if(!obj && it->IsBranch()){
     TString cut = "";
     cut = TString(entry_cuts->GetText()).EqualTo("Cuts") ? "" : entry_cuts->GetText();
 
-    TTree* tree = boxes[file]->GetCurrentTree();
-    tree->Draw(name+">>h", cut, "goff");
+    TTree* tree = catalog->GetTree(it);
+    if(!tree) return 0;
+
+    // the same draw from a previous session
+    ResultCache *results = ResultCache::Instance();
+    TString key = results->Key(tree, name, cut, "");
+    TH1 *h = results->Get(key);
+
+    if(h) io_info = "Read from the cache of tree draws";
+    else {
+      if(!ConfirmSize(it)) return 0;
+
+      ScopedTimer timer(kStageTreeDraw, it->GetFullPath());
+      Stats::Instance()->Count(kCountEntries, tree->GetEntries());
+
+      TreePerf perf(tree);
+      tree->Draw(name+">>h", cut, "goff");
+      io_info = perf.Finish().GetSummary();
+
+      h = tree->GetHistogram();
+      if(h) {
+        h->SetDirectory(0); // keep it when the file is closed
+        results->Put(key, h);
+      }
+    }
+    obj = h;
+  }
+  else if(!obj) {
+    if((it->GetType() == Hist2D || it->GetType() == Hist3D) && !ConfirmSize(it)) return 0;
+    obj = catalog->GetObject(it);
+  }
+
+  if(!obj) {
+    error("Cannot read " << it->GetFullPath() << " from " << catalog->GetFileName());
+    return 0;
+  }
+
+  if(obj->InheritsFrom("TGraph"))
+    return new Obj((TGraph*)obj);
+
+  Obj *o = new Obj((TH1*)obj);
+  o->SetInfo(io_info);
+  return o;
+}
+
+/** Memory of a tree draw: the values of each variable of the
+    expression (x:y:z) and the weight, for up to the estimate of the
+    tree entries, are kept in buffers */
+static Long64_t tree_draw_bytes(TTree *tree, TString expr)
+{
+  Int_t variables = 1;
+  for(Ssiz_t i=0; i<expr.Length(); i++){
+    if(expr[i] != ':') continue;
+    if(i+1 < expr.Length() && expr[i+1] == ':') i++; // scope operator
+    else variables++;
+  }
+
+  Long64_t entries = std::min(tree->GetEntries(), tree->GetEstimate());
+  return entries*(variables+1)*8;
+}
 
-    obj = (TH1*)gDirectory->Get("h");
+/** Ask before reading a 2D/3D histogram or filling a tree draw that
+    would exceed the memory budget (with the coarser levels drawn for
+    large histograms) */
+bool Plotter::ConfirmSize(Item *it)
+{
+  Catalog *catalog = GetCatalog(it);
+  if(!catalog) return false;
+
+  Long64_t need = 0;
+  if(it->IsBranch()) {
+    TTree *tree = catalog->GetTree(it);
+    if(!tree) return true;
+    need = tree_draw_bytes(tree, it->GetName());
   }
   else {
-    TDirectory *dir = boxes[file]->GetCurrentDir();
-    obj = dir->Get(name);
+    Long64_t size = catalog->GetObjectSize(it);
+    need = size + size/3;
   }
 
-  pobj = new Obj((TH1*)obj);
+  MemoryAccountant *memory = MemoryAccountant::Instance();
+  if(memory->Fits(need)) return true;
+
+  Int_t ret = 0;
+  new TGMsgBox(gClient->GetRoot(), this, "Memory budget",
+               Form("%s needs about %s, and %s of the budget of %s are already used.\nDraw it anyway?",
+                    it->GetFullPath().Data(), format_bytes(need).Data(),
+                    format_bytes(memory->GetTotal()).Data(), format_bytes(memory->GetBudget()).Data()),
+               kMBIconExclamation, kMBYes | kMBNo, &ret);
 
-  return pobj;
+  return ret == kMBYes;
 }
 
-/** Draw function. Creates a plot with the selected items and options
+/** Draw function. Creates a plot with the selected items and options.
+    With efficiency the first item is the total of all the others
 */
-void Plotter::Draw()
+void Plotter::Draw(bool efficiency)
 {
   if(m_items.size()==0) return;
 
@@ -542,19 +842,42 @@ void Plotter::Draw()
   if(check_order->GetState())  sort(m_items.begin(), m_items.end(), SortVs);
 
   Plot *p = new Plot();
+  PlotSpec *spec = new PlotSpec(p->GetName());
 
-  p->SetLogX(check_log_x->GetState());
-  p->SetLogY(check_log_y->GetState());
+  spec->logx = check_log_x->GetState();
+  spec->logy = check_log_y->GetState();
+  spec->rebin = nentry_rebin->GetIntNumber();
+  spec->normalise = check_normalise->GetState();
+  spec->normalise_to_first = check_normalise2->GetState();
+  spec->stats = check_stats->GetState();
 
   GetColours();
 
+  TString cut = TString(entry_cuts->GetText()).EqualTo("Cuts") ? "" : entry_cuts->GetText();
+
   for(UInt_t k=0; k<m_items.size(); k++){
     if(!m_items[k]->IsPlotable()) continue;
-    p->Add(GetObject(m_items[k]), colours[k], check_fill[k]->GetState());
+    Obj *obj = GetObject(m_items[k]);
+    if(!obj) continue;
+    p->Add(obj, colours[k%20], check_fill[k%20]->GetState());
+
+    SpecItem *item = new SpecItem();
+    item->file = GetCatalog(m_items[k])->GetFileName();
+    if(m_items[k]->IsBranch()) {
+      item->tree = m_items[k]->GetPath();
+      item->expr = m_items[k]->GetName();
+      item->cut = cut;
+    }
+    else item->path = m_items[k]->GetFullPath();
+    item->colour = colours[k%20];
+    item->fill = check_fill[k%20]->GetState();
+    item->obj = 0;
+    spec->items.push_back(item);
   }
 
-  if(check_include_ratio->GetState()) p->SetIncludeRatio(true);
-  else if(check_include_diff->GetState()) p->SetIncludeDiff(true);
+  if(check_include_ratio->GetState()) spec->ratio = true;
+  else if(check_include_diff->GetState()) spec->diff = true;
+  spec->bands = check_bands->GetState();
 
 
   TString draw_opts = "";
@@ -567,23 +890,203 @@ void Plotter::Draw()
   else if(radio_box->GetState()) draw_opts += "box,";
   else  draw_opts += "colz,";
 
-  p->SetDrawOptions(draw_opts);
-
+  spec->draw_options = draw_opts;
+
+  p->SetLogX(spec->logx);
+  p->SetLogY(spec->logy);
+  p->SetRebin(spec->rebin);
+  p->SetNormalise(spec->normalise);
+  p->SetNormaliseToFirst(spec->normalise_to_first);
+  p->SetShowStats(spec->stats);
+  p->SetShowInfo(check_io_stats->GetState());
+  p->SetIncludeRatio(spec->ratio);
+  p->SetIncludeDiff(spec->diff);
+  p->SetBands(spec->bands);
+  p->SetDrawOptions(spec->draw_options);
+
+  if(efficiency) {
+    spec->efficiency = combo_interval->GetSelected();
+    p->SetEfficiency(true, (EffInterval)spec->efficiency);
+  }
 
   p->Create();
+  AddPlot(p);
 
-  m_plots.push_back(p);
+  m_specs.push_back(spec);
+
+  if(m_macro_recording) RecordMacro(spec);
 
   return;
 }
 
+/** Each selected item in its own pad, in pages of one window. The
+    pages are only drawn when shown */
+void Plotter::DrawPages()
+{
+  if(check_order->GetState()) sort(m_items.begin(), m_items.end(), SortVs);
+
+  std::vector<std::vector<Item*> > plots;
+  for(UInt_t k=0; k<m_items.size(); k++){
+    if(!m_items[k]->IsPlotable()) continue;
+    plots.push_back(std::vector<Item*>(1, m_items[k]));
+  }
+  if(plots.empty()) return;
+
+  new PageView(gClient->GetRoot(), this, "Selection", plots, 3, 2);
+}
+
+/** Add the objects of the items to a plot of a page, with the colour
+    of their file and the current options */
+void Plotter::FillPlot(Plot *p, std::vector<Item*> &items, ObjectCache *prefetched)
+{
+  GetColours();
+
+  for(UInt_t k=0; k<items.size(); k++){
+    Obj *obj = GetObject(items[k], prefetched);
+    if(!obj) continue;
+    Int_t file = items[k]->GetFile();
+    p->Add(obj, colours[file%20], check_fill[file%20]->GetState());
+  }
+
+  p->SetLogX(check_log_x->GetState());
+  p->SetLogY(check_log_y->GetState());
+  p->SetRebin(nentry_rebin->GetIntNumber());
+  p->SetNormalise(check_normalise->GetState());
+  p->SetShowStats(check_stats->GetState());
+  p->SetShowInfo(check_io_stats->GetState());
+  p->SetIncludeRatio(items.size() > 1 && check_include_ratio->GetState());
+}
+
+/** Keep a new plot, recycling the oldest ones if there are too many */
+void Plotter::AddPlot(Plot *p)
+{
+  {
+    ScopedTimer timer(kStagePaint);
+    p->GetCanvas()->Update();
+  }
+
+  // release the plot when its window is closed
+  p->GetCanvas()->Connect("Closed()", "Plotter", this, "OnCanvasClosed()");
+
+  while(m_max_plots > 0 && m_plots.size() >= m_max_plots){
+    RemoveSpec(m_plots.front()->GetName());
+    delete m_plots.front();
+    m_plots.erase(m_plots.begin());
+  }
+
+  m_plots.push_back(p);
+}
+
+/** Efficiency of the selected histos wrt the first one selected, in one
+    plot. If the histos come from two files, each histo of the other file
+    is divided by the histo with the same path in the file of the first
+    one, with one plot for each pair */
 void Plotter::DrawEfficiency()
 {
-  if(m_items.size() != 2) {
-    error("You can only draw the efficiency from two histograms.");
+  if(m_items.size() < 2) {
+    error("Select the total histogram and at least one pass histogram.");
     return;
   }
 
+  UInt_t den_file = m_items[0]->GetFile();
+
+  int other_file = -1;
+  bool pairs = true;
+  for(UInt_t k=1; k<m_items.size(); k++){
+    int file = m_items[k]->GetFile();
+    if(file == (int)den_file) continue;
+    if(other_file >= 0 && file != other_file) pairs = false;
+    other_file = file;
+  }
+
+  // two items: always hlast/hfirst
+  if(other_file < 0 || m_items.size() == 2) pairs = false;
+
+  if(pairs) DrawEfficiencyPairs(den_file);
+  else Draw(true);
+}
+
+/** One efficiency plot for each selected histo not in den_file, with the
+    histo of the same path in den_file as total. All the efficiencies are
+    computed at once */
+void Plotter::DrawEfficiencyPairs(UInt_t den_file)
+{
+  if(den_file >= m_catalogs.size()) return;
+  Catalog *catalog = m_catalogs[den_file];
+
+  std::vector<Obj*> sources;
+  std::vector<TH1*> nums, dens;
+  std::vector<Item*> num_items, den_items;
+
+  for(UInt_t k=0; k<m_items.size(); k++){
+    Item *item = m_items[k];
+    if(item->GetFile() == (Int_t)den_file || !item->IsPlotable() || item->IsBranch()) continue;
+
+    Item *den_item = catalog->FindPath(item->GetFullPath());
+    if(!den_item) {
+      error(item->GetFullPath() << " not found in " << catalog->GetFileName());
+      continue;
+    }
+
+    Obj *num = GetObject(item);
+    Obj *den = GetObject(den_item);
+    if(num) sources.push_back(num);
+    if(den) sources.push_back(den);
+    if(!num || !den) continue;
+
+    if(num->IsGraph() || den->IsGraph()) {
+      error("Cannot compute the efficiency of the graph " << item->GetFullPath());
+      continue;
+    }
+
+    nums.push_back(num->GetHist());
+    dens.push_back(den->GetHist());
+    num_items.push_back(item);
+    den_items.push_back(den_item);
+  }
+
+  EffInterval interval = (EffInterval)combo_interval->GetSelected();
+
+  Efficiency engine(interval);
+  std::vector<TGraphAsymmErrors*> graphs = engine.Compute(nums, dens);
+
+  GetColours();
+
+  for(UInt_t k=0; k<graphs.size(); k++){
+    if(!graphs[k]) continue;
+
+    Plot *p = new Plot();
+    PlotSpec *spec = new PlotSpec(p->GetName());
+    spec->logx = check_log_x->GetState();
+    spec->logy = check_log_y->GetState();
+    spec->efficiency = interval;
+
+    // the same plot as an efficiency of the pair: total first
+    Item *pair[2] = { den_items[k], num_items[k] };
+    for(UInt_t i=0; i<2; i++){
+      SpecItem *item = new SpecItem();
+      item->file = GetCatalog(pair[i])->GetFileName();
+      item->path = pair[i]->GetFullPath();
+      item->colour = colours[0];
+      item->fill = false;
+      item->obj = 0;
+      spec->items.push_back(item);
+    }
+
+    if(spec->logy) Efficiency::SetLogMinimum(graphs[k]);
+    p->Add(new Obj(graphs[k]), colours[0], false);
+    p->SetLogX(spec->logx);
+    p->SetLogY(spec->logy);
+    p->Create();
+    AddPlot(p);
+
+    m_specs.push_back(spec);
+    if(m_macro_recording) RecordMacro(spec);
+  }
+
+  for(UInt_t k=0; k<sources.size(); k++) delete sources[k];
+
+  msg(graphs.size() << " efficiencies (" << Efficiency::GetIntervalName(interval) << " intervals)");
 }
 
 void Plotter::DrawRatio()
@@ -595,10 +1098,219 @@ void Plotter::DrawRatio()
 
 }
 
+/** Slicing window for the first selected 2D/3D histogram */
+void Plotter::OpenSlices()
+{
+  for(UInt_t k=0; k<m_items.size(); k++){
+    Item *it = m_items[k];
+    if(it->GetType() != Hist2D && it->GetType() != Hist3D) continue;
+
+    Catalog *catalog = GetCatalog(it);
+    if(!catalog) return;
+    TObject *obj = catalog->GetObject(it);
+    if(!obj) {
+      error("Cannot read " << it->GetFullPath() << " from " << catalog->GetFileName());
+      return;
+    }
+
+    // the prefix sums of a profile would add up the sums of w*y, not the means
+    if(is_profile((TH1*)obj)) {
+      error("Cannot slice the profile " << it->GetFullPath());
+      delete obj;
+      return;
+    }
+
+    new SliceView(gClient->GetRoot(), (TH1*)obj);
+    return;
+  }
+
+  error("Select a 2D or 3D histogram.");
+}
+
+/** Compare all the objects with the same path in several files: one
+    plot for each path (with the ratio to the first file if selected), in
+    pages of 3x2 pads */
+void Plotter::MatchAcrossFiles()
+{
+  if(m_catalogs.size() < 2) {
+    error("Open at least two files to match.");
+    return;
+  }
+
+  Matcher matcher(m_catalogs);
+  UInt_t n = matcher.Join();
+  if(n == 0) {
+    msg("No object found in more than one file");
+    return;
+  }
+
+  std::vector<std::vector<Item*> > plots;
+  std::vector<MatchedPath*> &matches = matcher.GetMatches();
+  for(UInt_t m=0; m<matches.size(); m++) plots.push_back(matches[m]->items);
+
+  new PageView(gClient->GetRoot(), this, "Match across files", plots, 3, 2);
+
+  msg(n << " objects matched across " << m_catalogs.size() << " files");
+}
+
+/** Statistical comparison of all the histograms of two files: the files
+    of the first two selected items from different files (the first one
+    is the reference), or the two files open */
+void Plotter::OpenDiff()
+{
+  int ref = -1, test = -1;
+  for(UInt_t k=0; k<m_items.size(); k++){
+    int file = m_items[k]->GetFile();
+    if(ref < 0) ref = file;
+    else if(file != ref) {
+      test = file;
+      break;
+    }
+  }
+
+  if(test < 0 && m_catalogs.size() == 2) {
+    ref = 0;
+    test = 1;
+  }
+  if(test < 0 || ref >= (int)m_catalogs.size() || test >= (int)m_catalogs.size()) {
+    error("Select one item from the reference file and one from the test file.");
+    return;
+  }
+
+  new DiffView(gClient->GetRoot(), this, ref, m_catalogs[ref], test, m_catalogs[test]);
+}
+
+/** Sizes, compression and baskets of all the branches of the tree of
+    the first selected branch */
+void Plotter::OpenBranchCosts()
+{
+  for(UInt_t k=0; k<m_items.size(); k++){
+    if(!m_items[k]->IsBranch()) continue;
+    Catalog *catalog = GetCatalog(m_items[k]);
+    if(catalog) new BranchView(gClient->GetRoot(), catalog, m_items[k]->GetPath());
+    return;
+  }
+
+  error("Select a branch of the tree.");
+}
+
+/** Sum the selected histograms (or, without selection, the histograms
+    whose path begins with the text of the search entry, wildcards allowed)
+    over all the files. The sums are added as a new box, so they can be
+    drawn as any other item */
+void Plotter::SumAcrossFiles()
+{
+  std::vector<TString> paths;
+  std::set<TString> seen;
+
+  for(UInt_t k=0; k<m_items.size(); k++){
+    if(!m_items[k]->IsTypeHist() || m_items[k]->IsBranch()) continue;
+    TString path = m_items[k]->GetFullPath();
+    if(seen.insert(path).second) paths.push_back(path);
+  }
+
+  if(paths.empty()) {
+    TString pattern = entry_search->GetText();
+    if(pattern.IsNull()) {
+      error("Select the histograms to sum, or write their directory in the search entry.");
+      return;
+    }
+
+    TRegexp re(pattern, kTRUE);
+    for(UInt_t f=0; f<m_number_of_files; f++){
+      std::vector<Item*> items = m_catalogs[f]->GetPlotableItems();
+      for(UInt_t k=0; k<items.size(); k++){
+        if(!items[k]->IsTypeHist()) continue;
+        TString path = items[k]->GetFullPath();
+        if(path.Index(re) != 0) continue;
+        if(seen.insert(path).second) paths.push_back(path);
+      }
+    }
+  }
+
+  if(paths.empty()) {
+    error("No histogram to sum.");
+    return;
+  }
+
+  std::vector<TString> filenames;
+  for(UInt_t f=0; f<m_number_of_files; f++) filenames.push_back(m_catalogs[f]->GetFileName());
+
+  Summer summer(filenames, paths);
+  if(!summer.Run(number_of_cores())) return;
+  UInt_t n = summer.GetNSums();
+  if(n == 0) {
+    error("None of the histograms found.");
+    return;
+  }
+
+  TString filename = Form("%s/plotter_%i_sum%u.root", gSystem->TempDirectory(), gSystem->GetPid(), (UInt_t)m_sum_files.size()+1);
+  if(!summer.Write(filename)) return;
+  m_sum_files.push_back(filename);
+
+  AddSumBox(filename);
+
+  msg(n << " histograms summed over " << filenames.size() << " files");
+}
+
+/** Box with the items of a file of sums, next to the options */
+void Plotter::AddSumBox(TString filename)
+{
+  Catalog *catalog = new Catalog(m_catalogs.size(), filename);
+  m_catalogs.push_back(catalog);
+
+  if(!frame_sums) {
+    frame_sums = new TGVerticalFrame(frame_main, 0, 0, kVerticalFrame);
+    frame_main->AddFrame(frame_sums, new TGLayoutHints(kLHintsExpandY, 2, 2, 2, 2));
+  }
+
+  FileBox *box = new FileBox(frame_sums, 200, 300, catalog);
+  box->Connect("ItemClicked(Long_t)", "Plotter", this, "OnItemClick(Long_t)");
+  box->Connect("ItemDoubleClicked(Long_t)", "Plotter", this, "OnItemDoubleClick(Long_t)");
+  frame_sums->AddFrame(box, new TGLayoutHints(kLHintsExpandX | kLHintsExpandY, 0, 2, 0, 2));
+  boxes.push_back(box);
+
+  frame_main->MapSubwindows();
+  frame_main->Layout();
+  Resize(GetDefaultSize());
+}
+
+/** Overlay of the object with the path in two files, with the ratio test/ref */
+void Plotter::DrawPair(UInt_t ref_file, UInt_t test_file, TString path)
+{
+  if(ref_file >= m_catalogs.size() || test_file >= m_catalogs.size()) return;
+
+  Item *ref = m_catalogs[ref_file]->FindPath(path);
+  Item *test = m_catalogs[test_file]->FindPath(path);
+  if(!ref || !test) {
+    error(path << " not found in both files");
+    return;
+  }
+
+  Obj *obj_ref = GetObject(ref);
+  Obj *obj_test = GetObject(test);
+  if(!obj_ref || !obj_test) {
+    delete obj_ref;
+    delete obj_test;
+    return;
+  }
+
+  GetColours();
+
+  Plot *p = new Plot();
+  p->Add(obj_ref, colours[0], check_fill[0]->GetState());
+  p->Add(obj_test, colours[1], check_fill[1]->GetState());
+  p->SetLogX(check_log_x->GetState());
+  p->SetLogY(check_log_y->GetState());
+  p->SetIncludeRatio(true);
+  p->Create();
+  AddPlot(p);
+}
+
 std::vector<int> Plotter::GetNumberOfObjectsInEachFile()
 {
   std::vector<int> hsv;
-  for(unsigned int f=0; f<m_number_of_files; f++) hsv.push_back(0);
+  for(unsigned int f=0; f<m_catalogs.size(); f++) hsv.push_back(0);
 
   for(unsigned int k=0; k<m_items.size(); k++){
     hsv[m_items[k]->GetFile()]++;
@@ -610,14 +1322,66 @@ std::vector<int> Plotter::GetNumberOfObjectsInEachFile()
   return hsv;
 }
 
-/** Save all open plots to .eps files
+/** A canvas window has been closed: its plot is detached from the canvas
+    (which is deleted by ROOT) and deleted afterwards, from the event loop */
+void Plotter::OnCanvasClosed()
+{
+  TCanvas *c = (TCanvas*)gTQSender;
+
+  for(unsigned int k=0; k<m_plots.size(); k++){
+    if(m_plots[k]->GetCanvas() != c) continue;
+    RemoveSpec(m_plots[k]->GetName());
+    m_plots[k]->DetachCanvas();
+    m_closed_plots.push_back(m_plots[k]);
+    m_plots.erase(m_plots.begin()+k);
+    TTimer::SingleShot(0, "Plotter", this, "ReleaseClosedPlots()");
+    break;
+  }
+}
+
+/** Forget the spec (and the macro canvas) of a plot that is closed, so
+    only the open plots are saved */
+void Plotter::RemoveSpec(TString name)
+{
+  for(unsigned int k=0; k<m_specs.size(); k++){
+    if(m_specs[k]->name != name) continue;
+    delete m_specs[k];
+    m_specs.erase(m_specs.begin()+k);
+    break;
+  }
+
+  if(macro) macro->RemoveCanvas(name);
+}
+
+/** Delete the plots whose canvas has been closed */
+void Plotter::ReleaseClosedPlots()
+{
+  for(unsigned int k=0; k<m_closed_plots.size(); k++) delete m_closed_plots[k];
+  m_closed_plots.clear();
+}
+
+/** Export all the open plots to the formats chosen in the export dialog
  */
 void Plotter::SavePlots()
 {
+  static ExportInfo info;
+  new ExportDialog(fClient->GetRoot(), this, &info);
+  if(!info.accepted) return;
+
+  Exporter exporter(info.dir, info.name);
+  exporter.SetFormats(info.formats);
+  exporter.SetDpi(info.dpi);
+  exporter.SetJobs(info.jobs);
+
   for(UInt_t k=0; k < m_plots.size(); k++){
-    m_plots[k]->Save();
+    TCanvas *c = m_plots[k]->GetCanvas();
+    // skip the canvases closed by the user
+    if(!c || !gROOT->GetListOfCanvases()->FindObject(c)) continue;
+    exporter.Add(c, m_plots[k]->GetName());
   }
 
+  exporter.Export();
+
   return;
 }
 
@@ -626,6 +1390,8 @@ void Plotter::SavePlots()
 */
 void Plotter::CreateMacro(OutputFormat type)
 {
+  if(!macro) return;
+
   static TString dir(".");
   TGFileInfo fi;
   fi.fIniDir    = StrDup(dir);
@@ -636,6 +1402,73 @@ void Plotter::CreateMacro(OutputFormat type)
   }
 }
 
+/** Add the canvas of a plot to the macro being recorded */
+void Plotter::RecordMacro(PlotSpec *spec)
+{
+  CanvasInfo *c = new CanvasInfo(spec->name);
+  c->SetLog(spec->logx, spec->logy);
+  c->SetNormalise(spec->normalise, spec->normalise_to_first);
+  c->SetRatio(spec->ratio, spec->diff);
+
+  bool many_files = false;
+  for(unsigned int k=1; k<spec->items.size(); k++){
+    if(spec->items[k]->file != spec->items[0]->file) many_files = true;
+  }
+
+  for(unsigned int k=0; k<spec->items.size(); k++){
+    SpecItem *item = spec->items[k];
+    Int_t file = macro->AddFile(item->file);
+
+    Catalog *catalog = 0;
+    for(unsigned int i=0; i<m_catalogs.size(); i++){
+      if(m_catalogs[i]->GetFileName() == item->file) catalog = m_catalogs[i];
+    }
+
+    HistoInfo *h;
+    if(item->IsTreeDraw()) {
+      h = new HistoInfo(file, item->expr, item->expr);
+      h->SetTreeDraw(item->tree, item->cut, item->binning);
+    }
+    else {
+      Int_t slash = item->path.Last('/');
+      h = new HistoInfo(file, item->path(slash+1, item->path.Length()), "");
+      if(slash >= 0) h->SetPath(item->path(0, slash));
+      Item *it = catalog ? catalog->FindPath(item->path) : 0;
+      h->SetGraph(it && it->IsTypeGraph());
+    }
+    h->SetColour(item->colour);
+    h->SetFill(item->fill);
+    h->SetRebinNumber(spec->rebin);
+    h->SetDrawOptions(spec->draw_options);
+
+    TString legend = h->GetName();
+    if(many_files && catalog) legend += " (" + catalog->GetShortName() + ")";
+    h->SetLegendText(legend);
+
+    c->AddHisto(h);
+  }
+
+  macro->AddCanvas(c);
+}
+
+/** Save the specifications of all the plots drawn, to make them again
+    with plotter --batch --spec FILE */
+void Plotter::SaveSpecs()
+{
+  if(m_specs.empty()) {
+    error("There are no plots to save.");
+    return;
+  }
+
+  static TString dir(".");
+  TGFileInfo fi;
+  fi.fIniDir    = StrDup(dir);
+  new TGFileDialog(fClient->GetRoot(), this, kFDSave, &fi);
+  if(fi.fFilename) {
+    write_plot_specs(fi.fFilename, m_specs);
+    msg("The plot specs have been saved in " << fi.fFilename);
+  }
+}
 
 /** Load configuration values
     Use .plotterrc if exists, or default values otherwise
@@ -663,12 +1496,9 @@ void Plotter::CreateMacro(OutputFormat type)
     true  -> Add item to items_selected depending its status
     false -> Erase item from items_selected depending its status
 */
-void Plotter::OnItemClick(Int_t id)
+void Plotter::OnItemClick(Long_t item)
 {
-  Int_t entry = id_to_entry(id);
-  Int_t file  = id_to_file(id);
-
-  Item *it = boxes[file]->GetItem(entry);
+  Item *it = (Item*)item;
 
   // if folder/tree do nothing and return
   if(!it->IsPlotable()) {
@@ -684,7 +1514,7 @@ void Plotter::OnItemClick(Int_t id)
     m_items.push_back(it);
   else{
     for(UInt_t k=0; k<m_items.size(); k++){
-      if( m_items[k]->GetId() == id )
+      if( m_items[k] == it )
         m_items.erase(m_items.begin()+k);
     }
   }
@@ -694,34 +1524,43 @@ void Plotter::OnItemClick(Int_t id)
     (Mouse buttons-> 1: left, 2: middle, 3: right, 4-5: wheel)
     - if IsPlotable -> Draw
 */
-void Plotter::OnItemDoubleClick(TGFrame* f, Int_t btn)
+void Plotter::OnItemDoubleClick(Long_t item)
 {
-  if(btn==1) {
+  Item *it = (Item*)item;
+  if(!it->IsPlotable()) return;
 
-    Int_t id = ((TGLBEntry*)f)->EntryId();
+  Draw();
 
-    Int_t entry = id_to_entry(id);
-    Int_t file  = id_to_file(id);
+  UInt_t file = it->GetFile();
+  if(file < boxes.size() && boxes[file]) {
+    TGLBEntry *entry = boxes[file]->GetContent()->GetEntry(it->GetId());
+    if(entry) entry->Activate(false);
+  }
+  OnItemClick(item);
+}
 
-    Item *it = boxes[file]->GetItem(entry);
+/** Search items by name in all the files. The files that were not shown
+    yet are scanned now, and the page of the first file with a match is
+    shown */
+void Plotter::OnSearch()
+{
+  TString pattern = entry_search->GetText();
+  if(pattern.IsNull()) return;
 
-    if(it->IsPlotable()){
-      Draw();
-      boxes[file]->GetContent()->GetEntry(id)->Activate(false);
-      OnItemClick(id);
+  Int_t first_file = -1;
+  UInt_t n_found = 0;
+  for(UInt_t i=0; i<m_number_of_files; i++){
+    std::vector<Item*> found = m_catalogs[i]->Find(pattern);
+    for(unsigned int k=0; k<found.size(); k++){
+      msg(m_catalogs[i]->GetShortName() << ": " << found[k]->GetFullPath());
     }
+    if(found.size() && first_file < 0) first_file = i;
+    n_found += found.size();
   }
-  else if(btn==3){
-    //for(UInt_t k=0; k<number_of_files; k++){
-      //if(vs[k].size() <= nentry) continue;
 
-      //vs[k][nentry]->SetStatus(true);
+  msg(n_found << " items found matching " << pattern);
 
-    //   v_sel.push_back(vs[k][nentry]);
-    // }
-
-    // RefreshGui();
-  }
+  if(first_file >= 0) ShowPage(first_file / files_per_page);
 }
 
 void Plotter::ShowHideColours()
@@ -19,6 +19,7 @@
 #include <TColor.h>
 #include <TMath.h>
 #include <TGraphAsymmErrors.h>
+#include <TTimer.h>
 
 //GUI
 #include <TApplication.h>
@@ -39,15 +40,20 @@
 #include <TGFileDialog.h>
 #include <TGStatusBar.h>
 #include <TGListTree.h>
+#include <TGComboBox.h>
 
 //plotter
 #include "common.h"
 #include "macro.h"
+#include "efficiency.h"
 
 class Item;
+class Catalog;
 class FileBox;
 class Obj;
 class Plot;
+class ObjectCache;
+struct PlotSpec;
 
 class Plotter : public TGMainFrame {
 
@@ -55,16 +61,32 @@ class Plotter : public TGMainFrame {
   Plotter(std::vector<TString> files, bool merge=false);
   virtual ~Plotter();
 
+  void SetMaxPlots(UInt_t n) { m_max_plots = n; }
+  void SetStatsFile(TString filename) { m_stats_file = filename; }
+  void DrawPair(UInt_t ref_file, UInt_t test_file, TString path);
+  void FillPlot(Plot *p, std::vector<Item*> &items, ObjectCache *prefetched=0);
+  Catalog* GetCatalog(Item* it);
+  TString GetObjectKey(Item* it);
+  Long64_t GetPrefetchSize(Item *it, ObjectCache *cache);
+
   // Slots (must be public!)
-  void OnItemClick(Int_t);
-  void OnItemDoubleClick(TGFrame*, Int_t);
+  void OnItemClick(Long_t item);
+  void OnItemDoubleClick(Long_t item);
   void OnButtonClearSelection() { ClearSelection(); }
   void OnButtonDraw() { Draw(); }
+  void OnButtonDrawPages() { DrawPages(); }
   void OnButtonDrawEfficiency() { DrawEfficiency(); }
   void OnButtonDrawRatio() { DrawRatio(); }
+  void OnButtonSlices() { OpenSlices(); }
   void OnButtonExit() { Exit(); }
+  void OnButtonPrevPage() { ShowPage(m_current_page-1); }
+  void OnButtonNextPage() { ShowPage(m_current_page+1); }
+  void OnSearch();
+  void OnCanvasClosed();
+  void ReleaseClosedPlots();
   void ShowHideColours();
   void ShowHideCuts();
+  void UpdateStatusBar();
 
  private:
   // Gui widgets
@@ -76,10 +98,12 @@ class Plotter : public TGMainFrame {
   TGCompositeFrame *frame_hist3;
   TGCompositeFrame *frame_rebin;
   TGCompositeFrame *frame_log;
+  TGCompositeFrame *frame_interval;
   TGVerticalFrame *frame_column_frame[15];
   TGVerticalFrame *frame_options;
   TGVerticalFrame *frame_colours;
-  TGHorizontalFrame *frame_row[3];
+  TGVerticalFrame *frame_sums;
+  TGHorizontalFrame *frame_pages;
   TGStatusBar *status_bar;
   TGLayoutHints *layout_buttons;
   TGLayoutHints *layout_menu_bar;
@@ -87,21 +111,27 @@ class Plotter : public TGMainFrame {
   TGLayoutHints *layout_checks;
   TGTextButton  *button_clear_selection;
   TGTextButton *button_draw;
+  TGTextButton *button_draw_pages;
   TGTextButton *button_draw_efficiency;
   TGTextButton *button_draw_ratio;
+  TGTextButton *button_slices;
   TGTextButton *button_draw_and_ratio;
   TGTextButton *button_draw_and_diff;
   TGTextButton *button_exit;
   TGTextButton *button_save_colours;
+  TGTextButton *button_prev_page;
+  TGTextButton *button_next_page;
   TGGroupFrame *group_options;
   TGGroupFrame *group_hist_options;
   TGGroupFrame *group_hist2D_options;
   TGGroupFrame *group_colours;
   TGTextEntry  *entry_file[15];
   TGTextEntry  *entry_cuts;
+  TGTextEntry  *entry_search;
   TGLabel *label_rebin;
   TGLabel *label_hist2;
   TGLabel *label_status;
+  TGLabel *label_page;
   TGNumberEntry *nentry_rebin;
   TGCheckButton *check_normalise;
   TGCheckButton *check_normalise2;
@@ -111,6 +141,7 @@ class Plotter : public TGMainFrame {
   TGCheckButton *check_p;
   TGCheckButton *check_box;
   TGCheckButton *check_stats;
+  TGCheckButton *check_io_stats;
   TGCheckButton *check_atlas;
   TGCheckButton *check_log_x;
   TGCheckButton *check_log_y;
@@ -118,6 +149,8 @@ class Plotter : public TGMainFrame {
   TGCheckButton *check_pie;
   TGCheckButton *check_include_diff;
   TGCheckButton *check_include_ratio;
+  TGCheckButton *check_bands;
+  TGComboBox *combo_interval;
   TGRadioButton *radio_colz;
   TGRadioButton *radio_scatter;
   TGRadioButton *radio_box;
@@ -129,10 +162,12 @@ class Plotter : public TGMainFrame {
   TGPopupMenu *menu_view;
   TGColorSelect *colorselect[20];
   TGCheckButton *check_fill[20];
-  FileBox *boxes[15];
+  std::vector<FileBox*> boxes; // only for the pages already shown
 
   void CreateMainWindow();
   void CreateMainFrame();
+  void CreatePage(UInt_t);
+  void ShowPage(UInt_t);
   void CreateOptionsFrame();
   void CreateMenuBar();
   void CreateStatusBar();
@@ -153,7 +188,7 @@ class Plotter : public TGMainFrame {
 
   void ClearSelection();
   void SavePlots();
-  inline void CloseWindow() { gApplication->Terminate(0); }
+  void CloseWindow();
 
   void GetColours();
 
@@ -163,18 +198,42 @@ class Plotter : public TGMainFrame {
   }
 
   void ConfigurePlotList();
-  void Draw();
+  void Draw(bool efficiency=false);
+  void DrawPages();
   void DrawEfficiency();
+  void DrawEfficiencyPairs(UInt_t den_file);
+  void AddPlot(Plot*);
   void DrawRatio();
+  void OpenSlices();
+  void MatchAcrossFiles();
+  void OpenDiff();
+  void OpenBranchCosts();
+  void SumAcrossFiles();
+  void AddSumBox(TString filename);
   std::vector<int> GetNumberOfObjectsInEachFile();
   void CreateMacro(OutputFormat);
+  void SaveSpecs();
+  void RecordMacro(PlotSpec*);
+  void RemoveSpec(TString name);
 
-  Obj* GetObject(Item* it);
+  void RemoveSumFiles();
+  Obj* GetObject(Item* it, ObjectCache *prefetched=0);
+  bool ConfirmSize(Item* it);
 
   UInt_t m_number_of_files;
   std::vector<TString> m_file_names;
+  std::vector<Catalog*> m_catalogs; // files, then sums
+  std::vector<TString> m_sum_files; // temporary, removed at exit
+  std::vector<TGCompositeFrame*> m_pages;
+  UInt_t m_number_of_pages;
+  UInt_t m_current_page;
   std::vector<Item*> m_items;
-  std::vector<Plot*> m_plots;
+  std::vector<Plot*> m_plots;        // open plots, oldest first
+  std::vector<Plot*> m_closed_plots; // canvas closed, to be deleted
+  UInt_t m_max_plots;                // 0: no limit
+  TTimer *m_status_timer;
+  TString m_stats_file; // session stats written here at exit
+  std::vector<PlotSpec*> m_specs; // one for each plot, to save them
   Double_t x_min, x_max, y_min, y_max;
   Pixel_t pcolors[20];
   Color_t colours[20];
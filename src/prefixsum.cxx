@@ -0,0 +1,161 @@
+/** @file prefixsum.cxx
+    @brief PrefixSums class implementation
+*/
+
+#include <cmath>
+
+#include "prefixsum.h"
+#include "common.h"
+
+PrefixSums::PrefixSums(TH1 *h) :
+  m_hist(h),
+  m_dim(h->GetDimension())
+{
+  m_n[0] = h->GetNbinsX();
+  m_n[1] = h->GetNbinsY();
+  m_n[2] = (m_dim == 3) ? h->GetNbinsZ() : 1;
+
+  // index 0 of each axis is the empty sum
+  Int_t size = (m_n[0]+1) * (m_n[1]+1) * (m_n[2]+1);
+  m_sums.assign(size, 0.);
+
+  bool errors = h->GetSumw2N() > 0;
+  if(errors) m_err2.assign(size, 0.);
+
+  for(Int_t k=1; k<=m_n[2]; k++){
+    for(Int_t j=1; j<=m_n[1]; j++){
+      for(Int_t i=1; i<=m_n[0]; i++){
+        Int_t bin = h->GetBin(i, j, m_dim == 3 ? k : 0);
+        m_sums[Index(i, j, k)] = h->GetBinContent(bin);
+        if(errors) m_err2[Index(i, j, k)] = h->GetSumw2()->GetArray()[bin];
+      }
+    }
+  }
+
+  Accumulate(m_sums);
+  if(errors) Accumulate(m_err2);
+}
+
+/** Cumulative sums along each axis, one after the other */
+void PrefixSums::Accumulate(std::vector<Double_t> &sums)
+{
+  const Int_t sx = 1;
+  const Int_t sy = m_n[0]+1;
+  const Int_t sz = (m_n[0]+1) * (m_n[1]+1);
+
+  for(Int_t k=1; k<=m_n[2]; k++)
+    for(Int_t j=1; j<=m_n[1]; j++)
+      for(Int_t i=1; i<=m_n[0]; i++) sums[Index(i, j, k)] += sums[Index(i, j, k) - sx];
+
+  for(Int_t k=1; k<=m_n[2]; k++)
+    for(Int_t j=1; j<=m_n[1]; j++)
+      for(Int_t i=1; i<=m_n[0]; i++) sums[Index(i, j, k)] += sums[Index(i, j, k) - sy];
+
+  for(Int_t k=1; k<=m_n[2]; k++)
+    for(Int_t j=1; j<=m_n[1]; j++)
+      for(Int_t i=1; i<=m_n[0]; i++) sums[Index(i, j, k)] += sums[Index(i, j, k) - sz];
+}
+
+/** Sum over the box by inclusion-exclusion of its 8 corners */
+Double_t PrefixSums::Box(const std::vector<Double_t> &sums, const Int_t *first, const Int_t *last) const
+{
+  if(sums.empty()) return 0.;
+
+  Double_t total = 0.;
+  for(Int_t c=0; c<8; c++){
+    Int_t i = (c & 1) ? last[0] : first[0]-1;
+    Int_t j = (c & 2) ? last[1] : first[1]-1;
+    Int_t k = (c & 4) ? last[2] : first[2]-1;
+    Int_t lower = !(c & 1) + !(c & 2) + !(c & 4);
+    Double_t s = sums[Index(i, j, k)];
+    total += (lower % 2) ? -s : s;
+  }
+  return total;
+}
+
+Double_t PrefixSums::Sum(const Int_t *first, const Int_t *last) const
+{
+  return Box(m_sums, first, last);
+}
+
+/** Sum of the squared errors (0 if the histogram has no sumw2) */
+Double_t PrefixSums::SumErr2(const Int_t *first, const Int_t *last) const
+{
+  return Box(m_err2, first, last);
+}
+
+TAxis* PrefixSums::GetAxis(Int_t axis)
+{
+  if(axis == 0) return m_hist->GetXaxis();
+  if(axis == 1) return m_hist->GetYaxis();
+  return m_hist->GetZaxis();
+}
+
+/** Bin edges of an axis */
+static std::vector<Double_t> axis_edges(TAxis *axis)
+{
+  std::vector<Double_t> edges;
+  for(Int_t i=1; i<=axis->GetNbins(); i++) edges.push_back(axis->GetBinLowEdge(i));
+  edges.push_back(axis->GetBinUpEdge(axis->GetNbins()));
+  return edges;
+}
+
+/** Projection on the axis of the bins in range, in a new histogram
+    owned by the caller */
+TH1D* PrefixSums::Project1D(Int_t axis, const Int_t *first, const Int_t *last)
+{
+  TAxis *a = GetAxis(axis);
+  std::vector<Double_t> edges = axis_edges(a);
+
+  TH1D *h = new TH1D(Form("%s_p%i", m_hist->GetName(), axis), m_hist->GetTitle(), edges.size()-1, &edges[0]);
+  h->SetDirectory(0);
+  h->Sumw2();
+  h->GetXaxis()->SetTitle(a->GetTitle());
+
+  Int_t f[3] = { first[0], first[1], first[2] };
+  Int_t l[3] = { last[0], last[1], last[2] };
+
+  for(Int_t b=first[axis]; b<=last[axis]; b++){
+    f[axis] = l[axis] = b;
+    Double_t sum = Sum(f, l);
+    h->SetBinContent(b, sum);
+    h->SetBinError(b, std::sqrt(m_err2.empty() ? std::fabs(sum) : SumErr2(f, l)));
+  }
+
+  h->GetXaxis()->SetRange(first[axis], last[axis]);
+  h->SetEntries(Sum(first, last));
+
+  return h;
+}
+
+/** Projection on two axes (x and y of the result) */
+TH2D* PrefixSums::Project2D(Int_t axis_x, Int_t axis_y, const Int_t *first, const Int_t *last)
+{
+  TAxis *ax = GetAxis(axis_x);
+  TAxis *ay = GetAxis(axis_y);
+  std::vector<Double_t> ex = axis_edges(ax);
+  std::vector<Double_t> ey = axis_edges(ay);
+
+  TH2D *h = new TH2D(Form("%s_p%i%i", m_hist->GetName(), axis_x, axis_y), m_hist->GetTitle(),
+                     ex.size()-1, &ex[0], ey.size()-1, &ey[0]);
+  h->SetDirectory(0);
+  h->GetXaxis()->SetTitle(ax->GetTitle());
+  h->GetYaxis()->SetTitle(ay->GetTitle());
+
+  Int_t f[3] = { first[0], first[1], first[2] };
+  Int_t l[3] = { last[0], last[1], last[2] };
+
+  for(Int_t by=first[axis_y]; by<=last[axis_y]; by++){
+    f[axis_y] = l[axis_y] = by;
+    for(Int_t bx=first[axis_x]; bx<=last[axis_x]; bx++){
+      f[axis_x] = l[axis_x] = bx;
+      h->SetBinContent(bx, by, Sum(f, l));
+    }
+  }
+
+  h->GetXaxis()->SetRange(first[axis_x], last[axis_x]);
+  h->GetYaxis()->SetRange(first[axis_y], last[axis_y]);
+  h->SetEntries(Sum(first, last));
+
+  return h;
+}
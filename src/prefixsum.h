@@ -0,0 +1,47 @@
+/** @file prefixsum.h
+    @brief Prefix sums of 2D/3D histograms
+*/
+
+#ifndef PREFIXSUM_H
+#define PREFIXSUM_H
+
+#include <vector>
+
+#include <TROOT.h>
+#include <TH1.h>
+#include <TH2.h>
+
+/** Cumulative sums of the contents (and squared errors) of a 2D/3D
+    histogram, without under/overflows. The sum over any range of bins
+    is then 4 (2D) or 8 (3D) lookups, so projections and integrals cost
+    one lookup per output bin whatever the size of the integrated range.
+
+    Ranges are given as first/last bins (inclusive) for each axis, 1 for
+    the z axis of 2D histograms. The histogram is not owned.
+*/
+class PrefixSums {
+
+ public:
+  PrefixSums(TH1 *h);
+
+  Int_t GetDimension() { return m_dim; }
+  Double_t Sum(const Int_t *first, const Int_t *last) const;
+  Double_t SumErr2(const Int_t *first, const Int_t *last) const;
+
+  TH1D* Project1D(Int_t axis, const Int_t *first, const Int_t *last);
+  TH2D* Project2D(Int_t axis_x, Int_t axis_y, const Int_t *first, const Int_t *last);
+
+ private:
+  Int_t Index(Int_t i, Int_t j, Int_t k) const { return (k*(m_n[1]+1) + j)*(m_n[0]+1) + i; }
+  Double_t Box(const std::vector<Double_t> &sums, const Int_t *first, const Int_t *last) const;
+  void Accumulate(std::vector<Double_t> &sums);
+  TAxis* GetAxis(Int_t axis);
+
+  TH1 *m_hist;
+  Int_t m_dim;
+  Int_t m_n[3];
+  std::vector<Double_t> m_sums;
+  std::vector<Double_t> m_err2;
+};
+
+#endif
@@ -0,0 +1,198 @@
+/** @file ratio.cxx
+    @brief Ratios and relative differences of many histograms
+
+    All the ratios (or differences) with respect to the same reference
+    are computed together over the plain bin arrays: the terms of the
+    reference are computed once, and then each histogram is a simple
+    loop without branches that the compiler can vectorise. The results
+    are written directly in the output histograms.
+*/
+
+#include <cmath>
+#include <algorithm>
+
+#include <TArrayD.h>
+#include <TH2.h>
+#include <TH3.h>
+
+#include "common.h"
+#include "ratio.h"
+
+/** For each bin i and histogram k (errors as TH1::Divide, uncorrelated):
+      out[k][i] = num[k][i]/ref[i]  (minus 1 for the differences)
+      out_err2[k][i] = num_err2[k][i]/ref[i]^2 + out[k][i]^2 * ref_err2[i]/ref[i]^2
+    Bins where the reference is 0 are set to 0 */
+void ratio_kernel(const Double_t *ref, const Double_t *ref_err2,
+                  const Double_t *const *num, const Double_t *const *num_err2,
+                  Double_t *const *out, Double_t *const *out_err2,
+                  unsigned int n_hists, unsigned int n_bins, RatioMode mode)
+{
+  // reference terms, shared by all the histograms
+  std::vector<Double_t> inv(n_bins);
+  std::vector<Double_t> rel2(n_bins);
+  for(unsigned int i=0; i<n_bins; i++){
+    Double_t b = (ref[i] != 0.) ? ref[i] : 1.;
+    inv[i]  = (ref[i] != 0.) ? 1./b : 0.;
+    rel2[i] = ref_err2[i] * inv[i] * inv[i];
+  }
+
+  const Double_t offset = (mode == kDifference) ? 1. : 0.;
+  const Double_t *__restrict pinv = &inv[0];
+  const Double_t *__restrict prel2 = &rel2[0];
+
+  for(unsigned int k=0; k<n_hists; k++){
+    const Double_t *__restrict a  = num[k];
+    const Double_t *__restrict a2 = num_err2[k];
+    Double_t *__restrict o  = out[k];
+    Double_t *__restrict o2 = out_err2[k];
+
+    for(unsigned int i=0; i<n_bins; i++){
+      Double_t r = a[i] * pinv[i];
+      o[i]  = (pinv[i] != 0.) ? r - offset : 0.;
+      o2[i] = a2[i] * pinv[i] * pinv[i] + r * r * prel2[i];
+    }
+  }
+}
+
+/** The arrays of a profile hold sums (of w*y, w*y^2), not its contents */
+bool is_profile(TH1 *h)
+{
+  return h->InheritsFrom("TProfile") || h->InheritsFrom("TProfile2D") || h->InheritsFrom("TProfile3D");
+}
+
+/** Contents of all the cells of h. Double histograms are used directly,
+    others (and profiles) are copied to buffer */
+static const Double_t* cells(TH1 *h, std::vector<Double_t> &buffer)
+{
+  TArrayD *array = dynamic_cast<TArrayD*>(h);
+  if(array && !is_profile(h)) return array->GetArray();
+
+  Int_t n = h->GetNcells();
+  buffer.resize(n);
+  for(Int_t i=0; i<n; i++) buffer[i] = h->GetBinContent(i);
+  return &buffer[0];
+}
+
+/** Squared errors of all the cells of h */
+static const Double_t* cells_err2(TH1 *h, std::vector<Double_t> &buffer)
+{
+  bool profile = is_profile(h);
+  if(h->GetSumw2N() > 0 && !profile) return h->GetSumw2()->GetArray();
+
+  // profiles: errors of the means. No sumw2: poisson errors
+  Int_t n = h->GetNcells();
+  buffer.resize(n);
+  for(Int_t i=0; i<n; i++){
+    if(profile) buffer[i] = h->GetBinError(i)*h->GetBinError(i);
+    else buffer[i] = std::fabs(h->GetBinContent(i));
+  }
+  return &buffer[0];
+}
+
+/** Edges of the bins of an axis */
+static std::vector<Double_t> edges(TAxis *axis)
+{
+  std::vector<Double_t> e(axis->GetNbins()+1);
+  for(Int_t i=0; i<axis->GetNbins(); i++) e[i] = axis->GetBinLowEdge(i+1);
+  e[axis->GetNbins()] = axis->GetBinUpEdge(axis->GetNbins());
+  return e;
+}
+
+/** Empty histogram of doubles with the binning of ref and the style of h
+    (a plain histogram also for profiles) */
+static TH1* create_output(TH1 *ref, TH1 *h, TString name)
+{
+  std::vector<Double_t> ex = edges(ref->GetXaxis());
+
+  TH1 *out = 0;
+  if(ref->GetDimension() == 1)
+    out = new TH1D(name, h->GetTitle(), ex.size()-1, &ex[0]);
+  else if(ref->GetDimension() == 2) {
+    std::vector<Double_t> ey = edges(ref->GetYaxis());
+    out = new TH2D(name, h->GetTitle(), ex.size()-1, &ex[0], ey.size()-1, &ey[0]);
+  }
+  else {
+    std::vector<Double_t> ey = edges(ref->GetYaxis());
+    std::vector<Double_t> ez = edges(ref->GetZaxis());
+    out = new TH3D(name, h->GetTitle(), ex.size()-1, &ex[0], ey.size()-1, &ey[0], ez.size()-1, &ez[0]);
+  }
+  out->SetDirectory(0);
+  if(out->GetSumw2N() == 0) out->Sumw2(); // already there with TH1::SetDefaultSumw2
+
+  out->GetXaxis()->SetTitle(ref->GetXaxis()->GetTitle());
+  out->SetLineColor(h->GetLineColor());
+  out->SetLineStyle(h->GetLineStyle());
+  out->SetLineWidth(h->GetLineWidth());
+  out->SetMarkerColor(h->GetMarkerColor());
+  out->SetMarkerStyle(h->GetMarkerStyle());
+  out->SetMarkerSize(h->GetMarkerSize());
+
+  return out;
+}
+
+/** Ratios (or relative differences) of all the histograms with respect
+    to ref, in new histograms owned by the caller (0 for the histograms
+    with different binning) */
+std::vector<TH1*> compute_ratios(TH1 *ref, std::vector<TH1*> hists, RatioMode mode)
+{
+  std::vector<TH1*> outputs(hists.size(), (TH1*)0);
+  if(!ref) return outputs;
+
+  unsigned int n_bins = ref->GetNcells();
+
+  std::vector<Double_t> ref_buffer, ref_err2_buffer;
+  const Double_t *ref_cells = cells(ref, ref_buffer);
+  const Double_t *ref_err2 = cells_err2(ref, ref_err2_buffer);
+
+  std::vector<const Double_t*> num, num_err2;
+  std::vector<Double_t*> out, out_err2;
+  std::vector<unsigned int> index;
+  std::vector<std::vector<Double_t> > buffers(4*hists.size());
+
+  // allocate all the outputs before the loop
+  for(unsigned int k=0; k<hists.size(); k++){
+    TH1 *h = hists[k];
+    if(!h) continue;
+    if((unsigned int)h->GetNcells() != n_bins) {
+      error("Cannot divide " << h->GetName() << " by " << ref->GetName() << ": different number of bins");
+      continue;
+    }
+
+    TH1 *o = create_output(ref, h, Form("%s_%s", h->GetName(), mode == kRatio ? "ratio" : "diff"));
+    outputs[k] = o;
+
+    num.push_back(cells(h, buffers[4*k]));
+    num_err2.push_back(cells_err2(h, buffers[4*k+1]));
+
+    TArrayD *array = dynamic_cast<TArrayD*>(o);
+    if(array) {
+      out.push_back(array->GetArray());
+      out_err2.push_back(o->GetSumw2()->GetArray());
+    }
+    else {
+      buffers[4*k+2].resize(n_bins);
+      buffers[4*k+3].resize(n_bins);
+      out.push_back(&buffers[4*k+2][0]);
+      out_err2.push_back(&buffers[4*k+3][0]);
+    }
+    index.push_back(k);
+  }
+
+  if(index.empty()) return outputs;
+
+  ratio_kernel(ref_cells, ref_err2, &num[0], &num_err2[0], &out[0], &out_err2[0],
+               index.size(), n_bins, mode);
+
+  for(unsigned int j=0; j<index.size(); j++){
+    TH1 *o = outputs[index[j]];
+    if(!dynamic_cast<TArrayD*>(o)) {
+      for(unsigned int i=0; i<n_bins; i++){
+        o->SetBinContent(i, out[j][i]);
+        o->SetBinError(i, std::sqrt(out_err2[j][i]));
+      }
+    }
+    o->SetEntries(hists[index[j]]->GetEntries());
+  }
+
+  return outputs;
+}
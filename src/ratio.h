@@ -0,0 +1,27 @@
+/** @file ratio.h
+    @brief Ratios and relative differences of many histograms
+*/
+
+#ifndef RATIO_H
+#define RATIO_H
+
+#include <vector>
+
+#include <TROOT.h>
+#include <TH1.h>
+
+enum RatioMode {
+  kRatio,      // hN/h1
+  kDifference  // (hN-h1)/h1
+};
+
+void ratio_kernel(const Double_t *ref, const Double_t *ref_err2,
+                  const Double_t *const *num, const Double_t *const *num_err2,
+                  Double_t *const *out, Double_t *const *out_err2,
+                  unsigned int n_hists, unsigned int n_bins, RatioMode mode);
+
+std::vector<TH1*> compute_ratios(TH1 *ref, std::vector<TH1*> hists, RatioMode mode);
+
+bool is_profile(TH1 *h);
+
+#endif
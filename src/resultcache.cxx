@@ -0,0 +1,192 @@
+/** @file resultcache.cxx
+    @brief ResultCache implementation
+*/
+
+#include <ctime>
+#include <utime.h>
+#include <vector>
+#include <algorithm>
+
+#include <TSystem.h>
+#include <TFile.h>
+#include <TDirectory.h>
+#include <TMD5.h>
+#include <TUUID.h>
+
+#include "resultcache.h"
+#include "stats.h"
+#include "trace.h"
+#include "common.h"
+
+static const Long_t max_age = 30*24*3600; // unused entries are removed after a month
+
+ResultCache* ResultCache::Instance()
+{
+  static ResultCache cache;
+  return &cache;
+}
+
+/** 1 GB in $XDG_CACHE_HOME/plotter (or ~/.cache/plotter) */
+ResultCache::ResultCache() :
+  m_dir(""),
+  m_max_size(1073741824),
+  m_size(-1)
+{
+  if(gSystem->Getenv("XDG_CACHE_HOME"))
+    m_dir = TString(gSystem->Getenv("XDG_CACHE_HOME")) + "/plotter";
+  else if(gSystem->HomeDirectory())
+    m_dir = TString(gSystem->HomeDirectory()) + "/.cache/plotter";
+}
+
+/** Name of the entry of a tree draw. The path of the tree and its number
+    of entries are included, the name of the file is not (it may be moved) */
+TString ResultCache::Key(TTree *tree, TString expr, TString cut, TString binning)
+{
+  TString dir = tree->GetDirectory() ? tree->GetDirectory()->GetPath() : "";
+  Ssiz_t colon = dir.Index(":");
+  if(colon >= 0) dir = dir(colon+1, dir.Length());
+
+  TString uuid = tree->GetCurrentFile() ? tree->GetCurrentFile()->GetUUID().AsString() : "";
+
+  TString desc = Form("%s|%s/%s|%lld|%s|%s|%s", uuid.Data(), dir.Data(), tree->GetName(),
+                      tree->GetEntries(), expr.Data(), cut.Data(), binning.Data());
+
+  TMD5 md5;
+  md5.Update((const UChar_t*)desc.Data(), desc.Length());
+  md5.Final();
+  return md5.AsString();
+}
+
+/** The cached histogram (owned by the caller), or 0 */
+TH1* ResultCache::Get(TString key)
+{
+  if(!IsEnabled()) return 0;
+
+  TString path = GetPath(key);
+  if(gSystem->AccessPathName(path)) {
+    Trace::Instance()->Instant("result_miss", "cache", key);
+    return 0;
+  }
+
+  Trace::Instance()->Instant("result_hit", "cache", key);
+  ScopedTimer timer(kStageRead, path);
+
+  TDirectory::TContext ctx(gDirectory);
+  TFile file(path, "read");
+  TH1 *hist = 0;
+  if(!file.IsZombie()) file.GetObject("hist", hist);
+  if(hist) hist->SetDirectory(0);
+  file.Close();
+
+  // broken entry (e.g. the disk was full)
+  if(!hist) {
+    gSystem->Unlink(path);
+    return 0;
+  }
+
+  utime(path, 0); // most recently used
+  return hist;
+}
+
+/** Write the histogram in a new entry. It's written to a temporary file
+    first, so other processes never read a half written entry */
+void ResultCache::Put(TString key, TH1 *hist)
+{
+  if(!IsEnabled() || !hist) return;
+
+  if(gSystem->AccessPathName(m_dir) && gSystem->mkdir(m_dir, kTRUE) != 0) {
+    error("Cannot create the cache directory " << m_dir << ", tree draws won't be cached");
+    m_dir = "";
+    return;
+  }
+
+  TString path = GetPath(key);
+  TString tmp = Form("%s.%i.tmp", path.Data(), gSystem->GetPid());
+  {
+    TDirectory::TContext ctx(gDirectory);
+    TFile file(tmp, "recreate");
+    if(file.IsZombie()) {
+      error("Cannot write " << tmp);
+      return;
+    }
+    file.WriteTObject(hist, "hist");
+    file.Close();
+  }
+
+  if(gSystem->Rename(tmp, path) != 0) {
+    gSystem->Unlink(tmp);
+    return;
+  }
+
+  Long_t id, flags, modtime;
+  Long64_t size = 0;
+  gSystem->GetPathInfo(path, &id, &size, &flags, &modtime);
+
+  if(m_size >= 0) m_size += size;
+  if(m_size < 0 || m_size > m_max_size) Cleanup();
+}
+
+namespace {
+  struct CacheEntry {
+    TString path;
+    Long64_t size;
+    Long_t modtime;
+    bool operator<(const CacheEntry &e) const { return modtime < e.modtime; }
+  };
+}
+
+/** Remove the entries not used for a month, and then the least recently
+    used ones until the cache is under 3/4 of its maximum size */
+void ResultCache::Cleanup()
+{
+  m_size = 0;
+  if(m_dir.IsNull()) return;
+
+  void *dir = gSystem->OpenDirectory(m_dir);
+  if(!dir) return;
+
+  std::vector<CacheEntry> entries;
+  const char *name;
+  while((name = gSystem->GetDirEntry(dir))) {
+    TString file = name;
+    if(!file.EndsWith(".root") && !file.EndsWith(".tmp")) continue;
+
+    CacheEntry e;
+    e.path = m_dir + "/" + file;
+    Long_t id, flags;
+    if(gSystem->GetPathInfo(e.path, &id, &e.size, &flags, &e.modtime) != 0) continue;
+
+    // left by a process that crashed while writing (recent ones may be in use)
+    if(file.EndsWith(".tmp")) {
+      if(time(0) - e.modtime < 3600) continue;
+      e.modtime = 0;
+    }
+
+    entries.push_back(e);
+    m_size += e.size;
+  }
+  gSystem->FreeDirectory(dir);
+
+  std::sort(entries.begin(), entries.end());
+
+  Long_t now = time(0);
+  unsigned int removed = 0;
+  for(unsigned int k=0; k<entries.size(); k++){
+    if(now - entries[k].modtime < max_age && m_size <= m_max_size*3/4) break;
+    if(gSystem->Unlink(entries[k].path) != 0) continue;
+    m_size -= entries[k].size;
+    removed++;
+  }
+
+  if(removed > 0) {
+    msg("Removed " << removed << " entries from the cache of tree draws (" << format_bytes(m_size) << " left)");
+  }
+}
+
+void ResultCache::Clear()
+{
+  Long64_t max_size = m_max_size;
+  m_max_size = 0;
+  Cleanup();
+  m_max_size = max_size;
+}
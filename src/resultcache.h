@@ -0,0 +1,51 @@
+/** @file resultcache.h
+    @brief Persistent cache of filled tree draws
+*/
+
+#ifndef RESULTCACHE_H
+#define RESULTCACHE_H
+
+#include <TROOT.h>
+#include <TString.h>
+#include <TTree.h>
+#include <TH1.h>
+
+/** Histograms filled from trees, kept on disk between sessions.
+
+    Each entry is a small ROOT file in the cache directory
+    ($XDG_CACHE_HOME/plotter or ~/.cache/plotter), named by the md5 of
+    the UUID of the input file, the tree (and its entries), the
+    expression, the selection (which is also the weight) and the
+    binning. A hit updates the modification time of the entry, and when
+    the cache is over its maximum size the entries not used for a month,
+    then the least recently used ones, are removed.
+*/
+class ResultCache {
+
+ public:
+  static ResultCache* Instance();
+
+  TString Key(TTree *tree, TString expr, TString cut, TString binning);
+
+  TH1* Get(TString key);
+  void Put(TString key, TH1 *hist);
+
+  void Cleanup();
+  void Clear();
+
+  void SetMaxSize(Long64_t bytes) { m_max_size = bytes; }
+  Long64_t GetMaxSize() { return m_max_size; }
+  TString GetDir() { return m_dir; }
+  bool IsEnabled() { return m_max_size > 0 && !m_dir.IsNull(); }
+
+ private:
+  ResultCache();
+
+  TString GetPath(TString key) { return m_dir + "/" + key + ".root"; }
+
+  TString m_dir;
+  Long64_t m_max_size;
+  Long64_t m_size; // -1: not known until the first cleanup
+};
+
+#endif
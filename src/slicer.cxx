@@ -0,0 +1,135 @@
+/** @file slicer.cxx
+    @brief SliceView class implementation
+*/
+
+#include <cmath>
+#include <algorithm>
+
+#include <TCanvas.h>
+#include <TGLayout.h>
+
+#include "slicer.h"
+#include "prefixsum.h"
+#include "common.h"
+
+ClassImp(SliceView)
+
+static const char *axis_names[3] = { "x", "y", "z" };
+
+SliceView::SliceView(const TGWindow *p, TH1 *h) :
+  TGMainFrame(p, 700, 700),
+  m_hist(h),
+  m_sums(new PrefixSums(h)),
+  m_projection(0)
+{
+  SetCleanup(kDeepCleanup);
+
+  Int_t dim = h->GetDimension();
+
+  TGHorizontalFrame *frame_projection = new TGHorizontalFrame(this);
+  frame_projection->AddFrame(new TGLabel(frame_projection, "Projection"), new TGLayoutHints(kLHintsLeft, 2, 2, 4, 2));
+  combo_projection = new TGComboBox(frame_projection);
+  combo_projection->AddEntry("x", kProjX);
+  combo_projection->AddEntry("y", kProjY);
+  if(dim == 3) {
+    combo_projection->AddEntry("z", kProjZ);
+    combo_projection->AddEntry("x-y", kProjXY);
+    combo_projection->AddEntry("x-z", kProjXZ);
+    combo_projection->AddEntry("y-z", kProjYZ);
+  }
+  combo_projection->Select(kProjX, kFALSE);
+  combo_projection->Resize(100, 20);
+  combo_projection->Connect("Selected(Int_t)", "SliceView", this, "OnProjectionSelected(Int_t)");
+  frame_projection->AddFrame(combo_projection, new TGLayoutHints(kLHintsLeft, 2, 2, 2, 2));
+  frame_projection->AddFrame(label_integral = new TGLabel(frame_projection, "Integral:"), new TGLayoutHints(kLHintsRight | kLHintsExpandX, 2, 2, 4, 2));
+  AddFrame(frame_projection, new TGLayoutHints(kLHintsExpandX, 2, 2, 2, 2));
+
+  // one slider for each axis, in bin edges (0 to nbins)
+  for(Int_t a=0; a<3; a++){
+    slider_range[a] = 0;
+    label_range[a] = 0;
+    if(a >= dim) continue;
+
+    Int_t n = (a == 0) ? h->GetNbinsX() : (a == 1) ? h->GetNbinsY() : h->GetNbinsZ();
+
+    TGHorizontalFrame *frame_range = new TGHorizontalFrame(this);
+    frame_range->AddFrame(new TGLabel(frame_range, axis_names[a]), new TGLayoutHints(kLHintsLeft, 2, 8, 4, 2));
+    slider_range[a] = new TGDoubleHSlider(frame_range, 400, kDoubleScaleBoth);
+    slider_range[a]->SetRange(0, n);
+    slider_range[a]->SetPosition(0, n);
+    slider_range[a]->Connect("PositionChanged()", "SliceView", this, "OnRangeChanged()");
+    frame_range->AddFrame(slider_range[a], new TGLayoutHints(kLHintsLeft | kLHintsExpandX, 2, 2, 2, 2));
+    frame_range->AddFrame(label_range[a] = new TGLabel(frame_range, "                              "), new TGLayoutHints(kLHintsRight, 2, 2, 4, 2));
+    AddFrame(frame_range, new TGLayoutHints(kLHintsExpandX, 2, 2, 2, 2));
+  }
+
+  ecanvas = new TRootEmbeddedCanvas(Form("%s_slices", h->GetName()), this, 700, 550);
+  AddFrame(ecanvas, new TGLayoutHints(kLHintsExpandX | kLHintsExpandY, 2, 2, 2, 2));
+
+  SetWindowName(Form("Slices of %s", h->GetName()));
+  MapSubwindows();
+  Resize(GetDefaultSize());
+  MapWindow();
+
+  Update();
+}
+
+SliceView::~SliceView()
+{
+  ecanvas->GetCanvas()->Clear();
+  delete m_projection;
+  delete m_sums;
+  delete m_hist;
+  Cleanup();
+}
+
+void SliceView::CloseWindow()
+{
+  DeleteWindow();
+}
+
+/** Projection of the selected ranges */
+void SliceView::Update()
+{
+  Int_t dim = m_sums->GetDimension();
+
+  Int_t first[3] = { 1, 1, 1 };
+  Int_t last[3]  = { 1, 1, 1 };
+
+  for(Int_t a=0; a<dim; a++){
+    Float_t min, max;
+    slider_range[a]->GetPosition(min, max);
+
+    TAxis *axis = (a == 0) ? m_hist->GetXaxis() : (a == 1) ? m_hist->GetYaxis() : m_hist->GetZaxis();
+    first[a] = std::max(Int_t(std::floor(min + 0.5)) + 1, 1);
+    last[a]  = std::min(Int_t(std::floor(max + 0.5)), axis->GetNbins());
+    if(last[a] < first[a]) last[a] = first[a];
+
+    label_range[a]->SetText(Form("[%g, %g]", axis->GetBinLowEdge(first[a]), axis->GetBinUpEdge(last[a])));
+  }
+
+  TCanvas *c = ecanvas->GetCanvas();
+  c->cd();
+  c->Clear();
+
+  delete m_projection;
+  m_projection = 0;
+
+  Int_t projection = combo_projection->GetSelected();
+  if(projection == kProjX || projection == kProjY || projection == kProjZ) {
+    m_projection = m_sums->Project1D(projection, first, last);
+    m_projection->Draw("hist");
+  }
+  else {
+    if(projection == kProjXY)      m_projection = m_sums->Project2D(0, 1, first, last);
+    else if(projection == kProjXZ) m_projection = m_sums->Project2D(0, 2, first, last);
+    else                           m_projection = m_sums->Project2D(1, 2, first, last);
+    m_projection->Draw("colz");
+  }
+
+  label_integral->SetText(Form("Integral: %g", m_sums->Sum(first, last)));
+  Layout();
+
+  c->Modified();
+  c->Update();
+}
@@ -0,0 +1,62 @@
+/** @file slicer.h
+    @brief Slicing window for 2D/3D histograms
+*/
+
+#ifndef SLICER_H
+#define SLICER_H
+
+#include <TROOT.h>
+#include <TH1.h>
+#include <TGFrame.h>
+#include <TGLabel.h>
+#include <TGComboBox.h>
+#include <TGDoubleSlider.h>
+#include <TRootEmbeddedCanvas.h>
+
+class PrefixSums;
+
+enum SliceProjection {
+  kProjX,
+  kProjY,
+  kProjZ,
+  kProjXY,
+  kProjXZ,
+  kProjYZ
+};
+
+/** Window with the projection of a 2D/3D histogram on one or two axes,
+    integrated over the range of bins chosen with a slider for each
+    axis. The projections come from the prefix sums of the histogram,
+    so moving a slider only costs one lookup per shown bin.
+
+    The window owns the histogram and is deleted when it's closed.
+*/
+class SliceView : public TGMainFrame {
+
+ public:
+  SliceView(const TGWindow *p, TH1 *h);
+  virtual ~SliceView();
+
+  virtual void CloseWindow();
+
+  // Slots
+  void OnProjectionSelected(Int_t) { Update(); }
+  void OnRangeChanged() { Update(); }
+
+ private:
+  void Update();
+
+  TH1 *m_hist;
+  PrefixSums *m_sums;
+  TH1 *m_projection;
+
+  TGComboBox *combo_projection;
+  TGDoubleHSlider *slider_range[3];
+  TGLabel *label_range[3];
+  TGLabel *label_integral;
+  TRootEmbeddedCanvas *ecanvas;
+
+  ClassDef(SliceView, 0);
+};
+
+#endif
@@ -0,0 +1,147 @@
+/** @file stats.cxx
+    @brief Stats and ScopedTimer implementation
+*/
+
+#include <fstream>
+
+#include <TSystem.h>
+#include <TDatime.h>
+#include <TFile.h>
+
+#include "stats.h"
+#include "trace.h"
+#include "common.h"
+
+static const char *stage_names[kNStages] = {
+  "file_open", "dir_scan", "object_read", "tree_draw", "plot_configure", "canvas_paint", "export"
+};
+
+static const char *counter_names[kNCounters] = {
+  "files_opened", "objects_read", "entries_processed", "plots"
+};
+
+/** Human readable size */
+TString format_bytes(Long64_t bytes)
+{
+  if(bytes >= 1073741824) return Form("%.2f GB", bytes/1073741824.);
+  if(bytes >= 1048576) return Form("%.1f MB", bytes/1048576.);
+  if(bytes >= 1024) return Form("%.1f kB", bytes/1024.);
+  return Form("%lld B", bytes);
+}
+
+Stats* Stats::Instance()
+{
+  static Stats stats;
+  return &stats;
+}
+
+Stats::Stats()
+{
+  Reset();
+}
+
+void Stats::Reset()
+{
+  for(Int_t k=0; k<kNStages; k++){
+    m_time[k] = 0;
+    m_calls[k] = 0;
+  }
+  for(Int_t k=0; k<kNCounters; k++) m_counts[k] = 0;
+
+  m_bytes_start = TFile::GetFileBytesRead();
+  m_start = Trace::Now();
+}
+
+/** Bytes read from all the files (by ROOT's I/O) since the last reset */
+Long64_t Stats::GetBytesRead()
+{
+  return TFile::GetFileBytesRead() - m_bytes_start;
+}
+
+Double_t Stats::GetElapsed()
+{
+  return Trace::Now() - m_start;
+}
+
+const char* Stats::GetStageName(Int_t stage)
+{
+  return (stage >= 0 && stage < kNStages) ? stage_names[stage] : "";
+}
+
+const char* Stats::GetCounterName(Int_t counter)
+{
+  return (counter >= 0 && counter < kNCounters) ? counter_names[counter] : "";
+}
+
+/** One line, for the status bar */
+TString Stats::GetSummary()
+{
+  return Form("read %s, %lld objects, %lld entries | open %.2f s, scan %.2f s, read %.2f s, tree %.2f s, paint %.2f s",
+              format_bytes(GetBytesRead()).Data(), m_counts[kCountObjectsRead], m_counts[kCountEntries],
+              m_time[kStageOpen], m_time[kStageScan], m_time[kStageRead], m_time[kStageTreeDraw], m_time[kStagePaint]);
+}
+
+/** Table with all the stages and counters */
+TString Stats::GetReport()
+{
+  TString report;
+  report += Form("Session: %.1f s\n\n", GetElapsed());
+  report += Form("%-16s %10s %12s %12s\n", "stage", "calls", "total [s]", "mean [ms]");
+  for(Int_t k=0; k<kNStages; k++){
+    Double_t mean = m_calls[k] ? 1000.*m_time[k]/m_calls[k] : 0.;
+    report += Form("%-16s %10lld %12.3f %12.3f\n", stage_names[k], m_calls[k], m_time[k], mean);
+  }
+  report += "\n";
+  report += Form("%-18s %s\n", "bytes_read", format_bytes(GetBytesRead()).Data());
+  for(Int_t k=0; k<kNCounters; k++){
+    report += Form("%-18s %lld\n", counter_names[k], m_counts[k]);
+  }
+  return report;
+}
+
+/** Dump the session stats as JSON */
+bool Stats::WriteJson(TString filename)
+{
+  std::ofstream out(filename.Data());
+  if(!out) {
+    error("Cannot write " << filename);
+    return false;
+  }
+
+  TDatime date;
+
+  out << "{" << std::endl;
+  out << "  \"session\": { \"date\": \"" << date.AsSQLString() << "\", \"pid\": " << gSystem->GetPid()
+      << ", \"elapsed_s\": " << GetElapsed() << " }," << std::endl;
+
+  out << "  \"counters\": {" << std::endl;
+  out << "    \"bytes_read\": " << GetBytesRead();
+  for(Int_t k=0; k<kNCounters; k++){
+    out << "," << std::endl << "    \"" << counter_names[k] << "\": " << m_counts[k];
+  }
+  out << std::endl << "  }," << std::endl;
+
+  out << "  \"stages\": {" << std::endl;
+  for(Int_t k=0; k<kNStages; k++){
+    out << "    \"" << stage_names[k] << "\": { \"calls\": " << m_calls[k] << ", \"total_s\": " << m_time[k] << " }";
+    out << ((k+1 < kNStages) ? "," : "") << std::endl;
+  }
+  out << "  }" << std::endl;
+  out << "}" << std::endl;
+
+  return true;
+}
+
+ScopedTimer::ScopedTimer(StatStage stage, const char *detail) :
+  m_stage(stage),
+  m_start(Trace::Now())
+{
+  if(detail && Trace::Instance()->IsEnabled()) m_detail = detail;
+}
+
+ScopedTimer::~ScopedTimer()
+{
+  Double_t end = Trace::Now();
+  Stats::Instance()->AddTime(m_stage, end - m_start);
+  Trace::Instance()->Complete(stage_names[m_stage], "stage", m_start, end, m_detail);
+}
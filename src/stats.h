@@ -0,0 +1,81 @@
+/** @file stats.h
+    @brief Timers and counters of the main stages (open, scan, read, draw...)
+*/
+
+#ifndef STATS_H
+#define STATS_H
+
+#include <TROOT.h>
+#include <TString.h>
+
+enum StatStage {
+  kStageOpen,      // TFile::Open
+  kStageScan,      // catalog of a file (includes its open)
+  kStageRead,      // object reads
+  kStageTreeDraw,  // tree draws and loops
+  kStageConfigure, // Plot::Configure
+  kStagePaint,     // canvas painting
+  kStageExport,    // canvas printing
+  kNStages
+};
+
+enum StatCounter {
+  kCountFilesOpened,
+  kCountObjectsRead,
+  kCountEntries,   // tree entries processed
+  kCountPlots,
+  kNCounters
+};
+
+/** Session totals of the time spent in each stage and of some counters.
+    Only what is done in this process is counted (not in the workers) */
+class Stats {
+
+ public:
+  static Stats* Instance();
+
+  void AddTime(StatStage stage, Double_t seconds) { m_time[stage] += seconds; m_calls[stage]++; }
+  void Count(StatCounter counter, Long64_t n=1) { m_counts[counter] += n; }
+  void Reset();
+
+  Double_t GetTime(StatStage stage) { return m_time[stage]; }
+  Long64_t GetCalls(StatStage stage) { return m_calls[stage]; }
+  Long64_t GetCount(StatCounter counter) { return m_counts[counter]; }
+  Long64_t GetBytesRead();
+  Double_t GetElapsed();
+
+  static const char* GetStageName(Int_t stage);
+  static const char* GetCounterName(Int_t counter);
+
+  TString GetSummary();
+  TString GetReport();
+  bool WriteJson(TString filename);
+
+ private:
+  Stats();
+
+  Double_t m_time[kNStages];
+  Long64_t m_calls[kNStages];
+  Long64_t m_counts[kNCounters];
+  Long64_t m_bytes_start;
+  Double_t m_start;
+};
+
+/** Add the time from its creation to its destruction to a stage, and
+    record it in the trace if tracing is enabled (with detail, e.g. the
+    file name, as argument) */
+class ScopedTimer {
+
+ public:
+  ScopedTimer(StatStage stage, const char *detail=0);
+  ~ScopedTimer();
+
+ private:
+  StatStage m_stage;
+  TString m_detail;
+  Double_t m_start;
+};
+
+TString format_bytes(Long64_t bytes);
+
+#endif
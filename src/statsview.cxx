@@ -0,0 +1,89 @@
+/** @file statsview.cxx
+    @brief StatsView class implementation
+*/
+
+#include <TObjArray.h>
+#include <TObjString.h>
+#include <TGButton.h>
+#include <TGLayout.h>
+#include <TGFileDialog.h>
+
+#include "stats.h"
+#include "statsview.h"
+#include "common.h"
+
+ClassImp(StatsView)
+
+StatsView::StatsView(const TGWindow *p) :
+  TGMainFrame(p, 520, 420)
+{
+  SetCleanup(kDeepCleanup);
+
+  text_stats = new TGTextView(this, 520, 380);
+  AddFrame(text_stats, new TGLayoutHints(kLHintsExpandX | kLHintsExpandY, 2, 2, 2, 2));
+
+  TGHorizontalFrame *frame_buttons = new TGHorizontalFrame(this);
+  TGTextButton *button_refresh = new TGTextButton(frame_buttons, "Refresh", 0);
+  TGTextButton *button_reset = new TGTextButton(frame_buttons, "Reset", 0);
+  TGTextButton *button_save = new TGTextButton(frame_buttons, "Save JSON...", 0);
+
+  button_refresh->Connect("Clicked()", "StatsView", this, "OnButtonRefresh()");
+  button_reset->Connect("Clicked()", "StatsView", this, "OnButtonReset()");
+  button_save->Connect("Clicked()", "StatsView", this, "OnButtonSave()");
+
+  frame_buttons->AddFrame(button_refresh, new TGLayoutHints(kLHintsLeft, 2, 2, 2, 2));
+  frame_buttons->AddFrame(button_reset, new TGLayoutHints(kLHintsLeft, 2, 2, 2, 2));
+  frame_buttons->AddFrame(button_save, new TGLayoutHints(kLHintsRight, 2, 2, 2, 2));
+  AddFrame(frame_buttons, new TGLayoutHints(kLHintsExpandX, 2, 2, 2, 2));
+
+  SetWindowName("plotter statistics");
+  MapSubwindows();
+  Resize(GetDefaultSize());
+  MapWindow();
+
+  Refresh();
+}
+
+StatsView::~StatsView()
+{
+  Cleanup();
+}
+
+void StatsView::CloseWindow()
+{
+  DeleteWindow();
+}
+
+void StatsView::Refresh()
+{
+  text_stats->Clear();
+
+  TObjArray *lines = Stats::Instance()->GetReport().Tokenize("\n");
+  for(Int_t k=0; k<lines->GetEntriesFast(); k++){
+    text_stats->AddLine(((TObjString*)lines->At(k))->GetString());
+  }
+  delete lines;
+
+  text_stats->Update();
+}
+
+void StatsView::OnButtonReset()
+{
+  Stats::Instance()->Reset();
+  Refresh();
+}
+
+void StatsView::OnButtonSave()
+{
+  static TString dir(".");
+  TGFileInfo fi;
+  fi.fIniDir = StrDup(dir);
+  new TGFileDialog(fClient->GetRoot(), this, kFDSave, &fi);
+  if(!fi.fFilename) return;
+  dir = fi.fIniDir;
+
+  TString filename = fi.fFilename;
+  if(!filename.EndsWith(".json")) filename += ".json";
+
+  if(Stats::Instance()->WriteJson(filename)) msg("Stats saved in " << filename);
+}
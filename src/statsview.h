@@ -0,0 +1,38 @@
+/** @file statsview.h
+    @brief Window with the session stats
+*/
+
+#ifndef STATSVIEW_H
+#define STATSVIEW_H
+
+#include <TROOT.h>
+#include <TGFrame.h>
+#include <TGTextView.h>
+
+/** Table of the time spent in each stage and the counters of the
+    session, that can be refreshed, reset or saved as JSON.
+
+    The window is deleted when it's closed.
+*/
+class StatsView : public TGMainFrame {
+
+ public:
+  StatsView(const TGWindow *p);
+  virtual ~StatsView();
+
+  virtual void CloseWindow();
+
+  // Slots
+  void OnButtonRefresh() { Refresh(); }
+  void OnButtonReset();
+  void OnButtonSave();
+
+ private:
+  void Refresh();
+
+  TGTextView *text_stats;
+
+  ClassDef(StatsView, 0);
+};
+
+#endif
@@ -0,0 +1,197 @@
+/** @file sum.cxx
+    @brief Summer class implementation
+*/
+
+#include <TSystem.h>
+#include <TDirectory.h>
+#include <TFile.h>
+
+#include "filepool.h"
+#include "workers.h"
+#include "sum.h"
+#include "common.h"
+
+Summer::Summer(std::vector<TString> filenames, std::vector<TString> paths) :
+  m_filenames(filenames),
+  m_paths(paths),
+  m_sums(paths.size(), (TH1*)0),
+  m_parent(0)
+{
+}
+
+Summer::~Summer()
+{
+  for(unsigned int k=0; k<m_sums.size(); k++) delete m_sums[k];
+}
+
+TString Summer::GetWorkerFile(unsigned int worker)
+{
+  return Form("%s/plotter_sum_%i_%u.root", gSystem->TempDirectory(), (int)m_parent, worker);
+}
+
+/** Add h to the sum k, taking it if it's the first one. Returns false
+    (and h is deleted) if it cannot be added */
+bool Summer::AddTo(unsigned int k, TH1 *h, TString from)
+{
+  h->SetDirectory(0);
+
+  if(!m_sums[k]) {
+    m_sums[k] = h;
+    return true;
+  }
+
+  bool added = m_sums[k]->Add(h);
+  if(!added) error("Cannot add " << m_paths[k] << " from " << from << ": different binning");
+  delete h;
+  return added;
+}
+
+/** Sum all the histograms. Returns false (and there are no sums) if
+    some of the files were not added */
+bool Summer::Run(unsigned int jobs)
+{
+  unsigned int n_workers = std::max(1u, std::min(jobs, (unsigned int)m_filenames.size()));
+
+  // workers can't share the open files
+  FilePool::Instance()->CloseAll();
+
+  m_parent = getpid();
+  bool complete = (fork_workers(n_workers, RunWorker, this) == 0);
+
+  // second level of the reduction: add the partial sums of the workers
+  if(n_workers > 1) {
+    for(unsigned int w=0; w<n_workers; w++){
+      TString filename = GetWorkerFile(w);
+
+      TDirectory::TContext ctx(gDirectory);
+      TFile *file = TFile::Open(filename);
+      if(!file || file->IsZombie()) {
+        TString files = "";
+        for(unsigned int f=w; f<m_filenames.size(); f+=n_workers) files += " " + m_filenames[f];
+        error("Cannot read the sums of worker " << w << ", with the files" << files);
+        delete file;
+        complete = false;
+        continue;
+      }
+
+      for(unsigned int k=0; k<m_paths.size(); k++){
+        TH1 *h = (TH1*)file->Get(Form("s%u", k));
+        if(h) AddTo(k, h, filename);
+      }
+
+      file->Close();
+      delete file;
+      gSystem->Unlink(filename);
+    }
+  }
+
+  if(!complete) {
+    error("The sums are incomplete: some files were not added");
+    for(unsigned int k=0; k<m_sums.size(); k++){
+      delete m_sums[k];
+      m_sums[k] = 0;
+    }
+    return false;
+  }
+
+  return true;
+}
+
+/** Number of histograms found in the files */
+unsigned int Summer::GetNSums()
+{
+  unsigned int n = 0;
+  for(unsigned int k=0; k<m_sums.size(); k++){
+    if(m_sums[k]) n++;
+  }
+  return n;
+}
+
+/** Each worker adds the files worker, worker+n_workers, ... When run in
+    the parent process the sums are kept directly. Fails if a file cannot
+    be opened or the sums cannot be written */
+bool Summer::RunWorker(unsigned int worker, unsigned int n_workers, void *data)
+{
+  Summer *s = (Summer*)data;
+  bool forked = (getpid() != s->m_parent);
+
+  TDirectory::TContext ctx(gDirectory);
+
+  bool ok = true;
+  for(unsigned int f=worker; f<s->m_filenames.size(); f+=n_workers){
+    TFile *in = TFile::Open(s->m_filenames[f]);
+    if(!in || in->IsZombie()) {
+      error("Cannot open file " << s->m_filenames[f]);
+      delete in;
+      ok = false;
+      continue;
+    }
+
+    for(unsigned int k=0; k<s->m_paths.size(); k++){
+      TObject *obj = in->Get(s->m_paths[k]);
+      if(!obj) continue;
+      if(!obj->InheritsFrom("TH1")) {
+        error("Cannot add " << s->m_paths[k] << ": not a histogram");
+        delete obj;
+        continue;
+      }
+      s->AddTo(k, (TH1*)obj, s->m_filenames[f]);
+    }
+
+    in->Close();
+    delete in;
+  }
+
+  if(!forked) return ok;
+
+  TFile *out = TFile::Open(s->GetWorkerFile(worker), "recreate", "", 0);
+  if(!out) {
+    error("Cannot create " << s->GetWorkerFile(worker));
+    return false;
+  }
+  for(unsigned int k=0; k<s->m_sums.size(); k++){
+    if(s->m_sums[k]) out->WriteTObject(s->m_sums[k], Form("s%u", k));
+  }
+  out->Close();
+  delete out;
+  return ok;
+}
+
+/** Write the sums to a file, with the same directories as the inputs */
+bool Summer::Write(TString filename)
+{
+  TDirectory::TContext ctx(gDirectory);
+
+  TFile *out = TFile::Open(filename, "recreate");
+  if(!out || out->IsZombie()) {
+    error("Cannot create " << filename);
+    delete out;
+    return false;
+  }
+
+  for(unsigned int k=0; k<m_sums.size(); k++){
+    if(!m_sums[k]) continue;
+
+    TString path = m_paths[k];
+    TString name = path;
+    TDirectory *dir = out;
+    Ssiz_t pos = path.Last('/');
+    if(pos >= 0) {
+      name = path(pos+1, path.Length());
+
+      TObjArray *dirs = TString(path(0, pos)).Tokenize("/");
+      for(Int_t d=0; d<dirs->GetEntriesFast(); d++){
+        TString dir_name = dirs->At(d)->GetName();
+        TDirectory *sub = dir->GetDirectory(dir_name);
+        dir = sub ? sub : dir->mkdir(dir_name);
+      }
+      delete dirs;
+    }
+
+    dir->WriteTObject(m_sums[k], name);
+  }
+
+  out->Close();
+  delete out;
+  return true;
+}
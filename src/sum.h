@@ -0,0 +1,45 @@
+/** @file sum.h
+    @brief Sum of the histograms with the same path in many files
+*/
+
+#ifndef SUM_H
+#define SUM_H
+
+#include <vector>
+#include <unistd.h>
+
+#include <TROOT.h>
+#include <TString.h>
+#include <TH1.h>
+
+/** Sum of each of the given histograms (full paths) over all the files,
+    like hadd. The files are split between several worker processes, each
+    one adds its files and writes its partial sums to a temporary file,
+    and the partial sums are added at the end. If a file or the sums of a
+    worker cannot be read, the sum fails.
+*/
+class Summer {
+
+ public:
+  Summer(std::vector<TString> filenames, std::vector<TString> paths);
+  ~Summer();
+
+  bool Run(unsigned int jobs);
+  bool Write(TString filename);
+
+  unsigned int GetN() { return m_paths.size(); }
+  unsigned int GetNSums();
+  TH1* GetSum(unsigned int k) { return m_sums[k]; }
+
+ private:
+  static bool RunWorker(unsigned int, unsigned int, void*);
+  TString GetWorkerFile(unsigned int worker);
+  bool AddTo(unsigned int k, TH1 *h, TString from);
+
+  std::vector<TString> m_filenames;
+  std::vector<TString> m_paths;
+  std::vector<TH1*> m_sums; // owned
+  pid_t m_parent;
+};
+
+#endif
@@ -0,0 +1,149 @@
+/** @file trace.cxx
+    @brief Trace and ScopedTrace implementation
+*/
+
+#include <chrono>
+#include <fstream>
+#include <unistd.h>
+
+#include <TSystem.h>
+
+#include "trace.h"
+#include "common.h"
+
+/** Escape a string for JSON */
+static std::string escape(const char *s)
+{
+  std::string out;
+  for(; s && *s; s++){
+    if(*s == '"' || *s == '\\') out += '\\';
+    if((unsigned char)*s < 0x20) continue;
+    out += *s;
+  }
+  return out;
+}
+
+Trace* Trace::Instance()
+{
+  static Trace trace;
+  return &trace;
+}
+
+/** Seconds from an arbitrary origin, with a monotonic clock (the same for
+    all the processes) */
+Double_t Trace::Now()
+{
+  return std::chrono::duration<Double_t>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+Trace::Trace() :
+  m_enabled(false)
+{
+}
+
+void Trace::Enable(TString filename)
+{
+  m_enabled = !filename.IsNull();
+  m_filename = filename;
+  m_events.clear();
+  if(m_enabled) AddThreadName("plotter");
+}
+
+void Trace::AddEvent(const char *ph, const char *name, const char *cat, Double_t ts, Double_t dur, const char *detail)
+{
+  int pid = getpid();
+
+  TString event = Form("{\"name\": \"%s\", \"cat\": \"%s\", \"ph\": \"%s\", \"ts\": %.3f, ",
+                       escape(name).c_str(), escape(cat).c_str(), ph, ts*1e6);
+  if(ph[0] == 'X') event += Form("\"dur\": %.3f, ", dur*1e6);
+  if(ph[0] == 'i') event += "\"s\": \"t\", ";
+  event += Form("\"pid\": %i, \"tid\": %i", pid, pid);
+  if(detail && detail[0]) event += Form(", \"args\": {\"detail\": \"%s\"}", escape(detail).c_str());
+  event += "}";
+
+  m_events.push_back(event.Data());
+}
+
+void Trace::AddThreadName(const char *name)
+{
+  int pid = getpid();
+  m_events.push_back(Form("{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": %i, \"tid\": %i, \"args\": {\"name\": \"%s\"}}",
+                          pid, pid, escape(name).c_str()));
+}
+
+void Trace::Complete(const char *name, const char *cat, Double_t start, Double_t end, const char *detail)
+{
+  if(!m_enabled) return;
+  AddEvent("X", name, cat, start, end-start, detail);
+}
+
+void Trace::Instant(const char *name, const char *cat, const char *detail)
+{
+  if(!m_enabled) return;
+  AddEvent("i", name, cat, Now(), 0, detail);
+}
+
+/** In a forked worker: drop the events inherited from the parent */
+void Trace::StartWorker(unsigned int worker)
+{
+  if(!m_enabled) return;
+  m_events.clear();
+  AddThreadName(Form("worker %u", worker));
+}
+
+/** In a forked worker: leave the events for the parent */
+void Trace::EndWorker()
+{
+  if(!m_enabled) return;
+
+  std::ofstream out(GetWorkerFile(getpid()).Data());
+  for(unsigned int k=0; k<m_events.size(); k++) out << m_events[k] << std::endl;
+}
+
+/** Add the events of a finished worker */
+void Trace::MergeWorker(int pid)
+{
+  if(!m_enabled) return;
+
+  TString filename = GetWorkerFile(pid);
+  std::ifstream in(filename.Data());
+  std::string line;
+  while(std::getline(in, line)){
+    if(!line.empty()) m_events.push_back(line);
+  }
+  in.close();
+  gSystem->Unlink(filename);
+}
+
+bool Trace::Write()
+{
+  if(!m_enabled) return false;
+
+  std::ofstream out(m_filename.Data());
+  if(!out) {
+    error("Cannot write " << m_filename);
+    return false;
+  }
+
+  out << "{\"traceEvents\": [" << std::endl;
+  for(unsigned int k=0; k<m_events.size(); k++){
+    out << m_events[k] << ((k+1 < m_events.size()) ? "," : "") << std::endl;
+  }
+  out << "], \"displayTimeUnit\": \"ms\"}" << std::endl;
+
+  msg("Trace written to " << m_filename << " (" << m_events.size() << " events)");
+  return true;
+}
+
+ScopedTrace::ScopedTrace(const char *name, const char *cat, const char *detail) :
+  m_name(name),
+  m_cat(cat),
+  m_detail(detail),
+  m_start(Trace::Now())
+{
+}
+
+ScopedTrace::~ScopedTrace()
+{
+  Trace::Instance()->Complete(m_name, m_cat, m_start, Trace::Now(), m_detail);
+}
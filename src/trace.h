@@ -0,0 +1,66 @@
+/** @file trace.h
+    @brief Chrome trace event recording of the plotting pipeline
+*/
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <string>
+#include <vector>
+
+#include <TROOT.h>
+#include <TString.h>
+
+/** Opt-in recording of begin/end events (the stages of ScopedTimer and a
+    few others), written at exit as a Chrome trace-event JSON file that
+    can be opened in Perfetto or chrome://tracing.
+
+    Each process is a track: forked workers record their own events,
+    write them to a side file when they finish and the parent merges
+    them after waiting for the workers.
+*/
+class Trace {
+
+ public:
+  static Trace* Instance();
+  static Double_t Now();
+
+  void Enable(TString filename);
+  bool IsEnabled() { return m_enabled; }
+
+  void Complete(const char *name, const char *cat, Double_t start, Double_t end, const char *detail=0);
+  void Instant(const char *name, const char *cat, const char *detail=0);
+
+  void StartWorker(unsigned int worker);
+  void EndWorker();
+  void MergeWorker(int pid);
+
+  bool Write();
+
+ private:
+  Trace();
+
+  TString GetWorkerFile(int pid) { return Form("%s.%i", m_filename.Data(), pid); }
+  void AddEvent(const char *ph, const char *name, const char *cat, Double_t ts, Double_t dur, const char *detail);
+  void AddThreadName(const char *name);
+
+  bool m_enabled;
+  TString m_filename;
+  std::vector<std::string> m_events; // one JSON object each
+};
+
+/** Event from its creation to its destruction (if tracing is enabled) */
+class ScopedTrace {
+
+ public:
+  ScopedTrace(const char *name, const char *cat, const char *detail=0);
+  ~ScopedTrace();
+
+ private:
+  const char *m_name;
+  const char *m_cat;
+  TString m_detail;
+  Double_t m_start;
+};
+
+#endif
@@ -0,0 +1,211 @@
+/** @file treeloop.cxx
+    @brief TreeLoop class implementation
+*/
+
+#include <algorithm>
+
+#include <TObjArray.h>
+#include <TObjString.h>
+#include <TH2.h>
+
+#include "common.h"
+#include "treeloop.h"
+#include "stats.h"
+
+/** Split "y:x" in its parts (but not "a::b") */
+static std::vector<TString> split_expression(TString expr)
+{
+  std::vector<TString> parts;
+  TString part = "";
+  for(Int_t k=0; k<expr.Length(); k++){
+    if(expr[k] == ':' && (k+1 >= expr.Length() || expr[k+1] != ':') && (k == 0 || expr[k-1] != ':')){
+      parts.push_back(part);
+      part = "";
+    }
+    else part += expr[k];
+  }
+  parts.push_back(part);
+  return parts;
+}
+
+TreeLoop::TreeLoop(TTree *tree) :
+  m_tree(tree)
+{
+}
+
+TreeLoop::~TreeLoop()
+{
+  for(unsigned int k=0; k<m_formulas.size(); k++) delete m_formulas[k];
+}
+
+TH1* TreeLoop::CreateHist(TString expr, TString binning, bool is2D)
+{
+  static int counter = 0;
+  TString name = Form("h_loop_%i", counter++);
+
+  std::vector<Double_t> b;
+  TObjArray *tokens = binning.Tokenize(",");
+  for(Int_t k=0; k<tokens->GetEntriesFast(); k++){
+    b.push_back(((TObjString*)tokens->At(k))->GetString().Atof());
+  }
+  delete tokens;
+
+  // default: 100 bins and automatic range, as TTree::Draw
+  if(is2D && b.size() < 6) {
+    b.assign(6, 0.);
+    b[0] = b[3] = 100;
+  }
+  else if(!is2D && b.size() < 3) {
+    b.assign(3, 0.);
+    b[0] = 100;
+  }
+
+  TH1 *h = 0;
+  if(is2D) {
+    h = new TH2D(name, expr, int(b[0]), b[1], b[2], int(b[3]), b[4], b[5]);
+    if(b[1] >= b[2] || b[4] >= b[5]) h->SetBuffer(1000);
+  }
+  else {
+    h = new TH1D(name, expr, int(b[0]), b[1], b[2]);
+    if(b[1] >= b[2]) h->SetBuffer(1000);
+  }
+  h->SetDirectory(0);
+
+  return h;
+}
+
+/** Add a draw to the loop. The returned histogram is filled by Run and
+    then owned by the caller */
+TH1* TreeLoop::Add(TString expr, TString cut, TString binning)
+{
+  std::vector<TString> parts = split_expression(expr);
+  if(parts.size() > 2) {
+    error("Only 1D and 2D expressions can be drawn: " << expr);
+    return 0;
+  }
+
+  Draw d;
+  d.y = 0;
+  d.cut = 0;
+
+  if(parts.size() == 2) {
+    d.y = new TTreeFormula("y", parts[0], m_tree);
+    d.x = new TTreeFormula("x", parts[1], m_tree);
+    m_formulas.push_back(d.y);
+  }
+  else {
+    d.x = new TTreeFormula("x", parts[0], m_tree);
+  }
+  m_formulas.push_back(d.x);
+
+  if(d.x->GetNdim() == 0 || (d.y && d.y->GetNdim() == 0)) {
+    error("Cannot compile expression " << expr);
+    return 0;
+  }
+
+  if(!cut.IsNull()) {
+    std::map<TString, TTreeFormula*>::iterator it = m_cuts.find(cut);
+    if(it != m_cuts.end()) {
+      d.cut = it->second;
+    }
+    else {
+      d.cut = new TTreeFormula("cut", cut, m_tree);
+      if(d.cut->GetNdim() == 0) {
+        error("Cannot compile selection " << cut);
+        delete d.cut;
+        return 0;
+      }
+      m_cuts[cut] = d.cut;
+      m_formulas.push_back(d.cut);
+    }
+  }
+
+  d.hist = CreateHist(expr, binning, parts.size() == 2);
+  if(d.cut) d.hist->Sumw2();
+
+  m_draws.push_back(d);
+
+  return d.hist;
+}
+
+void TreeLoop::UpdateFormulas()
+{
+  for(unsigned int k=0; k<m_formulas.size(); k++) m_formulas[k]->UpdateFormulaLeaves();
+}
+
+/** Loop over the tree once, filling all the histograms.
+    Returns the number of entries processed */
+Long64_t TreeLoop::Run()
+{
+  if(m_draws.empty()) return 0;
+
+  ScopedTimer timer(kStageTreeDraw, m_tree->GetName());
+
+  // index of the selection of each draw, so each selection is evaluated
+  // only once per entry
+  std::vector<TTreeFormula*> cuts;
+  std::vector<int> cut_index(m_draws.size(), -1);
+  for(unsigned int k=0; k<m_draws.size(); k++){
+    if(!m_draws[k].cut) continue;
+    for(unsigned int c=0; c<cuts.size(); c++){
+      if(cuts[c] == m_draws[k].cut) cut_index[k] = c;
+    }
+    if(cut_index[k] < 0) {
+      cut_index[k] = cuts.size();
+      cuts.push_back(m_draws[k].cut);
+    }
+  }
+  std::vector<Int_t> cut_ndata(cuts.size());
+  std::vector<Double_t> cut_value(cuts.size());
+
+  Long64_t n_entries = m_tree->GetEntries();
+  Int_t tree_number = -1;
+  Long64_t entry = 0;
+
+  for(entry=0; entry<n_entries; entry++){
+    if(m_tree->LoadTree(entry) < 0) break;
+
+    if(m_tree->GetTreeNumber() != tree_number) {
+      tree_number = m_tree->GetTreeNumber();
+      UpdateFormulas();
+    }
+
+    for(unsigned int c=0; c<cuts.size(); c++){
+      cut_ndata[c] = cuts[c]->GetNdata();
+      cut_value[c] = cut_ndata[c] > 0 ? cuts[c]->EvalInstance(0) : 0.;
+    }
+
+    for(unsigned int k=0; k<m_draws.size(); k++){
+      Draw &d = m_draws[k];
+      int c = cut_index[k];
+
+      // scalar selection: skip the entry without reading the variables
+      if(c >= 0 && cut_ndata[c] == 1 && cut_value[c] == 0.) continue;
+      if(c >= 0 && cut_ndata[c] == 0) continue;
+
+      Int_t ndata = d.x->GetNdata();
+      if(d.y) ndata = std::min(ndata, d.y->GetNdata());
+
+      for(Int_t i=0; i<ndata; i++){
+        Double_t w = 1.;
+        if(c >= 0) {
+          if(cut_ndata[c] == 1) w = cut_value[c];
+          else if(i < cut_ndata[c]) w = d.cut->EvalInstance(i);
+          else w = 0.;
+          if(w == 0.) continue;
+        }
+
+        if(d.y) ((TH2*)d.hist)->Fill(d.x->EvalInstance(i), d.y->EvalInstance(i), w);
+        else    d.hist->Fill(d.x->EvalInstance(i), w);
+      }
+    }
+  }
+
+  for(unsigned int k=0; k<m_draws.size(); k++){
+    m_draws[k].hist->BufferEmpty(1);
+  }
+
+  Stats::Instance()->Count(kCountEntries, entry);
+
+  return entry;
+}
@@ -0,0 +1,52 @@
+/** @file treeloop.h
+    @brief Header file for the tree loop
+*/
+
+#ifndef TREELOOP_H
+#define TREELOOP_H
+
+#include <vector>
+#include <map>
+
+#include <TROOT.h>
+#include <TString.h>
+#include <TTree.h>
+#include <TTreeFormula.h>
+#include <TH1.h>
+
+/** Fill many histograms from the same tree in a single loop.
+
+    Each draw is an expression ("x" or "y:x"), a selection (used as
+    weight, as in TTree::Draw) and a binning ("nbins,min,max" or
+    "nx,xmin,xmax,ny,ymin,ymax"; automatic range if empty). Draws
+    sharing the same selection evaluate it only once per entry.
+*/
+class TreeLoop {
+
+ public:
+  TreeLoop(TTree *tree);
+  ~TreeLoop();
+
+  TH1* Add(TString expr, TString cut="", TString binning="");
+  Long64_t Run();
+
+  unsigned int GetN() { return m_draws.size(); }
+
+ private:
+  struct Draw {
+    TTreeFormula *x;
+    TTreeFormula *y;
+    TTreeFormula *cut;
+    TH1 *hist;
+  };
+
+  TH1* CreateHist(TString expr, TString binning, bool is2D);
+  void UpdateFormulas();
+
+  TTree *m_tree;
+  std::vector<Draw> m_draws;
+  std::map<TString, TTreeFormula*> m_cuts;
+  std::vector<TTreeFormula*> m_formulas;
+};
+
+#endif
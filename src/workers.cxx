@@ -0,0 +1,161 @@
+/** @file workers.cxx
+    @brief Helpers to run work in parallel processes
+*/
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <cstdio>
+#include <cerrno>
+#include <vector>
+
+#include <TROOT.h>
+
+#include "common.h"
+#include "workers.h"
+#include "trace.h"
+
+unsigned int number_of_cores()
+{
+  long n = sysconf(_SC_NPROCESSORS_ONLN);
+  return (n > 0) ? n : 1;
+}
+
+/** Run work in n_workers forked processes and wait for all of them.
+    ROOT graphics and I/O are not thread safe, but separate processes
+    can render and write at the same time. Files must not be open in the
+    parent when forking (they would share the file offsets).
+    Returns the number of workers that failed (the child of a failed
+    worker exits with status 1) */
+int fork_workers(unsigned int n_workers, WorkFunction work, void *data)
+{
+  if(n_workers <= 1) return work(0, 1, data) ? 0 : 1;
+
+  ScopedTrace trace("fork_workers", "parallel", Form("%u workers", n_workers));
+
+  fflush(stdout);
+  fflush(stderr);
+
+  int failed = 0;
+  std::vector<pid_t> pids;
+  for(unsigned int w=0; w<n_workers; w++){
+    pid_t pid = fork();
+    if(pid < 0) {
+      error("Cannot fork worker " << w << ", running it in this process");
+      if(!work(w, n_workers, data)) failed++;
+      continue;
+    }
+    if(pid == 0) {
+      Trace::Instance()->StartWorker(w);
+      bool ok = true;
+      {
+        ScopedTrace worker_trace("worker", "parallel");
+        ok = work(w, n_workers, data);
+      }
+      Trace::Instance()->EndWorker();
+      fflush(stdout);
+      fflush(stderr);
+      _exit(ok ? 0 : 1);
+    }
+    pids.push_back(pid);
+  }
+
+  for(unsigned int k=0; k<pids.size(); k++){
+    int status = 0;
+    if(waitpid(pids[k], &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+      failed++;
+    Trace::Instance()->MergeWorker(pids[k]);
+  }
+
+  return failed;
+}
+
+/** Start n_workers forked processes in the background, each with a pipe
+    to send its results to the parent, which reads them (without
+    blocking) with read_pipe_worker. The workers must not touch the
+    graphics, and files must not be open in the parent */
+std::vector<PipeWorker> start_pipe_workers(unsigned int n_workers, PipeWorkFunction work, void *data)
+{
+  fflush(stdout);
+  fflush(stderr);
+
+  std::vector<PipeWorker> workers;
+  for(unsigned int w=0; w<n_workers; w++){
+    int fds[2];
+    if(pipe(fds) != 0) {
+      error("Cannot create the pipe of worker " << w);
+      continue;
+    }
+
+    pid_t pid = fork();
+    if(pid < 0) {
+      error("Cannot fork worker " << w);
+      close(fds[0]);
+      close(fds[1]);
+      continue;
+    }
+    if(pid == 0) {
+      close(fds[0]);
+      Trace::Instance()->StartWorker(w);
+      bool ok = true;
+      {
+        ScopedTrace worker_trace("worker", "parallel");
+        ok = work(w, n_workers, fds[1], data);
+      }
+      Trace::Instance()->EndWorker();
+      close(fds[1]);
+      fflush(stdout);
+      fflush(stderr);
+      _exit(ok ? 0 : 1);
+    }
+
+    close(fds[1]);
+    fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+
+    PipeWorker worker = { pid, fds[0] };
+    workers.push_back(worker);
+  }
+
+  return workers;
+}
+
+/** Append what the worker has sent so far to data. Returns false when
+    the worker has finished (and has been waited for), with an error if
+    it failed */
+bool read_pipe_worker(PipeWorker &worker, std::string &data)
+{
+  if(worker.fd < 0) return false;
+
+  char buffer[65536];
+  while(true){
+    ssize_t n = read(worker.fd, buffer, sizeof(buffer));
+    if(n > 0) {
+      data.append(buffer, n);
+      continue;
+    }
+    if(n < 0 && errno == EINTR) continue;
+    if(n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return true;
+    break; // end of file or error
+  }
+
+  close(worker.fd);
+  worker.fd = -1;
+  int status = 0;
+  if(waitpid(worker.pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+    error("Worker " << worker.pid << " failed");
+  Trace::Instance()->MergeWorker(worker.pid);
+  return false;
+}
+
+/** Kill a worker that has not finished */
+void stop_pipe_worker(PipeWorker &worker)
+{
+  if(worker.fd < 0) return;
+
+  kill(worker.pid, SIGKILL);
+  close(worker.fd);
+  worker.fd = -1;
+  int status = 0;
+  waitpid(worker.pid, &status, 0);
+}
@@ -0,0 +1,33 @@
+/** @file workers.h
+    @brief Helpers to run work in parallel processes
+*/
+
+#ifndef WORKERS_H
+#define WORKERS_H
+
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+/** Function run by each worker: (worker index, number of workers, data).
+    Returns false if some of its work failed */
+typedef bool (*WorkFunction)(unsigned int, unsigned int, void*);
+
+/** Function run by each background worker: (worker index, number of
+    workers, write end of its pipe, data). Returns false if it failed */
+typedef bool (*PipeWorkFunction)(unsigned int, unsigned int, int, void*);
+
+/** A worker running in the background, sending its results through a pipe */
+struct PipeWorker {
+  pid_t pid;
+  int fd; // read end of the pipe (non-blocking), -1 when finished
+};
+
+unsigned int number_of_cores();
+int fork_workers(unsigned int n_workers, WorkFunction work, void *data);
+
+std::vector<PipeWorker> start_pipe_workers(unsigned int n_workers, PipeWorkFunction work, void *data);
+bool read_pipe_worker(PipeWorker &worker, std::string &data);
+void stop_pipe_worker(PipeWorker &worker);
+
+#endif